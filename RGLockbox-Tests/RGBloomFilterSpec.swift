@@ -0,0 +1,88 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+class RGBloomFilterSpec : XCTestCase {
+    
+    func testEmptyFilter() {
+        let filter = RGBloomFilter(capacity: 100)
+        XCTAssert(!filter.mayContain("abcd"))
+        XCTAssert(filter.count == 0)
+    }
+    
+    func testNoFalseNegatives() {
+        let filter = RGBloomFilter(capacity: 1000)
+        for index in 0 ..< 1000 {
+            filter.insert("key\(index)")
+        }
+        for index in 0 ..< 1000 {
+            XCTAssert(filter.mayContain("key\(index)"))
+        }
+        XCTAssert(filter.count > 990 && filter.count <= 1000)
+    }
+    
+    func testReinsertNotCounted() {
+        let filter = RGBloomFilter(capacity: 100)
+        filter.insert("abcd")
+        filter.insert("abcd")
+        XCTAssert(filter.count == 1)
+    }
+    
+    func testSizing() {
+        let filter = RGBloomFilter(capacity: 1000, falsePositiveRate: 0.01)
+        XCTAssert(filter.bitCount >= 9585 && filter.bitCount < 9700)
+        XCTAssert(filter.hashCount == 7)
+    }
+    
+    func testFalsePositiveRate() {
+        let filter = RGBloomFilter(capacity: 1000, falsePositiveRate: 0.01)
+        for index in 0 ..< 1000 {
+            filter.insert("com.example.app.key\(index)")
+        }
+        var falsePositives = 0
+        let probes = 100000
+        for index in 0 ..< probes {
+            if filter.mayContain("com.example.app.missing\(index)") {
+                falsePositives += 1
+            }
+        }
+        let rate = Double(falsePositives) / Double(probes)
+        print("false positive rate at capacity \(rate)")
+        XCTAssert(rate < 0.02)
+    }
+    
+    func testProbePerformance() {
+        let filter = RGBloomFilter(capacity: 1000)
+        for index in 0 ..< 1000 {
+            filter.insert("key\(index)")
+        }
+        self.measure {
+            for index in 0 ..< 10000 {
+                _ = filter.mayContain("missing\(index)")
+            }
+        }
+    }
+}
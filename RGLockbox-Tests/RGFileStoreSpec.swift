@@ -0,0 +1,266 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+class RGFileStoreSpec : XCTestCase {
+    
+    var path:String = ""
+    
+    override class func initialize() {
+        rg_SecItemCopyMatch = replacementItemCopy
+        rg_SecItemAdd = replacementAddItem
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
+    }
+    
+    override func setUp() {
+        self.path = (NSTemporaryDirectory() as NSString).appendingPathComponent("\(UUID().uuidString).store")
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    override func tearDown() {
+        RGLockbox.keychainQueue.sync {}
+        rg_SecItemCopyMatch = replacementItemCopy
+        rg_SecItemAdd = replacementAddItem
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
+        RGLockbox.removeAllCachedValues()
+        try? FileManager.default.removeItem(atPath: self.path)
+        try? FileManager.default.removeItem(atPath: self.path + ".index")
+    }
+    
+    func item(_ service:String, _ value:String) -> NSDictionary {
+        let query:[NSString:AnyObject] = [
+            kSecClass : kSecClassGenericPassword,
+            kSecAttrService : service as NSString,
+            kSecValueData : value.data(using: String.Encoding.utf8)! as NSData
+        ]
+        return query as NSDictionary
+    }
+    
+    func value(_ store:RGFileStore, _ service:String) -> String? {
+        let query:[NSString:AnyObject] = [
+            kSecClass : kSecClassGenericPassword,
+            kSecAttrService : service as NSString,
+            kSecReturnData : true as NSNumber
+        ]
+        var data:AnyObject? = nil
+        if store.copyMatching(query as NSDictionary, &data) != errSecSuccess {
+            return nil
+        }
+        return String(data: data as! Data, encoding: String.Encoding.utf8)
+    }
+    
+    func testLockboxRoundTripThroughStore() {
+        let store = RGFileStore(path: self.path)!
+        store.install()
+        RGLockbox().setString("abcd", key: kKey1)
+        RGLockbox().setString("efgh", key: kKey2)
+        RGLockbox().setString("ijkl", key: kKey2)
+        RGLockbox().setDate(Date(timeIntervalSince1970: 100), key: kTestKey)
+        RGLockbox().setDate(nil, key: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        RGFileStore(path: self.path)!.install()
+        XCTAssert(RGLockbox().stringForKey(kKey1) == "abcd")
+        XCTAssert(RGLockbox().stringForKey(kKey2) == "ijkl")
+        XCTAssert(RGLockbox().dateForKey(kTestKey) == nil)
+        XCTAssert(Set(RGLockbox().allItems()) == Set([ kKey1, kKey2 ]))
+    }
+    
+    func testAddAndUpdate() {
+        let store = RGFileStore(path: self.path)!
+        XCTAssert(store.add(self.item("service", "abcd")) == errSecSuccess)
+        XCTAssert(store.add(self.item("service", "efgh")) == errSecDuplicateItem)
+        let attributes:[NSString:AnyObject] = [ kSecValueData : "efgh".data(using: String.Encoding.utf8)! as NSData ]
+        XCTAssert(store.update(self.item("service", ""), attributes as NSDictionary) == errSecSuccess)
+        XCTAssert(store.update(self.item("missing", ""), attributes as NSDictionary) == errSecItemNotFound)
+        XCTAssert(self.value(store, "service") == "efgh")
+        XCTAssert(store.delete(self.item("service", "")) == errSecSuccess)
+        XCTAssert(store.delete(self.item("service", "")) == errSecItemNotFound)
+        XCTAssert(self.value(store, "service") == nil)
+    }
+    
+    func testTornRecordDiscarded() {
+        let store = RGFileStore(path: self.path)!
+        XCTAssert(store.add(self.item("first", "abcd")) == errSecSuccess)
+        XCTAssert(store.add(self.item("second", "efgh")) == errSecSuccess)
+        let length = store.length
+        let handle = FileHandle(forWritingAtPath: self.path)!
+        handle.truncateFile(atOffset: UInt64(length - 2))
+        handle.write(Data(bytes: [ 0xde, 0xad, 0xbe, 0xef ]))
+        handle.closeFile()
+        let reopened = RGFileStore(path: self.path)!
+        XCTAssert(self.value(reopened, "first") == "abcd")
+        XCTAssert(self.value(reopened, "second") == nil)
+        XCTAssert(reopened.length < length)
+        XCTAssert(reopened.add(self.item("third", "ijkl")) == errSecSuccess)
+        XCTAssert(self.value(RGFileStore(path: self.path)!, "third") == "ijkl")
+    }
+    
+    func testUncommittedTailDiscarded() {
+        let store = RGFileStore(path: self.path)!
+        XCTAssert(store.add(self.item("first", "abcd")) == errSecSuccess)
+        let length = store.length
+        let handle = FileHandle(forWritingAtPath: self.path)!
+        handle.seekToEndOfFile()
+        handle.write(Data(count: 64))
+        handle.closeFile()
+        let reopened = RGFileStore(path: self.path)!
+        XCTAssert(self.value(reopened, "first") == "abcd")
+        XCTAssert(reopened.length == length)
+        XCTAssert(reopened.add(self.item("second", "efgh")) == errSecSuccess)
+        XCTAssert(self.value(store, "second") == "efgh")
+    }
+    
+    func testStoresSharingLogSeeEachOther() {
+        let first = RGFileStore(path: self.path)!
+        let second = RGFileStore(path: self.path)!
+        XCTAssert(first.add(self.item("service", "abcd")) == errSecSuccess)
+        XCTAssert(self.value(second, "service") == "abcd")
+        XCTAssert(second.add(self.item("service", "efgh")) == errSecDuplicateItem)
+        XCTAssert(second.delete(self.item("service", "")) == errSecSuccess)
+        XCTAssert(self.value(first, "service") == nil)
+        XCTAssert(second.add(self.item("other", "ijkl")) == errSecSuccess)
+        XCTAssert(first.compact())
+        XCTAssert(self.value(second, "other") == "ijkl")
+        XCTAssert(second.add(self.item("last", "mnop")) == errSecSuccess)
+        XCTAssert(self.value(first, "last") == "mnop")
+        XCTAssert(first.length == second.length)
+    }
+    
+    func testConcurrentWritersShareSyncs() {
+        let store = RGFileStore(path: self.path)!
+        DispatchQueue.concurrentPerform(iterations: 16, execute: { thread in
+            for index in 0 ..< 50 {
+                XCTAssert(store.add(self.item("item.\(thread).\(index)", "value")) == errSecSuccess)
+            }
+        })
+        XCTAssert(store.recordCount == 800)
+        XCTAssert(store.syncCount < store.recordCount)
+        let reopened = RGFileStore(path: self.path)!
+        XCTAssert(self.value(reopened, "item.15.49") == "value")
+        XCTAssert(self.value(reopened, "item.0.0") == "value")
+    }
+    
+    func testBatchWindowSyncsOnce() {
+        let store = RGFileStore(path: self.path, durability: .batch(60))!
+        for index in 0 ..< 100 {
+            XCTAssert(store.add(self.item("item.\(index)", "value")) == errSecSuccess)
+        }
+        XCTAssert(self.value(store, "item.99") == "value")
+        XCTAssert(store.syncCount == 0)
+        XCTAssert(self.value(RGFileStore(path: self.path)!, "item.99") == nil)
+        XCTAssert(store.synchronize())
+        XCTAssert(store.syncCount == 1)
+        XCTAssert(store.recordCount == 100)
+        XCTAssert(self.value(RGFileStore(path: self.path)!, "item.99") == "value")
+    }
+    
+    func testAsyncWritesReachFile() {
+        let store = RGFileStore(path: self.path, durability: .async)!
+        for index in 0 ..< 100 {
+            XCTAssert(store.add(self.item("item.\(index)", "value")) == errSecSuccess)
+        }
+        XCTAssert(store.synchronize())
+        XCTAssert(store.recordCount == 100)
+        XCTAssert(self.value(RGFileStore(path: self.path)!, "item.99") == "value")
+    }
+    
+    func testCompaction() {
+        let store = RGFileStore(path: self.path)!
+        store.compactionThreshold = Int.max
+        XCTAssert(store.add(self.item("service", "value")) == errSecSuccess)
+        for index in 0 ..< 200 {
+            let data = "value\(index)".data(using: String.Encoding.utf8)!
+            let attributes:[NSString:AnyObject] = [ kSecValueData : data as NSData ]
+            XCTAssert(store.update(self.item("service", ""), attributes as NSDictionary) == errSecSuccess)
+        }
+        let length = store.length
+        XCTAssert(store.compact())
+        XCTAssert(store.length * 50 < length)
+        XCTAssert(self.value(RGFileStore(path: self.path)!, "service") == "value199")
+    }
+    
+    func testStressSharedLog() {
+        let stores = 4
+        let writes = 200
+        let durabilities:[RGFileDurability] = [ .perWrite, .batch(0.01), .async, .perWrite ]
+        DispatchQueue.concurrentPerform(iterations: stores, execute: { number in
+            let store = RGFileStore(path: self.path, durability: durabilities[number])!
+            store.compactionThreshold = 16 * 1024
+            for index in 0 ..< writes {
+                XCTAssert(store.add(self.item("item.\(number).\(index)", "value\(index)")) == errSecSuccess)
+                let data = "\(number).\(index)".data(using: String.Encoding.utf8)!
+                let attributes:[NSString:AnyObject] = [ kSecValueData : data as NSData ]
+                if store.update(self.item("shared", ""), attributes as NSDictionary) == errSecItemNotFound {
+                    _ = store.add(self.item("shared", "\(number).\(index)"))
+                }
+                if index % 2 == 1 {
+                    XCTAssert(store.delete(self.item("item.\(number).\(index)", "")) == errSecSuccess)
+                }
+                if number == 0 && index % 50 == 49 {
+                    XCTAssert(store.compact())
+                }
+            }
+            XCTAssert(store.synchronize())
+        })
+        let reopened = RGFileStore(path: self.path)!
+        for number in 0 ..< stores {
+            for index in 0 ..< writes {
+                XCTAssert(self.value(reopened, "item.\(number).\(index)") == (index % 2 == 0 ? "value\(index)" : nil))
+            }
+        }
+        XCTAssert(self.value(reopened, "shared") != nil)
+        let query:[NSString:AnyObject] = [
+            kSecClass : kSecClassGenericPassword,
+            kSecMatchLimit : kSecMatchLimitAll,
+            kSecReturnAttributes : true as NSNumber
+        ]
+        var items:AnyObject? = nil
+        XCTAssert(reopened.copyMatching(query as NSDictionary, &items) == errSecSuccess)
+        XCTAssert((items as? NSArray)?.count == stores * writes / 2 + 1)
+    }
+    
+    func testWriteThroughput() {
+        let writes = 2048
+        for threads in [ 1, 2, 4, 8, 16, 32 ] {
+            try? FileManager.default.removeItem(atPath: self.path)
+            try? FileManager.default.removeItem(atPath: self.path + ".index")
+            let store = RGFileStore(path: self.path)!
+            let start = Date()
+            DispatchQueue.concurrentPerform(iterations: threads, execute: { thread in
+                for index in 0 ..< writes / threads {
+                    _ = store.add(self.item("item.\(thread).\(index)", "value"))
+                }
+            })
+            let rate = Double(writes) / Date().timeIntervalSince(start)
+            print("RGFileStore \(threads) threads: \(Int(rate)) writes/s, " +
+                  "\(store.recordCount / max(store.syncCount, 1)) writes per sync")
+        }
+    }
+}
@@ -0,0 +1,137 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+class RGFrozenLockboxSpec : XCTestCase {
+    
+    override class func initialize() {
+        rg_SecItemCopyMatch = replacementItemCopy
+        rg_SecItemAdd = replacementAddItem
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
+    }
+    
+    override func setUp() {
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    override func tearDown() {
+        for key in testKeys {
+            RGLockbox().setData(nil, forKey: key)
+        }
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    func testFreeze() {
+        RGLockbox().setString("abcd", key: kKey1)
+        RGLockbox().setString("qwer", key: kKey2)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        
+        let frozen = RGLockbox().freeze(keys: testKeys)
+        XCTAssert(frozen.count == 2)
+        XCTAssert(frozen.stringForKey(kKey1) == "abcd")
+        XCTAssert(frozen.stringForKey(kKey2) == "qwer")
+        XCTAssert(Set(frozen.allKeys) == Set(testKeys))
+    }
+    
+    func testMissingKeysLeftOut() {
+        RGLockbox().setString("abcd", key: kKey1)
+        let frozen = RGLockbox().freeze(keys: testKeys)
+        XCTAssert(frozen.count == 1)
+        XCTAssert(frozen.dataForKey(kKey2) == nil)
+        XCTAssert(frozen.dataForKey("unknown") == nil)
+    }
+    
+    func testSnapshotIsImmutable() {
+        RGLockbox().setString("abcd", key: kKey1)
+        let frozen = RGLockbox().freeze(keys: [ kKey1 ])
+        RGLockbox().setString("qwer", key: kKey1)
+        XCTAssert(frozen.stringForKey(kKey1) == "abcd")
+    }
+    
+    func testEmpty() {
+        let frozen = RGFrozenLockbox(values: [:])
+        XCTAssert(frozen.count == 0)
+        XCTAssert(frozen.dataForKey(kKey1) == nil)
+    }
+    
+    func testPrefixesAreDistinct() {
+        let frozen = RGFrozenLockbox(values: [ "a" : Data(bytes: [1]), "ab" : Data(bytes: [2]), "" : Data(bytes: [3]) ])
+        XCTAssert(frozen.dataForKey("a") == Data(bytes: [1]))
+        XCTAssert(frozen.dataForKey("ab") == Data(bytes: [2]))
+        XCTAssert(frozen.dataForKey("") == Data(bytes: [3]))
+        XCTAssert(frozen.dataForKey("abc") == nil)
+        XCTAssert(frozen.dataForKey("b") == nil)
+    }
+    
+    func testManyKeys() {
+        var values:[String : Data] = [:]
+        for index in 0..<10_000 {
+            values["item.\(index)"] = "value \(index)".data(using: String.Encoding.utf8)!
+        }
+        let frozen = RGFrozenLockbox(values: values)
+        XCTAssert(frozen.count == values.count)
+        for (key, value) in values {
+            XCTAssert(frozen.dataForKey(key) == value)
+        }
+        XCTAssert(frozen.dataForKey("item.10000") == nil)
+    }
+    
+    func testReadThroughput() {
+        let keys = (0..<256).map({ "item.\($0)" })
+        for key in keys {
+            RGLockbox().setString("value of \(key)", key: key)
+        }
+        RGLockbox.keychainQueue.sync {}
+        let frozen = RGLockbox().freeze(keys: keys)
+        let reads = 200_000
+        for threads in [ 1, 16 ] {
+            var start = Date()
+            DispatchQueue.concurrentPerform(iterations: threads, execute: { thread in
+                let manager = RGLockbox()
+                for index in 0 ..< reads / threads {
+                    _ = manager.dataForKey(keys[(index + thread) % keys.count])
+                }
+            })
+            let lockboxRate = Double(reads) / Date().timeIntervalSince(start)
+            start = Date()
+            DispatchQueue.concurrentPerform(iterations: threads, execute: { thread in
+                for index in 0 ..< reads / threads {
+                    _ = frozen.dataForKey(keys[(index + thread) % keys.count])
+                }
+            })
+            let frozenRate = Double(reads) / Date().timeIntervalSince(start)
+            print("RGFrozenLockbox \(threads) threads: dataForKey \(Int(lockboxRate)) reads/s, " +
+                  "frozen \(Int(frozenRate)) reads/s")
+        }
+        for key in keys {
+            RGLockbox().setData(nil, forKey: key)
+        }
+    }
+}
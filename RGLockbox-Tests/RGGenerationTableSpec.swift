@@ -0,0 +1,112 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+let kCoherenceNamespace = "com.restgoatee.rglockbox.coherence"
+
+/**
+ Writes `data` to the stand-in keychain the way another process sharing the access group would.
+ */
+func rg_external_write(_ data:Data, service:String) {
+    var query:[NSString:AnyObject] = [
+        kSecClass : kSecClassGenericPassword,
+        kSecAttrService : service as NSString
+    ]
+    _ = rg_SecItemDelete(query as NSDictionary)
+    query[kSecValueData] = data as NSData
+    _ = rg_SecItemAdd(query as NSDictionary)
+}
+
+class RGGenerationTableSpec : XCTestCase {
+    
+    var path:String = ""
+    
+    override class func initialize() {
+        rg_SecItemCopyMatch = replacementItemCopy
+        rg_SecItemAdd = replacementAddItem
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
+    }
+    
+    override func setUp() {
+        self.path = (NSTemporaryDirectory() as NSString).appendingPathComponent("\(UUID().uuidString).gen")
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    override func tearDown() {
+        RGLockbox.generationTable = nil
+        RGLockbox(withNamespace: kCoherenceNamespace).setData(nil, forKey: kKey1)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        try? FileManager.default.removeItem(atPath: self.path)
+    }
+    
+    func testGenerationSharedBetweenMappings() {
+        let key = RGMultiKey(withFirst: "abcd")
+        let writer = RGGenerationTable(path: self.path)!
+        let reader = RGGenerationTable(path: self.path)!
+        XCTAssert(reader.generation(for: key) == 0)
+        writer.advance(key)
+        writer.advance(key)
+        XCTAssert(reader.generation(for: key) == 2)
+    }
+    
+    func testBucketIsStable() {
+        let table = RGGenerationTable(path: self.path, bucketCount: 64)!
+        let key = RGMultiKey(withFirst: "abcd", second: "account")
+        XCTAssert(table.bucket(for: key) == Int(key.stableHash % 64))
+        XCTAssert(key.stableHash != RGMultiKey(withFirst: "abcd").stableHash)
+    }
+    
+    func testMismatchedBucketCount() {
+        XCTAssert(RGGenerationTable(path: self.path, bucketCount: 64) != nil)
+        XCTAssert(RGGenerationTable(path: self.path, bucketCount: 128) == nil)
+    }
+    
+    func testRemoteWriteInvalidatesCache() {
+        let service = "\(kCoherenceNamespace).\(kKey1)"
+        let remote = RGGenerationTable(path: self.path)!
+        RGLockbox.generationTable = RGGenerationTable(path: self.path)
+        let lockbox = RGLockbox(withNamespace: kCoherenceNamespace)
+        lockbox.setData("abcd".data(using: String.Encoding.utf8), forKey: kKey1)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(lockbox.dataForKey(kKey1) == "abcd".data(using: String.Encoding.utf8))
+        rg_external_write("qwer".data(using: String.Encoding.utf8)!, service: service)
+        remote.advance(RGMultiKey(withFirst: service))
+        XCTAssert(lockbox.dataForKey(kKey1) == "qwer".data(using: String.Encoding.utf8))
+    }
+    
+    func testUnchangedGenerationServesCache() {
+        let service = "\(kCoherenceNamespace).\(kKey1)"
+        RGLockbox.generationTable = RGGenerationTable(path: self.path)
+        let lockbox = RGLockbox(withNamespace: kCoherenceNamespace)
+        lockbox.setData("abcd".data(using: String.Encoding.utf8), forKey: kKey1)
+        RGLockbox.keychainQueue.sync {}
+        lockbox.dataForKey(kKey1)
+        rg_external_write("qwer".data(using: String.Encoding.utf8)!, service: service)
+        XCTAssert(lockbox.dataForKey(kKey1) == "abcd".data(using: String.Encoding.utf8))
+    }
+}
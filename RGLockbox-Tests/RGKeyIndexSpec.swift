@@ -0,0 +1,77 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+class RGKeyIndexSpec : XCTestCase {
+    
+    func testSortsAndDeduplicates() {
+        let index = RGKeyIndex(keys: [ "b", "a", "c", "a" ])
+        XCTAssert(index.count == 3)
+        XCTAssert(index.keys(withPrefix: "") == [ "a", "b", "c" ])
+    }
+    
+    func testInsertAndRemove() {
+        let index = RGKeyIndex(keys: [ "a", "c" ])
+        XCTAssert(index.insert("b"))
+        XCTAssert(!index.insert("b"))
+        XCTAssert(index.contains("b"))
+        XCTAssert(index.remove("a"))
+        XCTAssert(!index.remove("a"))
+        XCTAssert(!index.contains("a"))
+        XCTAssert(index.keys(withPrefix: "") == [ "b", "c" ])
+    }
+    
+    func testPrefix() {
+        let index = RGKeyIndex(keys: [ "user.1.token", "user.10.token", "user.1.refresh", "user.2.token", "user" ])
+        XCTAssert(index.keys(withPrefix: "user.1.") == [ "user.1.refresh", "user.1.token" ])
+        XCTAssert(index.keys(withPrefix: "user.1") == [ "user.1.refresh", "user.1.token", "user.10.token" ])
+        XCTAssert(index.keys(withPrefix: "user.3") == [])
+        XCTAssert(index.keys(withPrefix: "user").count == 5)
+    }
+    
+    func testOrderIsBytewise() {
+        let index = RGKeyIndex(keys: [ "é", "e\u{301}", "f", "E" ])
+        XCTAssert(index.count == 4)
+        XCTAssert(index.keys(withPrefix: "e") == [ "e\u{301}" ])
+        XCTAssert(index.keys(withPrefix: "") == [ "E", "e\u{301}", "f", "é" ])
+    }
+    
+    func testRange() {
+        let index = RGKeyIndex(keys: (0 ..< 100).map({ String(format: "key%02d", $0) }))
+        XCTAssert(index.keys(from: "key10", to: "key13") == [ "key10", "key11", "key12" ])
+        XCTAssert(index.keys(from: "key98", to: "kez") == [ "key98", "key99" ])
+        XCTAssert(index.keys(from: "key13", to: "key10") == [])
+    }
+    
+    func testLookupPerformance() {
+        let index = RGKeyIndex(keys: (0 ..< 10000).map({ "user.\($0).token" }))
+        self.measure {
+            for user in 0 ..< 10000 {
+                _ = index.keys(withPrefix: "user.\(user).")
+            }
+        }
+    }
+}
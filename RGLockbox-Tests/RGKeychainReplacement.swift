@@ -25,45 +25,103 @@ import Foundation
 import RGLockboxIOS
 
 var theKeychainLol:Dictionary<RGMultiKey, Data> = [:]
+var theKeychainAttributes:Dictionary<RGMultiKey, [String:Any]> = [:]
 var keychainLock = NSLock()
 
-let replacementItemCopy:(CFDictionary, UnsafeMutablePointer<CFTypeRef?>?) -> OSStatus = { query, value in
-    let pointer = CFDictionaryGetValue(query, Unmanaged.passUnretained(kSecAttrService).toOpaque())
-    if pointer != nil {
-        var multiKey = RGMultiKey()
-        multiKey.first = unsafeBitCast(pointer, to: CFString.self) as String
-        let account = CFDictionaryGetValue(query, Unmanaged.passUnretained(kSecAttrAccount).toOpaque())
-        if account != nil {
-            multiKey.second = unsafeBitCast(account, to: CFString.self) as String
+/**
+ When set every replacement call fails with this status, e.g. `errSecInteractionNotAllowed` for a locked device.
+ */
+var replacementStatusOverride:OSStatus? = nil
+
+/**
+ When positive every replacement call sleeps this long first, e.g. to stand in for a busy securityd.
+ */
+var replacementDelay:TimeInterval = 0
+
+func replacementInjectDelay() {
+    if replacementDelay > 0 {
+        Thread.sleep(forTimeInterval: replacementDelay)
+    }
+}
+
+func replacementFlag(_ query:CFDictionary, _ key:CFString) -> Bool {
+    let pointer = CFDictionaryGetValue(query, Unmanaged.passUnretained(key).toOpaque())
+    return pointer != nil && unsafeBitCast(pointer, to: NSNumber.self).boolValue
+}
+
+/**
+ - returns: The service, account and access group named by `query`, any of which are `nil` when left out.
+ */
+func replacementKey(_ query:CFDictionary) -> RGMultiKey {
+    var multiKey = RGMultiKey()
+    for (index, attribute) in [ kSecAttrService, kSecAttrAccount, kSecAttrAccessGroup ].enumerated() {
+        let pointer = CFDictionaryGetValue(query, Unmanaged.passUnretained(attribute).toOpaque())
+        if pointer == nil {
+            continue
+        }
+        let string = unsafeBitCast(pointer, to: CFString.self) as String
+        switch index {
+        case 0: multiKey.first = string
+        case 1: multiKey.second = string
+        default: multiKey.third = string
         }
-        let returnData:NSNumber = unsafeBitCast(CFDictionaryGetValue(query, Unmanaged.passUnretained(kSecReturnData).toOpaque()), to: NSNumber.self)
+    }
+    return multiKey
+}
+
+/**
+ Like the real keychain a component left out of `query` matches any value, so a query without an account also finds
+   the items stored with one.  Must be called with `keychainLock` held.
+ - returns: The stored keys `query` matches, the exact match first when there is one.
+ */
+func replacementKeys(matching query:RGMultiKey) -> [RGMultiKey] {
+    var keys:[RGMultiKey] = []
+    for key in theKeychainLol.keys {
+        if (query.first == nil || key.first == query.first)
+            && (query.second == nil || key.second == query.second)
+            && (query.third == nil || key.third == query.third) {
+            keys.append(key)
+        }
+    }
+    if let exact = keys.index(of: query) {
+        keys.insert(keys.remove(at: exact), at: 0)
+    }
+    return keys
+}
+
+let replacementItemCopy:(CFDictionary, UnsafeMutablePointer<CFTypeRef?>?) -> OSStatus = { query, value in
+    replacementInjectDelay()
+    if let status = replacementStatusOverride {
+        return status
+    }
+    let multiKey = replacementKey(query)
+    if multiKey.first != nil {
+        let returnData = replacementFlag(query, kSecReturnData)
+        let returnAttributes = replacementFlag(query, kSecReturnAttributes)
         keychainLock.lock()
-        let storedValue = theKeychainLol[multiKey]
+        let key = replacementKeys(matching: multiKey).first
+        let storedValue = key.flatMap({ theKeychainLol[$0] })
+        let attributes = key.flatMap({ theKeychainAttributes[$0] }) ?? [:]
         keychainLock.unlock()
         if let storedValue = storedValue {
-            if returnData.boolValue {
+            if returnAttributes {
+                var ret = attributes
+                ret[kSecAttrService as String] = multiKey.first!
+                ret[kSecValueData as String] = returnData ? storedValue : nil
+                value!.pointee = ret as AnyObject
+            } else if returnData {
                 value!.pointee = storedValue as AnyObject
             }
             return errSecSuccess
         }
     } else {
         keychainLock.lock()
-        let account = CFDictionaryGetValue(query, Unmanaged.passUnretained(kSecAttrAccount).toOpaque())
         var output:[Dictionary<String, Any>] = []
-        for item in theKeychainLol {
-            let key = item.0
-            var ret:[String:Any] = [:]
-            ret[kSecValueData as String] = item.1
-            if account != nil {
-                let accountName = unsafeBitCast(account, to: CFString.self) as String
-                if accountName == key.second {
-                    ret[kSecAttrService as String] = key.first
-                    output.append(ret)
-                }
-            } else {
-                ret[kSecAttrService as String] = key.first 
-                output.append(ret)
-            }
+        for key in replacementKeys(matching: multiKey) {
+            var ret = theKeychainAttributes[key] ?? [:]
+            ret[kSecValueData as String] = theKeychainLol[key]
+            ret[kSecAttrService as String] = key.first
+            output.append(ret)
         }
         keychainLock.unlock()
         value!.pointee = output as AnyObject?
@@ -74,13 +132,11 @@ let replacementItemCopy:(CFDictionary, UnsafeMutablePointer<CFTypeRef?>?) -> OSS
 }
 
 let replacementAddItem:(CFDictionary) -> OSStatus = { query in
-    let pointer = CFDictionaryGetValue(query, Unmanaged.passUnretained(kSecAttrService).toOpaque())
-    var multiKey = RGMultiKey()
-    multiKey.first = unsafeBitCast(pointer, to: CFString.self) as String
-    let account = CFDictionaryGetValue(query, Unmanaged.passUnretained(kSecAttrAccount).toOpaque())
-    if account != nil {
-        multiKey.second = unsafeBitCast(account, to: CFString.self) as String
+    replacementInjectDelay()
+    if let status = replacementStatusOverride {
+        return status
     }
+    let multiKey = replacementKey(query)
     let data = unsafeBitCast(CFDictionaryGetValue(query, Unmanaged.passUnretained(kSecValueData).toOpaque()), to: Data.self)
     keychainLock.lock()
     let storedValue = theKeychainLol[multiKey]
@@ -89,21 +145,62 @@ let replacementAddItem:(CFDictionary) -> OSStatus = { query in
         return errSecDuplicateItem
     }
     theKeychainLol[multiKey] = data
+    var attributes:[String:Any] = [ kSecAttrModificationDate as String : Date() ]
+    for attribute in [ kSecAttrGeneric, kSecAttrType, kSecAttrAccessible, kSecAttrSynchronizable ] {
+        let attributeValue = CFDictionaryGetValue(query, Unmanaged.passUnretained(attribute).toOpaque())
+        if attributeValue != nil {
+            attributes[attribute as String] = unsafeBitCast(attributeValue, to: AnyObject.self)
+        }
+    }
+    theKeychainAttributes[multiKey] = attributes
     keychainLock.unlock()
     return errSecSuccess
 }
 
 let replacementDeleteItem:(CFDictionary) -> OSStatus = { query in
-    let pointer = CFDictionaryGetValue(query, Unmanaged.passUnretained(kSecAttrService).toOpaque())
-    var multiKey = RGMultiKey()
-    multiKey.first = unsafeBitCast(pointer, to: CFString.self) as String
-    let account = CFDictionaryGetValue(query, Unmanaged.passUnretained(kSecAttrAccount).toOpaque())
-    if account != nil {
-        multiKey.second = unsafeBitCast(account, to: CFString.self) as String
+    replacementInjectDelay()
+    if let status = replacementStatusOverride {
+        return status
     }
+    let multiKey = replacementKey(query)
     keychainLock.lock()
-    let value = theKeychainLol[multiKey]
-    theKeychainLol[multiKey] = nil
+    let keys = replacementKeys(matching: multiKey)
+    for key in keys {
+        theKeychainLol[key] = nil
+        theKeychainAttributes[key] = nil
+    }
     keychainLock.unlock()
-    return (value != nil) ? errSecSuccess : errSecItemNotFound
+    return keys.count > 0 ? errSecSuccess : errSecItemNotFound
+}
+
+let replacementUpdateItem:(CFDictionary, CFDictionary) -> OSStatus = { query, attributesToUpdate in
+    replacementInjectDelay()
+    if let status = replacementStatusOverride {
+        return status
+    }
+    let multiKey = replacementKey(query)
+    keychainLock.lock()
+    let keys = replacementKeys(matching: multiKey)
+    if keys.count == 0 {
+        keychainLock.unlock()
+        return errSecItemNotFound
+    }
+    let data = CFDictionaryGetValue(attributesToUpdate, Unmanaged.passUnretained(kSecValueData).toOpaque())
+    for key in keys {
+        if data != nil {
+            theKeychainLol[key] = unsafeBitCast(data, to: Data.self)
+        }
+        var attributes = theKeychainAttributes[key] ?? [:]
+        attributes[kSecAttrModificationDate as String] = Date()
+        for attribute in [ kSecAttrGeneric, kSecAttrType, kSecAttrAccessible, kSecAttrSynchronizable ] {
+            let attributeValue = CFDictionaryGetValue(attributesToUpdate,
+                                                      Unmanaged.passUnretained(attribute).toOpaque())
+            if attributeValue != nil {
+                attributes[attribute as String] = unsafeBitCast(attributeValue, to: AnyObject.self)
+            }
+        }
+        theKeychainAttributes[key] = attributes
+    }
+    keychainLock.unlock()
+    return errSecSuccess
 }
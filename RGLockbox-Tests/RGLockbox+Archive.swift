@@ -0,0 +1,193 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+let kArchiveSource = "com.rglockbox.archive.source"
+let kArchiveDestination = "com.rglockbox.archive.destination"
+
+class RGLockbox_ArchiveSpec : XCTestCase {
+    
+    let archiveKey = Data(bytes: (0..<32).map({ UInt8($0) }))
+    let archiveURL = URL(fileURLWithPath: NSTemporaryDirectory()).appendingPathComponent("RGLockbox.archive")
+    
+    override class func initialize() {
+        rg_SecItemCopyMatch = replacementItemCopy
+        rg_SecItemAdd = replacementAddItem
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
+    }
+    
+    override func setUp() {
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.discardPackedItems()
+        keychainLock.lock()
+        theKeychainLol.removeAll()
+        theKeychainAttributes.removeAll()
+        keychainLock.unlock()
+        RGLockbox.removeAllCachedValues()
+        RGLockbox.invalidateMembershipFilters()
+    }
+    
+    override func tearDown() {
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.discardPackedItems()
+        RGLockbox.removeAllCachedValues()
+        try? FileManager.default.removeItem(at: self.archiveURL)
+    }
+    
+    func testRoundTrip() {
+        let source = RGLockbox(withNamespace: kArchiveSource)
+        source.setString("abcd", key: kKey1)
+        source.setString("qwer", key: kKey2)
+        XCTAssert(try! source.export(to: self.archiveURL, key: self.archiveKey) == 2)
+        
+        let destination = RGLockbox(withNamespace: kArchiveDestination)
+        XCTAssert(try! destination.import(from: self.archiveURL, key: self.archiveKey) == 2)
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(destination.stringForKey(kKey1) == "abcd")
+        XCTAssert(destination.stringForKey(kKey2) == "qwer")
+    }
+    
+    func testLongKeyRoundTrip() {
+        let longKey = String(repeating: "k", count: 70000)
+        RGLockbox(withNamespace: kArchiveSource).setString("abcd", key: longKey)
+        XCTAssert(try! RGLockbox(withNamespace: kArchiveSource).export(to: self.archiveURL, key: self.archiveKey) == 1)
+        
+        let destination = RGLockbox(withNamespace: kArchiveDestination)
+        XCTAssert(try! destination.import(from: self.archiveURL, key: self.archiveKey) == 1)
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(destination.stringForKey(longKey) == "abcd")
+    }
+    
+    func testRecordsSpanningChunksRoundTrip() {
+        let source = RGLockbox(withNamespace: kArchiveSource)
+        let large = Data(bytes: (0 ..< 150 * 1024).map({ UInt8(truncatingBitPattern: $0 &* 31) }))
+        for index in 0 ..< 5 {
+            source.setData(large, forKey: "large.\(index)")
+            source.setString("small \(index)", key: "small.\(index)")
+        }
+        XCTAssert(try! source.export(to: self.archiveURL, key: self.archiveKey) == 10)
+        
+        let destination = RGLockbox(withNamespace: kArchiveDestination)
+        XCTAssert(try! destination.import(from: self.archiveURL, key: self.archiveKey) == 10)
+        RGLockbox.removeAllCachedValues()
+        for index in 0 ..< 5 {
+            XCTAssert(destination.dataForKey("large.\(index)") == large)
+            XCTAssert(destination.stringForKey("small.\(index)") == "small \(index)")
+        }
+    }
+    
+    func testArchiveIsEncrypted() {
+        RGLockbox(withNamespace: kArchiveSource).setString("plaintext secret", key: kKey1)
+        try! RGLockbox(withNamespace: kArchiveSource).export(to: self.archiveURL, key: self.archiveKey)
+        let archive = try! Data(contentsOf: self.archiveURL)
+        XCTAssert(archive.range(of: "plaintext secret".data(using: .utf8)!) == nil)
+        XCTAssert(archive.range(of: kKey1.data(using: .utf8)!) == nil)
+    }
+    
+    func testWrongKeyFails() {
+        RGLockbox(withNamespace: kArchiveSource).setString("abcd", key: kKey1)
+        try! RGLockbox(withNamespace: kArchiveSource).export(to: self.archiveURL, key: self.archiveKey)
+        var wrongKey = self.archiveKey
+        wrongKey[0] ^= 1
+        XCTAssertThrowsError(try RGLockbox(withNamespace: kArchiveDestination).import(from: self.archiveURL,
+                                                                                      key: wrongKey))
+        XCTAssert(RGLockbox(withNamespace: kArchiveDestination).dataForKey(kKey1) == nil)
+    }
+    
+    func testTamperedArchiveFails() {
+        RGLockbox(withNamespace: kArchiveSource).setString("abcd", key: kKey1)
+        try! RGLockbox(withNamespace: kArchiveSource).export(to: self.archiveURL, key: self.archiveKey)
+        var archive = try! Data(contentsOf: self.archiveURL)
+        archive[20] ^= 1
+        try! archive.write(to: self.archiveURL)
+        XCTAssertThrowsError(try RGLockbox(withNamespace: kArchiveDestination).import(from: self.archiveURL,
+                                                                                      key: self.archiveKey))
+        XCTAssert(RGLockbox(withNamespace: kArchiveDestination).dataForKey(kKey1) == nil)
+    }
+    
+    func testShortKeyFails() {
+        XCTAssertThrowsError(try RGLockbox(withNamespace: kArchiveSource).export(to: self.archiveURL,
+                                                                                 key: Data(bytes: [1, 2, 3])))
+    }
+    
+    func testExpiryPreserved() {
+        let source = RGLockbox(withNamespace: kArchiveSource)
+        source.setData("abcd".data(using: String.Encoding.utf8), forKey: kKey1, ttl: 60.0)
+        source.setData("qwer".data(using: String.Encoding.utf8), forKey: kKey2, ttl: 0.1)
+        XCTAssert(try! source.export(to: self.archiveURL, key: self.archiveKey) == 2)
+        Thread.sleep(forTimeInterval: 0.2)
+        
+        let destination = RGLockbox(withNamespace: kArchiveDestination)
+        XCTAssert(try! destination.import(from: self.archiveURL, key: self.archiveKey) == 1)
+        XCTAssert(destination.stringForKey(kKey1) == "abcd")
+        XCTAssert(destination.dataForKey(kKey2) == nil)
+        let service = RGMultiKey(withFirst: "\(kArchiveDestination).\(kKey1)")
+        keychainLock.lock()
+        let generic = theKeychainAttributes[service]?[kSecAttrGeneric as String]
+        keychainLock.unlock()
+        XCTAssert(generic != nil)
+    }
+    
+    func testPackedRoundTrip() {
+        let source = RGLockbox(withNamespace: kArchiveSource, packed: true)
+        source.setString("abcd", key: kKey1)
+        source.setString("qwer", key: kKey2)
+        XCTAssert(try! source.export(to: self.archiveURL, key: self.archiveKey) == 2)
+        
+        let destination = RGLockbox(withNamespace: kArchiveDestination, packed: true)
+        XCTAssert(try! destination.import(from: self.archiveURL, key: self.archiveKey) == 2)
+        RGLockbox.discardPackedItems()
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(destination.stringForKey(kKey1) == "abcd")
+        XCTAssert(destination.stringForKey(kKey2) == "qwer")
+    }
+    
+    func testThroughput() {
+        let count = 10_000
+        var items:[String : Data] = [:]
+        for index in 0..<count {
+            items["item.\(index)"] = "value \(index)".data(using: .utf8)!
+        }
+        let source = RGLockbox(withNamespace: kArchiveSource)
+        source.setItems(items)
+        RGLockbox.keychainQueue.sync {}
+        
+        var start = Date()
+        XCTAssert(try! source.export(to: self.archiveURL, key: self.archiveKey) == count)
+        let exportRate = Double(count) / Date().timeIntervalSince(start)
+        
+        let destination = RGLockbox(withNamespace: kArchiveDestination)
+        start = Date()
+        XCTAssert(try! destination.import(from: self.archiveURL, key: self.archiveKey) == count)
+        let importRate = Double(count) / Date().timeIntervalSince(start)
+        print("RGLockbox archive: export \(Int(exportRate)) items/s, import \(Int(importRate)) items/s")
+        
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(destination.stringForKey("item.0") == "value 0")
+        XCTAssert(destination.stringForKey("item.\(count - 1)") == "value \(count - 1)")
+    }
+}
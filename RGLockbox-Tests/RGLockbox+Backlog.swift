@@ -0,0 +1,158 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+class RGLockbox_BacklogSpec : XCTestCase {
+    
+    let defaultLimit = RGLockbox.writeBacklogLimit
+    
+    override class func initialize() {
+        rg_SecItemCopyMatch = replacementItemCopy
+        rg_SecItemAdd = replacementAddItem
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
+    }
+    
+    override func setUp() {
+        RGLockbox.keychainQueue.sync {}
+        keychainLock.lock()
+        theKeychainLol.removeAll()
+        theKeychainAttributes.removeAll()
+        keychainLock.unlock()
+        RGLockbox.removeAllCachedValues()
+        RGLockbox.resetWriteBacklogHighWater()
+    }
+    
+    override func tearDown() {
+        replacementDelay = 0
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.writeBacklogLimit = self.defaultLimit
+        RGLockbox.writeBacklogPolicy = .block
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    func storedString(_ key:String) -> String? {
+        keychainLock.lock()
+        let value = theKeychainLol[RGMultiKey(withFirst: "\(RGLockbox.bundleIdentifier!).\(key)")]
+        keychainLock.unlock()
+        return value != nil ? String(data: value!, encoding: String.Encoding.utf8) : nil
+    }
+    
+    func testSupersededWritesDropped() {
+        let superseded = RGLockbox.supersededWriteCount
+        replacementDelay = 0.05
+        RGLockbox().setString("abcd", key: kKey1)
+        for index in 0 ..< 100 {
+            RGLockbox().setString("value\(index)", key: kTestKey)
+        }
+        XCTAssert(RGLockbox.writeBacklog.count <= 2)
+        XCTAssert(RGLockbox.supersededWriteCount - superseded >= 98)
+        XCTAssert(RGLockbox().stringForKey(kTestKey) == "value99")
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(self.storedString(kTestKey) == "value99")
+        XCTAssert(RGLockbox.writeBacklog.count == 0 && RGLockbox.writeBacklog.bytes == 0)
+    }
+    
+    func testWriteAfterOtherWorkIsNotFolded() {
+        replacementDelay = 0.05
+        RGLockbox().setString("abcd", key: kKey1)
+        RGLockbox().setString("first", key: kTestKey)
+        RGLockbox().setData(Data(count: RGLockbox.chunkSize + 1), forKey: kTestKey)
+        RGLockbox().setString("last", key: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox().stringForKey(kTestKey) == "last")
+    }
+    
+    func testBlockingBoundsBacklog() {
+        RGLockbox.writeBacklogLimit = 5
+        replacementDelay = 0.005
+        for index in 0 ..< 50 {
+            RGLockbox().setString("value", key: "block\(index)")
+        }
+        XCTAssert(RGLockbox.writeBacklogHighWater.count <= 5)
+        RGLockbox.keychainQueue.sync {}
+        for index in 0 ..< 50 {
+            XCTAssert(self.storedString("block\(index)") == "value")
+            RGLockbox().setString(nil, key: "block\(index)")
+        }
+    }
+    
+    func testFailFast() {
+        RGLockbox.writeBacklogLimit = 2
+        replacementDelay = 0.1
+        RGLockbox().setString("value", key: "fail0")
+        Thread.sleep(forTimeInterval: 0.02)
+        XCTAssert((try? RGLockbox().setData(Data(count: 1), forKey: "fail1", policy: .failFast)) != nil)
+        XCTAssert((try? RGLockbox().setData(Data(count: 1), forKey: "fail2", policy: .failFast)) != nil)
+        XCTAssertThrowsError(try RGLockbox().setData(Data(count: 1), forKey: "fail3", policy: .failFast))
+        XCTAssert((try? RGLockbox().setData(Data(count: 2), forKey: "fail2", policy: .failFast)) != nil)
+        XCTAssert(RGLockbox().dataForKey("fail3") == nil)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(self.storedString("fail3") == nil)
+        for index in 0 ..< 3 {
+            RGLockbox().setString(nil, key: "fail\(index)")
+        }
+    }
+    
+    func testSpill() {
+        let spilled = RGLockbox.spilledWriteCount
+        RGLockbox.writeBacklogLimit = 2
+        RGLockbox.writeBacklogPolicy = .spill
+        replacementDelay = 0.05
+        for index in 0 ..< 10 {
+            RGLockbox().setString("value\(index)", key: "spill\(index)")
+        }
+        XCTAssert(RGLockbox.writeBacklogHighWater.count <= 2)
+        XCTAssert(RGLockbox.spilledWriteCount - spilled >= 6)
+        for index in 0 ..< 10 {
+            XCTAssert(RGLockbox().stringForKey("spill\(index)") == "value\(index)")
+        }
+        let deadline = Date(timeIntervalSinceNow: 5)
+        while RGLockbox.deferredWriteCount > 0 && Date() < deadline {
+            Thread.sleep(forTimeInterval: 0.05)
+        }
+        RGLockbox.keychainQueue.sync {}
+        for index in 0 ..< 10 {
+            XCTAssert(self.storedString("spill\(index)") == "value\(index)")
+            RGLockbox().setString(nil, key: "spill\(index)")
+        }
+    }
+    
+// MARK: - Benchmarks
+    
+    func testWriteStormOfOneKey() {
+        replacementDelay = 0.001
+        self.measure {
+            for index in 0 ..< 10000 {
+                RGLockbox().setString("value\(index)", key: kTestKey)
+            }
+            XCTAssert(RGLockbox.writeBacklog.count <= 2)
+            RGLockbox.keychainQueue.sync {}
+        }
+        print("RGLockbox write storm high water \(RGLockbox.writeBacklogHighWater)")
+    }
+}
@@ -0,0 +1,228 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+class RGLockbox_ChunkingSpec : XCTestCase {
+    
+    static var backendReads = 0
+    
+    let defaultChunkSize = RGLockbox.chunkSize
+    let defaultBudget = RGLockbox.chunkCacheBudget
+    
+    override class func initialize() {
+        rg_SecItemCopyMatch = { query, value in
+            RGLockbox_ChunkingSpec.backendReads += 1
+            return replacementItemCopy(query, value)
+        }
+        rg_SecItemAdd = replacementAddItem
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
+    }
+    
+    override func setUp() {
+        RGLockbox.keychainQueue.sync {}
+        keychainLock.lock()
+        theKeychainLol.removeAll()
+        theKeychainAttributes.removeAll()
+        keychainLock.unlock()
+        RGLockbox.removeAllCachedValues()
+        RGLockbox_ChunkingSpec.backendReads = 0
+    }
+    
+    override func tearDown() {
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.chunkSize = self.defaultChunkSize
+        RGLockbox.chunkCacheBudget = self.defaultBudget
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    func value(_ length:Int) -> Data {
+        return Data(bytes: (0 ..< length).map({ UInt8(truncatingBitPattern: $0 &* 31 &+ $0 >> 8) }))
+    }
+    
+    func chunkItemCount() -> Int {
+        keychainLock.lock()
+        let count = theKeychainLol.keys.filter({ $0.first!.hasPrefix("RGLockbox.chunk.") }).count
+        keychainLock.unlock()
+        return count
+    }
+    
+    func testRoundTrip() {
+        let value = self.value(100 * 1024)
+        RGLockbox().setData(value, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox().dataForKey(kTestKey) == value)
+    }
+    
+    func testSplitIntoChunks() {
+        RGLockbox.chunkSize = 1024
+        RGLockbox().setData(self.value(10 * 1024 + 1), forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(self.chunkItemCount() == 11)
+    }
+    
+    func testSmallValueNotChunked() {
+        RGLockbox().setData(self.value(100), forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(self.chunkItemCount() == 0)
+    }
+    
+    func testValueShapedLikeManifestReadsAsItself() {
+        var bytes:[UInt8] = Array("RGLBCHNK".utf8) + [ 1 ]
+        bytes += [UInt8](repeating: 7, count: 8)
+        bytes += [ 0, 0, 1, 0, 0, 0, 0, 0 ]
+        bytes += [ 0, 4, 0, 0 ]
+        bytes += [UInt8](repeating: 9, count: 16)
+        let value = Data(bytes: bytes)
+        RGLockbox().setData(value, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox().dataForKey(kTestKey) == value)
+        XCTAssert(RGLockbox().dataForKey(kTestKey, range: 0 ..< 8) == value.subdata(in: 0 ..< 8))
+    }
+    
+    func testRangedReadLoadsCoveringChunks() {
+        RGLockbox.chunkSize = 1024
+        RGLockbox.chunkCacheBudget = 0
+        let value = self.value(64 * 1024)
+        RGLockbox().setData(value, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        RGLockbox_ChunkingSpec.backendReads = 0
+        let range = 40000 ..< 41100
+        XCTAssert(RGLockbox().dataForKey(kTestKey, range: range) == value.subdata(in: range))
+        XCTAssert(RGLockbox_ChunkingSpec.backendReads == 3)
+    }
+    
+    func testRangedReadClamped() {
+        let value = self.value(100 * 1024)
+        RGLockbox().setData(value, forKey: kTestKey)
+        XCTAssert(RGLockbox().dataForKey(kTestKey, range: 100000 ..< 200000) == value.subdata(in: 100000 ..< value.count))
+        XCTAssert(RGLockbox().dataForKey(kTestKey, range: 200000 ..< 300000) == Data())
+        RGLockbox().setData(self.value(10), forKey: kTestKey)
+        XCTAssert(RGLockbox().dataForKey(kTestKey, range: 2 ..< 20) == self.value(10).subdata(in: 2 ..< 10))
+    }
+    
+    func testChunksCached() {
+        let value = self.value(100 * 1024)
+        RGLockbox().setData(value, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox_ChunkingSpec.backendReads = 0
+        XCTAssert(RGLockbox().dataForKey(kTestKey) == value)
+        XCTAssert(RGLockbox_ChunkingSpec.backendReads == 0)
+    }
+    
+    func testCacheBudget() {
+        RGLockbox.chunkCacheBudget = 256 * 1024
+        RGLockbox().setData(self.value(1024 * 1024), forKey: kTestKey)
+        XCTAssert(RGLockbox.chunkCacheSize <= 256 * 1024)
+        XCTAssert(RGLockbox().dataForKey(kTestKey) == self.value(1024 * 1024))
+        XCTAssert(RGLockbox.chunkCacheSize <= 256 * 1024)
+    }
+    
+    func testOverwriteRemovesChunks() {
+        RGLockbox.chunkSize = 1024
+        RGLockbox().setData(self.value(10 * 1024), forKey: kTestKey)
+        RGLockbox().setData(self.value(5 * 1024), forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(self.chunkItemCount() == 5)
+        RGLockbox().setData(nil, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(self.chunkItemCount() == 0)
+    }
+    
+    func testOverwriteOfEvictedValueRemovesChunks() {
+        RGLockbox.chunkSize = 1024
+        RGLockbox().setData(self.value(10 * 1024), forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        RGLockbox().setData(self.value(2 * 1024), forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(self.chunkItemCount() == 2)
+    }
+    
+    func testChunksHiddenFromAllItems() {
+        RGLockbox().setData(self.value(100 * 1024), forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(RGLockbox().allItems() == [ kTestKey ])
+        XCTAssert(RGLockbox().dataForKey(kTestKey) == self.value(100 * 1024))
+    }
+    
+    func testUnchangedChunkedValueElided() {
+        RGLockbox().setData(self.value(100 * 1024), forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox().dataForKey(kTestKey, range: 0 ..< 1) != nil)
+        let count = RGLockbox.elidedWriteCount
+        RGLockbox().setData(self.value(100 * 1024), forKey: kTestKey)
+        XCTAssert(RGLockbox.elidedWriteCount == count + 1)
+    }
+    
+// MARK: - Benchmarks
+    
+    func testWrite1MB() {
+        let value = self.value(1024 * 1024)
+        var round:UInt8 = 0
+        self.measure {
+            var copy = value
+            round = round &+ 1
+            copy[0] = round
+            RGLockbox().setData(copy, forKey: kTestKey)
+            RGLockbox.keychainQueue.sync {}
+        }
+    }
+    
+    func testColdRead1MB() {
+        RGLockbox.chunkCacheBudget = 0
+        RGLockbox().setData(self.value(1024 * 1024), forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        self.measure {
+            RGLockbox.removeAllCachedValues()
+            _ = RGLockbox().dataForKey(kTestKey)
+        }
+    }
+    
+    func testColdRangedRead1MB() {
+        RGLockbox.chunkCacheBudget = 0
+        RGLockbox().setData(self.value(1024 * 1024), forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        self.measure {
+            RGLockbox.removeAllCachedValues()
+            _ = RGLockbox().dataForKey(kTestKey, range: 512 * 1024 ..< 516 * 1024)
+        }
+    }
+    
+    func testColdRangedRead1MBUnchunked() {
+        RGLockbox.chunkSize = Int.max
+        RGLockbox().setData(self.value(1024 * 1024), forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        self.measure {
+            RGLockbox.removeAllCachedValues()
+            _ = RGLockbox().dataForKey(kTestKey, range: 512 * 1024 ..< 516 * 1024)
+        }
+    }
+}
@@ -0,0 +1,221 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+class RGLockbox_CompressionSpec : XCTestCase {
+    
+    static var backendReads = 0
+    
+    let defaultCompression = RGLockbox.valueCompression
+    
+    let magic:[UInt8] = [ 0x89, 0x52, 0x47, 0x5a ]
+    
+    override class func initialize() {
+        rg_SecItemCopyMatch = { query, value in
+            RGLockbox_CompressionSpec.backendReads += 1
+            return replacementItemCopy(query, value)
+        }
+        rg_SecItemAdd = replacementAddItem
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
+    }
+    
+    override func setUp() {
+        RGLockbox().setData(nil, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        RGLockbox_CompressionSpec.backendReads = 0
+        RGLockbox.valueCompression = .zlib
+    }
+    
+    override func tearDown() {
+        RGLockbox.valueCompression = self.defaultCompression
+        RGLockbox.readsCompressedValues = false
+        RGLockbox().setData(nil, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    func profile() -> Any {
+        var entries:[[String:Any]] = []
+        for index in 0 ..< 200 {
+            entries.append([ "id" : index, "name" : "user \(index)", "email" : "user\(index)@example.com",
+                             "verified" : index % 2 == 0, "roles" : [ "reader", "writer" ] ])
+        }
+        return [ "version" : 3, "entries" : entries ]
+    }
+    
+    func storedValue() -> Data? {
+        keychainLock.lock()
+        let value = theKeychainLol[RGMultiKey(withFirst: "\(RGLockbox.bundleIdentifier!).\(kTestKey)")]
+        keychainLock.unlock()
+        return value
+    }
+    
+    func header(of data:Data?) -> [UInt8] {
+        return data.map({ [UInt8]($0.prefix(6)) }) ?? []
+    }
+    
+    func roundTrip(_ data:Data) -> Data? {
+        RGLockbox().setData(data, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        return RGLockbox().dataForKey(kTestKey)
+    }
+    
+    func testZlibRoundTrip() {
+        let data = try! JSONSerialization.data(withJSONObject: self.profile())
+        XCTAssert(self.roundTrip(data) == data)
+        XCTAssert(self.storedValue()!.count < data.count / 4)
+        XCTAssert(self.header(of: self.storedValue()) == self.magic + [ 1, 1 ])
+    }
+    
+    func testLZ4RoundTrip() {
+        RGLockbox.valueCompression = .lz4
+        let data = try! JSONSerialization.data(withJSONObject: self.profile())
+        XCTAssert(self.roundTrip(data) == data)
+        XCTAssert(self.storedValue()!.count < data.count)
+        XCTAssert(self.header(of: self.storedValue()) == self.magic + [ 1, 2 ])
+    }
+    
+    func testJSONObjectRoundTrip() {
+        try! RGLockbox().setJSONObject(self.profile(), key: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        let object = RGLockbox().JSONObjectForKey(kTestKey) as? [String:Any]
+        XCTAssert((object?["entries"] as? [Any])?.count == 200)
+    }
+    
+    func testSmallValueStoredAsIs() {
+        let data = "abcd".data(using: String.Encoding.utf8)!
+        XCTAssert(self.roundTrip(data) == data)
+        XCTAssert(self.storedValue() == data)
+    }
+    
+    func testCompressionDisabled() {
+        RGLockbox.valueCompression = .none
+        let data = try! JSONSerialization.data(withJSONObject: self.profile())
+        XCTAssert(self.roundTrip(data) == data)
+        XCTAssert(self.storedValue() == data)
+    }
+    
+    func testCompressionDisabledStoresHeaderAsIs() {
+        RGLockbox.valueCompression = .none
+        let data = Data(bytes: self.magic + [ 1, 0, 0x02, 0x00, 0x00, 0x00, 0x01, 0x02 ])
+        XCTAssert(self.roundTrip(data) == data)
+        XCTAssert(self.storedValue() == data)
+    }
+    
+    func testCompressedValueReadAfterDisabling() {
+        let data = try! JSONSerialization.data(withJSONObject: self.profile())
+        _ = self.roundTrip(data)
+        RGLockbox.valueCompression = .none
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox().dataForKey(kTestKey) != data)
+        RGLockbox.readsCompressedValues = true
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox().dataForKey(kTestKey) == data)
+    }
+    
+    func testIncompressibleValueStoredAsIs() {
+        var data = Data(bytes: (0 ..< 1024).map({ _ in UInt8(truncatingBitPattern: arc4random()) }))
+        data[0] = 0
+        XCTAssert(self.roundTrip(data) == data)
+        XCTAssert(self.storedValue() == data)
+    }
+    
+    func testValueResemblingHeaderRoundTrips() {
+        let data = Data(bytes: self.magic + [ 1, 1, 0x03, 0x00, 0x00, 0x00, 0x01, 0x02 ])
+        XCTAssert(self.roundTrip(data) == data)
+        XCTAssert(self.header(of: self.storedValue()) == self.magic + [ 1, 0 ])
+    }
+    
+    func testLegacyItemReadAsIs() {
+        let legacy = Data(bytes: self.magic + [ 1, 1, 0x10, 0x00, 0x00, 0x00, 0xff, 0xfe, 0xfd ])
+        keychainLock.lock()
+        theKeychainLol[RGMultiKey(withFirst: "\(RGLockbox.bundleIdentifier!).\(kTestKey)")] = legacy
+        keychainLock.unlock()
+        RGLockbox.invalidateMembershipFilters()
+        XCTAssert(RGLockbox().dataForKey(kTestKey) == legacy)
+    }
+    
+    func testImplausibleLengthReadAsIs() {
+        let damaged = Data(bytes: self.magic + [ 1, 1, 0xff, 0xff, 0xff, 0xff, 0x78, 0x9c ])
+        keychainLock.lock()
+        theKeychainLol[RGMultiKey(withFirst: "\(RGLockbox.bundleIdentifier!).\(kTestKey)")] = damaged
+        keychainLock.unlock()
+        RGLockbox.invalidateMembershipFilters()
+        XCTAssert(RGLockbox().dataForKey(kTestKey) == damaged)
+    }
+    
+    func testDecompressedValueCached() {
+        let data = try! JSONSerialization.data(withJSONObject: self.profile())
+        _ = self.roundTrip(data)
+        let reads = RGLockbox_CompressionSpec.backendReads
+        XCTAssert(RGLockbox().dataForKey(kTestKey) == data)
+        XCTAssert(RGLockbox_CompressionSpec.backendReads == reads)
+    }
+    
+// MARK: - Benchmarks
+    
+    func measureWrite(_ compression:RGValueCompression) {
+        RGLockbox.valueCompression = compression
+        let data = try! JSONSerialization.data(withJSONObject: self.profile())
+        RGLockbox().setData(data, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        print("\(compression) stores \(data.count) bytes in \(self.storedValue()!.count) bytes, ratio " +
+            "\(Double(data.count) / Double(self.storedValue()!.count))")
+        var round = 0
+        self.measure {
+            round += 1
+            var copy = data
+            copy[1] = UInt8(truncatingBitPattern: round)
+            RGLockbox().setData(copy, forKey: kTestKey)
+            RGLockbox.keychainQueue.sync {}
+        }
+    }
+    
+    func measureRead(_ compression:RGValueCompression) {
+        RGLockbox.valueCompression = compression
+        let data = try! JSONSerialization.data(withJSONObject: self.profile())
+        RGLockbox().setData(data, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        self.measure {
+            for _ in 0 ..< 10 {
+                RGLockbox.removeAllCachedValues()
+                _ = RGLockbox().dataForKey(kTestKey)
+            }
+        }
+    }
+    
+    func testWriteUncompressed() { self.measureWrite(.none) }
+    func testWriteZlib() { self.measureWrite(.zlib) }
+    func testWriteLZ4() { self.measureWrite(.lz4) }
+    
+    func testReadUncompressed() { self.measureRead(.none) }
+    func testReadZlib() { self.measureRead(.zlib) }
+    func testReadLZ4() { self.measureRead(.lz4) }
+}
@@ -16,12 +16,12 @@ class RGLockbox_ConvenienceSpec : XCTestCase {
     
     override func setUp() {
         RGLockbox().setData(nil, forKey: kTestKey)
-        RGLockbox.valueCache.removeAll()
+        RGLockbox.removeAllCachedValues()
     }
     
     override func tearDown() {
         RGLockbox().setData(nil, forKey: kTestKey)
-        RGLockbox.valueCache.removeAll()
+        RGLockbox.removeAllCachedValues()
     }
 
     func testGetJSONNil() {
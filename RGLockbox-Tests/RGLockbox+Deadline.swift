@@ -0,0 +1,120 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+class RGLockbox_DeadlineSpec : XCTestCase {
+    
+    let path = NSTemporaryDirectory() + "RGLockbox.deadline.generations"
+    
+    override class func initialize() {
+        rg_SecItemCopyMatch = replacementItemCopy
+        rg_SecItemAdd = replacementAddItem
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
+    }
+    
+    override func setUp() {
+        RGLockbox.keychainQueue.sync {}
+        keychainLock.lock()
+        theKeychainLol.removeAll()
+        theKeychainAttributes.removeAll()
+        keychainLock.unlock()
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    override func tearDown() {
+        replacementDelay = 0
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.generationTable = nil
+        try? FileManager.default.removeItem(atPath: self.path)
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    func testCachedValueReturnsAtOnce() {
+        RGLockbox().setString("abcd", key: kTestKey)
+        replacementDelay = 0.5
+        let result = RGLockbox().stringForKey(kTestKey, deadline: Date())
+        guard case .value(let value) = result else {
+            return XCTFail("expected a current value, got \(result)")
+        }
+        XCTAssert(value == "abcd")
+    }
+    
+    func testMissReadsWithinDeadline() {
+        RGLockbox().setString("abcd", key: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        let result = RGLockbox().stringForKey(kTestKey, deadline: Date(timeIntervalSinceNow: 5))
+        XCTAssert(result.value == "abcd" && !result.isTimedOut)
+        XCTAssert(RGLockbox().dataForKey(kKey1, deadline: Date(timeIntervalSinceNow: 5)).value == nil)
+    }
+    
+    func testSlowMissTimesOutAndFillsCache() {
+        RGLockbox().setString("abcd", key: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        let expirations = RGLockbox.deadlineExpirationCount
+        replacementDelay = 0.3
+        let start = Date()
+        let result = RGLockbox().stringForKey(kTestKey, deadline: Date(timeIntervalSinceNow: 0.05))
+        XCTAssert(Date().timeIntervalSince(start) < 0.25)
+        XCTAssert(result.isTimedOut)
+        XCTAssert(RGLockbox.deadlineExpirationCount == expirations + 1)
+        RGLockbox.keychainQueue.sync {}
+        Thread.sleep(forTimeInterval: 0.05)
+        XCTAssert(RGLockbox().stringForKey(kTestKey, deadline: Date()).value == "abcd")
+    }
+    
+    func testStaleValueAfterOtherProcessWrite() {
+        RGLockbox.generationTable = RGGenerationTable(path: self.path)
+        let other = RGGenerationTable(path: self.path)!
+        RGLockbox().setString("abcd", key: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        let service = "\(RGLockbox.bundleIdentifier!).\(kTestKey)"
+        rg_external_write("efgh".data(using: String.Encoding.utf8)!, service: service)
+        other.advance(RGMultiKey(withFirst: service))
+        replacementDelay = 0.3
+        let result = RGLockbox().stringForKey(kTestKey, deadline: Date(timeIntervalSinceNow: 0.05))
+        guard case .stale(let value) = result else {
+            return XCTFail("expected a stale value, got \(result)")
+        }
+        XCTAssert(value == "abcd")
+        replacementDelay = 0
+        XCTAssert(RGLockbox().stringForKey(kTestKey, deadline: Date(timeIntervalSinceNow: 5)).value == "efgh")
+    }
+    
+    func testConcurrentReadsShareBackgroundRead() {
+        RGLockbox().setString("abcd", key: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        replacementDelay = 0.1
+        let start = Date()
+        DispatchQueue.concurrentPerform(iterations: 8, execute: { _ in
+            XCTAssert(RGLockbox().stringForKey(kTestKey, deadline: Date(timeIntervalSinceNow: 5)).value == "abcd")
+        })
+        XCTAssert(Date().timeIntervalSince(start) < 0.5)
+    }
+}
@@ -0,0 +1,175 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+class RGLockbox_DeferredWritesSpec : XCTestCase {
+    
+    override class func initialize() {
+        rg_SecItemCopyMatch = replacementItemCopy
+        rg_SecItemAdd = replacementAddItem
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
+    }
+    
+    override func setUp() {
+        RGLockbox().setData(nil, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    override func tearDown() {
+        replacementStatusOverride = nil
+        RGLockbox.deferredWriteFailed = nil
+        RGLockbox.deferredWriteMaxAttempts = 10
+        RGLockbox.retryDeferredWrites()
+        RGLockbox().setData(nil, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    func storedValue() -> Data? {
+        keychainLock.lock()
+        let value = theKeychainLol[RGMultiKey(withFirst: "\(RGLockbox.bundleIdentifier!).\(kTestKey)")]
+        keychainLock.unlock()
+        return value
+    }
+    
+    func testLockedWriteIsParked() {
+        replacementStatusOverride = errSecInteractionNotAllowed
+        RGLockbox().setString("abcd", key: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(RGLockbox.deferredWriteCount == 1)
+        XCTAssert(self.storedValue() == nil)
+    }
+    
+    func testReadsServeParkedValue() {
+        replacementStatusOverride = errSecInteractionNotAllowed
+        RGLockbox().setString("abcd", key: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox().stringForKey(kTestKey) == "abcd")
+    }
+    
+    func testNewerWriteSupersedes() {
+        replacementStatusOverride = errSecInteractionNotAllowed
+        RGLockbox().setString("abcd", key: kTestKey)
+        RGLockbox().setString("qwer", key: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(RGLockbox.deferredWriteCount == 1)
+        replacementStatusOverride = nil
+        NotificationCenter.default.post(name: RGApplicationProtectedDataDidBecomeAvailable, object: nil)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(RGLockbox.deferredWriteCount == 0)
+        XCTAssert(self.storedValue() == "qwer".data(using: String.Encoding.utf8))
+    }
+    
+    func testSuccessfulWriteResolvesParkedWrite() {
+        replacementStatusOverride = errSecInteractionNotAllowed
+        RGLockbox().setString("abcd", key: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        replacementStatusOverride = nil
+        RGLockbox().setString("qwer", key: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(RGLockbox.deferredWriteCount == 0)
+        XCTAssert(self.storedValue() == "qwer".data(using: String.Encoding.utf8))
+    }
+    
+    func testFinalFailureCallback() {
+        var failedKey:RGMultiKey? = nil
+        var failedStatus:OSStatus = errSecSuccess
+        RGLockbox.deferredWriteMaxAttempts = 1
+        RGLockbox.deferredWriteFailed = { fullKey, status in
+            failedKey = fullKey
+            failedStatus = status
+        }
+        replacementStatusOverride = errSecInteractionNotAllowed
+        RGLockbox().setString("abcd", key: kTestKey)
+        RGLockbox.retryDeferredWrites()
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(RGLockbox.deferredWriteCount == 0)
+        XCTAssert(failedKey?.first == "\(RGLockbox.bundleIdentifier!).\(kTestKey)")
+        XCTAssert(failedStatus == errSecInteractionNotAllowed)
+    }
+    
+    func testParkedWritesSaved() {
+        let url = URL(fileURLWithPath: NSTemporaryDirectory()).appendingPathComponent("\(UUID().uuidString).plist")
+        RGLockbox.deferredWritesURL = url
+        replacementStatusOverride = errSecInteractionNotAllowed
+        RGLockbox().setString("abcd", key: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.deferredWritesURL = nil
+        let data = try! Data(contentsOf: url)
+        let plist = try! PropertyListSerialization.propertyList(from: data, options: [], format: nil) as! [[String:Any]]
+        XCTAssert(plist.count == 1)
+        XCTAssert(plist.first?["service"] as? String == "\(RGLockbox.bundleIdentifier!).\(kTestKey)")
+        XCTAssert(plist.first?["data"] as? Data == "abcd".data(using: String.Encoding.utf8))
+        try? FileManager.default.removeItem(at: url)
+    }
+    
+    func testSavedWritesRestored() {
+        let url = URL(fileURLWithPath: NSTemporaryDirectory()).appendingPathComponent("\(UUID().uuidString).plist")
+        let plist:[[String:Any]] = [[
+            "service" : "\(RGLockbox.bundleIdentifier!).\(kTestKey)",
+            "data" : "qwer".data(using: String.Encoding.utf8)!,
+            "accessibility" : kSecAttrAccessibleAfterFirstUnlock as String,
+            "synchronized" : false
+        ]]
+        let data = try! PropertyListSerialization.data(fromPropertyList: plist, format: .binary, options: 0)
+        try! data.write(to: url)
+        RGLockbox.deferredWritesURL = url
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.deferredWritesURL = nil
+        XCTAssert(self.storedValue() == "qwer".data(using: String.Encoding.utf8))
+        try? FileManager.default.removeItem(at: url)
+    }
+    
+    func testUnreadableSavedWritesKept() {
+        let url = URL(fileURLWithPath: NSTemporaryDirectory()).appendingPathComponent("\(UUID().uuidString).plist")
+        let plist:[[String:Any]] = [[
+            "service" : "\(RGLockbox.bundleIdentifier!).\(kKey1)",
+            "data" : "qwer".data(using: String.Encoding.utf8)!,
+            "accessibility" : kSecAttrAccessibleAfterFirstUnlock as String,
+            "synchronized" : false
+        ]]
+        let data = try! PropertyListSerialization.data(fromPropertyList: plist, format: .binary, options: 0)
+        try! data.write(to: url)
+        try! FileManager.default.setAttributes([ .posixPermissions : 0 ], ofItemAtPath: url.path)
+        replacementStatusOverride = errSecInteractionNotAllowed
+        RGLockbox.deferredWritesURL = url
+        RGLockbox().setString("abcd", key: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(RGLockbox.deferredWriteCount == 1)
+        try! FileManager.default.setAttributes([ .posixPermissions : 0o600 ], ofItemAtPath: url.path)
+        replacementStatusOverride = nil
+        RGLockbox.retryDeferredWrites()
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.deferredWritesURL = nil
+        XCTAssert(self.storedValue() == "abcd".data(using: String.Encoding.utf8))
+        XCTAssert(RGLockbox().stringForKey(kKey1) == "qwer")
+        RGLockbox().setData(nil, forKey: kKey1)
+        try? FileManager.default.removeItem(at: url)
+    }
+}
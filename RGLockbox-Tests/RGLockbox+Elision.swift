@@ -0,0 +1,111 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+class RGLockbox_ElisionSpec : XCTestCase {
+    
+    override class func initialize() {
+        rg_SecItemCopyMatch = replacementItemCopy
+        rg_SecItemAdd = replacementAddItem
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
+    }
+    
+    override func setUp() {
+        RGLockbox().setData(nil, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    override func tearDown() {
+        RGLockbox().setData(nil, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    func testSameValueElided() {
+        RGLockbox().setString("abcd", key: kTestKey)
+        let count = RGLockbox.elidedWriteCount
+        RGLockbox().setString("abcd", key: kTestKey)
+        XCTAssert(RGLockbox.elidedWriteCount == count + 1)
+        XCTAssert(RGLockbox().stringForKey(kTestKey) == "abcd")
+    }
+    
+    func testDifferentValueWritten() {
+        RGLockbox().setString("abcd", key: kTestKey)
+        let count = RGLockbox.elidedWriteCount
+        RGLockbox().setString("qwer", key: kTestKey)
+        XCTAssert(RGLockbox.elidedWriteCount == count)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox().stringForKey(kTestKey) == "qwer")
+    }
+    
+    func testEvictedValueWritten() {
+        RGLockbox().setString("abcd", key: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        let count = RGLockbox.elidedWriteCount
+        RGLockbox().setString("abcd", key: kTestKey)
+        XCTAssert(RGLockbox.elidedWriteCount == count)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.purge(.allExceptPinned)
+        RGLockbox().setString("abcd", key: kTestKey)
+        XCTAssert(RGLockbox.elidedWriteCount == count)
+    }
+    
+    func testReadValueElided() {
+        RGLockbox().setString("abcd", key: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox().stringForKey(kTestKey) == "abcd")
+        let count = RGLockbox.elidedWriteCount
+        RGLockbox().setString("abcd", key: kTestKey)
+        XCTAssert(RGLockbox.elidedWriteCount == count + 1)
+    }
+    
+    func testRemovingAbsentValueElided() {
+        XCTAssert(RGLockbox().dataForKey(kTestKey) == nil)
+        let count = RGLockbox.elidedWriteCount
+        RGLockbox().setData(nil, forKey: kTestKey)
+        XCTAssert(RGLockbox.elidedWriteCount == count + 1)
+    }
+    
+    func testChangedAttributesWritten() {
+        RGLockbox().setString("abcd", key: kTestKey)
+        let count = RGLockbox.elidedWriteCount
+        RGLockbox(accessibility: kSecAttrAccessibleAlways).setString("abcd", key: kTestKey)
+        RGLockbox(synchronized: true).setString("abcd", key: kTestKey)
+        XCTAssert(RGLockbox.elidedWriteCount == count)
+    }
+    
+    func testTimeToLiveWritten() {
+        RGLockbox().setString("abcd", key: kTestKey)
+        let count = RGLockbox.elidedWriteCount
+        RGLockbox().setData("abcd".data(using: String.Encoding.utf8), forKey: kTestKey, ttl: 3600)
+        XCTAssert(RGLockbox.elidedWriteCount == count)
+    }
+}
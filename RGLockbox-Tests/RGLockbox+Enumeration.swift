@@ -0,0 +1,122 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+let kEnumerationNamespace = "com.rglockbox.enumeration"
+
+class RGLockbox_EnumerationSpec : XCTestCase {
+    
+    static var enumerationHook:(() -> Void)? = nil
+    
+    override class func initialize() {
+        rg_SecItemCopyMatch = { query, value in
+            let status = replacementItemCopy(query, value)
+            if CFDictionaryGetValue(query, Unmanaged.passUnretained(kSecAttrService).toOpaque()) == nil {
+                RGLockbox_EnumerationSpec.enumerationHook?()
+            }
+            return status
+        }
+        rg_SecItemAdd = replacementAddItem
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
+    }
+    
+    override func setUp() {
+        RGLockbox.keychainQueue.sync {}
+        keychainLock.lock()
+        theKeychainLol.removeAll()
+        theKeychainAttributes.removeAll()
+        keychainLock.unlock()
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    override func tearDown() {
+        RGLockbox_EnumerationSpec.enumerationHook = nil
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    func populate(_ count:Int) {
+        keychainLock.lock()
+        for index in 0 ..< count {
+            let key = RGMultiKey(withFirst: "\(kEnumerationNamespace).key\(index)")
+            theKeychainLol[key] = "value\(index)".data(using: String.Encoding.utf8)!
+            theKeychainAttributes[key] = [ kSecAttrAccessible as String : kSecAttrAccessibleAfterFirstUnlock ]
+        }
+        keychainLock.unlock()
+    }
+    
+    func testAllItemsAcrossBatches() {
+        self.populate(1000)
+        let items = RGLockbox(withNamespace: kEnumerationNamespace).allItems()
+        XCTAssert(items.count == 1000)
+        XCTAssert(Set(items) == Set((0 ..< 1000).map({ "key\($0)" })))
+    }
+    
+    func testEnumerationFillsCache() {
+        self.populate(1000)
+        let manager = RGLockbox(withNamespace: kEnumerationNamespace)
+        _ = manager.allItems()
+        keychainLock.lock()
+        theKeychainLol.removeAll()
+        keychainLock.unlock()
+        XCTAssert(manager.stringForKey("key0") == "value0")
+        XCTAssert(manager.stringForKey("key999") == "value999")
+    }
+    
+    func testOtherNamespacesNotReported() {
+        self.populate(10)
+        RGLockbox().setString("abcd", key: kKey1)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(RGLockbox(withNamespace: kEnumerationNamespace).allItems().count == 10)
+    }
+    
+    func testConcurrentWriteNotOverwritten() {
+        self.populate(10)
+        let manager = RGLockbox(withNamespace: kEnumerationNamespace)
+        RGLockbox_EnumerationSpec.enumerationHook = {
+            RGLockbox_EnumerationSpec.enumerationHook = nil
+            manager.setString("newer", key: "key1")
+        }
+        _ = manager.allItems()
+        XCTAssert(manager.stringForKey("key1") == "newer")
+        XCTAssert(manager.stringForKey("key2") == "value2")
+    }
+    
+// MARK: - Benchmarks
+    
+    func measureAllItems(_ count:Int) {
+        self.populate(count)
+        let manager = RGLockbox(withNamespace: kEnumerationNamespace)
+        self.measure {
+            RGLockbox.removeAllCachedValues()
+            XCTAssert(manager.allItems().count == count)
+        }
+    }
+    
+    func testAllItems10k() { self.measureAllItems(10000) }
+    func testAllItems100k() { self.measureAllItems(100000) }
+}
@@ -0,0 +1,225 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+class RGLockbox_EnvelopeSpec : XCTestCase {
+    
+    let defaultChunkSize = RGLockbox.chunkSize
+    let directory = URL(fileURLWithPath: NSTemporaryDirectory()).appendingPathComponent("RGLockbox.envelopes")
+    
+    override class func initialize() {
+        rg_SecItemCopyMatch = replacementItemCopy
+        rg_SecItemAdd = replacementAddItem
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
+    }
+    
+    override func setUp() {
+        RGLockbox.keychainQueue.sync {}
+        keychainLock.lock()
+        theKeychainLol.removeAll()
+        theKeychainAttributes.removeAll()
+        keychainLock.unlock()
+        RGLockbox.removeAllCachedValues()
+        try? FileManager.default.removeItem(at: self.directory)
+        try! FileManager.default.createDirectory(at: self.directory, withIntermediateDirectories: true, attributes: nil)
+        RGLockbox.envelopeDirectory = self.directory
+    }
+    
+    override func tearDown() {
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.envelopeDirectory = nil
+        RGLockbox.chunkSize = self.defaultChunkSize
+        RGLockbox.removeAllCachedValues()
+        try? FileManager.default.removeItem(at: self.directory)
+    }
+    
+    func value(_ length:Int) -> Data {
+        return Data(bytes: (0 ..< length).map({ UInt8(truncatingBitPattern: $0 &* 31 &+ $0 >> 8) }))
+    }
+    
+    func fileCount() -> Int {
+        return try! FileManager.default.contentsOfDirectory(atPath: self.directory.path).count
+    }
+    
+    func storedItem(_ key:String) -> Data? {
+        keychainLock.lock()
+        defer {
+            keychainLock.unlock()
+        }
+        return theKeychainLol[RGMultiKey(withFirst: "\(RGLockbox.bundleIdentifier!).\(key)")]
+    }
+    
+    func testRoundTrip() {
+        let value = self.value(100 * 1024)
+        RGLockbox().setData(value, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(self.fileCount() == 1)
+        XCTAssert(self.storedItem(kTestKey)!.count < 512)
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox().dataForKey(kTestKey) == value)
+    }
+    
+    func testFileIsEncrypted() {
+        let value = Data(count: 64 * 1024)
+        RGLockbox().setData(value, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        let name = try! FileManager.default.contentsOfDirectory(atPath: self.directory.path).first!
+        let file = try! Data(contentsOf: self.directory.appendingPathComponent(name))
+        XCTAssert(file.count == value.count)
+        XCTAssert(file != value)
+    }
+    
+    func testRangedRead() {
+        let value = self.value(100 * 1024)
+        RGLockbox().setData(value, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        for range in [ 0 ..< 10, 63 ..< 65, 50_001 ..< 70_003, 100 * 1024 - 1 ..< 100 * 1024 ] {
+            XCTAssert(RGLockbox().dataForKey(kTestKey, range: range) == value.subdata(in: range))
+        }
+        XCTAssert(RGLockbox().dataForKey(kTestKey, range: 200 * 1024 ..< 300 * 1024) == Data())
+    }
+    
+    func testSmallValuesStayInKeychain() {
+        RGLockbox().setString("abcd", key: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(self.fileCount() == 0)
+        XCTAssert(RGLockbox().stringForKey(kTestKey) == "abcd")
+    }
+    
+    func testReplaceRemovesFile() {
+        RGLockbox().setData(self.value(100 * 1024), forKey: kTestKey)
+        RGLockbox().setData(self.value(200 * 1024), forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(self.fileCount() == 1)
+        RGLockbox().setString("abcd", key: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(self.fileCount() == 0)
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox().stringForKey(kTestKey) == "abcd")
+    }
+    
+    func testRemoveDeletesFile() {
+        RGLockbox().setData(self.value(100 * 1024), forKey: kTestKey)
+        RGLockbox().setData(nil, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(self.fileCount() == 0)
+        XCTAssert(self.storedItem(kTestKey) == nil)
+    }
+    
+    func testUnchangedWriteKeepsFile() {
+        let value = self.value(100 * 1024)
+        RGLockbox().setData(value, forKey: kTestKey)
+        RGLockbox().setData(value, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(self.fileCount() == 1)
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox().dataForKey(kTestKey) == value)
+    }
+    
+    func testTamperedFileFails() {
+        RGLockbox().setData(self.value(100 * 1024), forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        let name = try! FileManager.default.contentsOfDirectory(atPath: self.directory.path).first!
+        var file = try! Data(contentsOf: self.directory.appendingPathComponent(name))
+        file[1000] ^= 1
+        try! file.write(to: self.directory.appendingPathComponent(name))
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox().dataForKey(kTestKey) == nil)
+    }
+    
+    func testFileChangedAfterReadFails() {
+        let value = self.value(100 * 1024)
+        RGLockbox().setData(value, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox().dataForKey(kTestKey) == value)
+        let url = self.directory.appendingPathComponent(try! FileManager.default.contentsOfDirectory(atPath:
+            self.directory.path).first!)
+        var file = try! Data(contentsOf: url)
+        file[1000] ^= 1
+        try! file.write(to: url)
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox().dataForKey(kTestKey) == nil)
+    }
+    
+    func testConcurrentlyCreatedKeyKept() {
+        let namespace = "com.rglockbox.envelope.concurrent"
+        let keyItem = RGMultiKey(withFirst: "RGLockbox.envelope.\(namespace)")
+        let otherKey = Data(bytes: [UInt8](repeating: 7, count: 32))
+        rg_SecItemAdd = { query in
+            keychainLock.lock()
+            if theKeychainLol[keyItem] == nil {
+                theKeychainLol[keyItem] = otherKey
+            }
+            keychainLock.unlock()
+            return replacementAddItem(query)
+        }
+        let value = self.value(100 * 1024)
+        RGLockbox(withNamespace: namespace).setData(value, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        rg_SecItemAdd = replacementAddItem
+        keychainLock.lock()
+        let storedKey = theKeychainLol[keyItem]
+        keychainLock.unlock()
+        XCTAssert(storedKey == otherKey)
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox(withNamespace: namespace).dataForKey(kTestKey) == value)
+    }
+    
+    func testKeyItemNotEnumerated() {
+        RGLockbox(withNamespace: nil).setData(self.value(100 * 1024), forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(RGLockbox(withNamespace: nil).allItems() == [ kTestKey ])
+        RGLockbox(withNamespace: nil).setData(nil, forKey: kTestKey)
+    }
+    
+// MARK: - Benchmarks
+    
+    func testEnvelopeAgainstKeychain() {
+        RGLockbox.chunkSize = Int.max
+        for length in [ 100 * 1024, 1024 * 1024, 10 * 1024 * 1024 ] {
+            var results:[String] = []
+            for directory in [ nil, self.directory ] {
+                RGLockbox.envelopeDirectory = directory
+                let value = self.value(length)
+                var start = Date()
+                RGLockbox().setData(value, forKey: kTestKey)
+                RGLockbox.keychainQueue.sync {}
+                let write = Date().timeIntervalSince(start)
+                RGLockbox.removeAllCachedValues()
+                start = Date()
+                XCTAssert(RGLockbox().dataForKey(kTestKey) == value)
+                let read = Date().timeIntervalSince(start)
+                results.append("write \(Int(write * 1000)) ms read \(Int(read * 1000)) ms")
+                RGLockbox().setData(nil, forKey: kTestKey)
+                RGLockbox.keychainQueue.sync {}
+            }
+            print("RGLockbox \(length / 1024) KB: keychain \(results[0]), envelope \(results[1])")
+        }
+    }
+}
@@ -0,0 +1,120 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+class RGLockbox_ExpirySpec : XCTestCase {
+    
+    override class func initialize() {
+        rg_SecItemCopyMatch = replacementItemCopy
+        rg_SecItemAdd = replacementAddItem
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
+    }
+    
+    override func setUp() {
+        RGLockbox().setData(nil, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    override func tearDown() {
+        RGLockbox().setData(nil, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    func testReadBeforeExpiry() {
+        RGLockbox().setData("abcd".data(using: String.Encoding.utf8), forKey: kTestKey, ttl: 3600)
+        XCTAssert(RGLockbox().dataForKey(kTestKey) == "abcd".data(using: String.Encoding.utf8))
+    }
+    
+    func testExpiredReadsAbsent() {
+        RGLockbox().setData("abcd".data(using: String.Encoding.utf8), forKey: kTestKey, ttl: -1)
+        XCTAssert(RGLockbox().dataForKey(kTestKey) == nil)
+    }
+    
+    func testExpiryStoredWithItem() {
+        RGLockbox().setData("abcd".data(using: String.Encoding.utf8), forKey: kTestKey, ttl: 3600)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox().dataForKey(kTestKey) == "abcd".data(using: String.Encoding.utf8))
+        let service = RGMultiKey(withFirst: "\(RGLockbox.bundleIdentifier!).\(kTestKey)")
+        keychainLock.lock()
+        let generic = theKeychainAttributes[service]?[kSecAttrGeneric as String]
+        keychainLock.unlock()
+        XCTAssert(generic != nil)
+    }
+    
+    func testExpiredInKeychainReadsAbsent() {
+        RGLockbox().setData("abcd".data(using: String.Encoding.utf8), forKey: kTestKey, ttl: 0.2)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        Thread.sleep(forTimeInterval: 0.3)
+        XCTAssert(RGLockbox().dataForKey(kTestKey) == nil)
+        XCTAssert(RGLockbox().allItems().contains(kTestKey) == false)
+    }
+    
+    func testPlainWriteClearsExpiry() {
+        RGLockbox().setData("abcd".data(using: String.Encoding.utf8), forKey: kTestKey, ttl: -1)
+        RGLockbox().setData("qwer".data(using: String.Encoding.utf8), forKey: kTestKey)
+        XCTAssert(RGLockbox().dataForKey(kTestKey) == "qwer".data(using: String.Encoding.utf8))
+    }
+    
+    func testReaperDeletesFromKeychain() {
+        let service = RGMultiKey(withFirst: "\(RGLockbox.bundleIdentifier!).\(kTestKey)")
+        RGLockbox().setData("abcd".data(using: String.Encoding.utf8), forKey: kTestKey, ttl: 0.5)
+        RGLockbox.keychainQueue.sync {}
+        let reaped = self.expectation(description: "expired item deleted")
+        DispatchQueue.global().asyncAfter(deadline: .now() + 3, execute: {
+            RGLockbox.keychainQueue.sync {}
+            keychainLock.lock()
+            let storedValue = theKeychainLol[service]
+            keychainLock.unlock()
+            XCTAssert(storedValue == nil)
+            reaped.fulfill()
+        })
+        self.waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testReaperKeepsRewrittenItem() {
+        let service = RGMultiKey(withFirst: "\(RGLockbox.bundleIdentifier!).\(kTestKey)")
+        RGLockbox().setData("abcd".data(using: String.Encoding.utf8), forKey: kTestKey, ttl: 0.5)
+        RGLockbox.keychainQueue.sync {}
+        rg_external_write("qwer".data(using: String.Encoding.utf8)!, service: service.first!)
+        let reaped = self.expectation(description: "rewritten item kept")
+        DispatchQueue.global().asyncAfter(deadline: .now() + 3, execute: {
+            RGLockbox.keychainQueue.sync {}
+            keychainLock.lock()
+            let storedValue = theKeychainLol[service]
+            keychainLock.unlock()
+            XCTAssert(storedValue == "qwer".data(using: String.Encoding.utf8))
+            reaped.fulfill()
+        })
+        self.waitForExpectations(timeout: 5, handler: nil)
+        Thread.sleep(forTimeInterval: 0.1)
+        XCTAssert(RGLockbox().dataForKey(kTestKey) == "qwer".data(using: String.Encoding.utf8))
+    }
+}
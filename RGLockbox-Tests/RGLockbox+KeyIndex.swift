@@ -0,0 +1,163 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+class RGLockbox_KeyIndexSpec : XCTestCase {
+    
+    static var enumerations = 0
+    
+    override class func initialize() {
+        rg_SecItemCopyMatch = { query, value in
+            if (query as NSDictionary)[kSecAttrService as String] == nil {
+                RGLockbox_KeyIndexSpec.enumerations += 1
+            }
+            return replacementItemCopy(query, value)
+        }
+        rg_SecItemAdd = replacementAddItem
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
+    }
+    
+    override func setUp() {
+        RGLockbox.keychainQueue.sync {}
+        keychainLock.lock()
+        theKeychainLol.removeAll()
+        theKeychainAttributes.removeAll()
+        keychainLock.unlock()
+        RGLockbox.invalidateKeyIndexes()
+        RGLockbox.removeAllCachedValues()
+        RGLockbox_KeyIndexSpec.enumerations = 0
+    }
+    
+    override func tearDown() {
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.invalidateKeyIndexes()
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    func writeUsers() {
+        let lockbox = RGLockbox()
+        for user in [ "1", "2", "10" ] {
+            lockbox.setString("token", key: "user.\(user).token")
+            lockbox.setString("refresh", key: "user.\(user).refresh")
+        }
+        lockbox.setString("abcd", key: kKey1)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    func testPrefixQuery() {
+        self.writeUsers()
+        XCTAssert(RGLockbox().keys(withPrefix: "user.1.") == [ "user.1.refresh", "user.1.token" ])
+        XCTAssert(RGLockbox().keys(withPrefix: "user.1") == [ "user.1.refresh", "user.1.token",
+                                                              "user.10.refresh", "user.10.token" ])
+        XCTAssert(RGLockbox().keys(withPrefix: "user.3.") == [])
+        XCTAssert(RGLockbox().keys(withPrefix: "").count == 7)
+    }
+    
+    func testWarmIndexSkipsEnumeration() {
+        self.writeUsers()
+        XCTAssert(RGLockbox().keys(withPrefix: "user.2.").count == 2)
+        XCTAssert(RGLockbox_KeyIndexSpec.enumerations == 1)
+        RGLockbox().setString("token", key: "user.2.id")
+        RGLockbox().setString(nil, key: "user.2.refresh")
+        XCTAssert(RGLockbox().keys(withPrefix: "user.2.") == [ "user.2.id", "user.2.token" ])
+        XCTAssert(RGLockbox().keys(withPrefix: "user.1.").count == 2)
+        XCTAssert(RGLockbox_KeyIndexSpec.enumerations == 1)
+    }
+    
+    func testAllItemsWarmsIndex() {
+        self.writeUsers()
+        XCTAssert(RGLockbox().allItems().count == 7)
+        XCTAssert(RGLockbox().keys(withPrefix: "user.10.").count == 2)
+        XCTAssert(RGLockbox_KeyIndexSpec.enumerations == 1)
+    }
+    
+    func testRemoveAllWithPrefix() {
+        self.writeUsers()
+        XCTAssert(RGLockbox().removeAll(withPrefix: "user.1.") == 2)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox().dataForKey("user.1.token") == nil)
+        XCTAssert(RGLockbox().stringForKey("user.10.token") == "token")
+        XCTAssert(RGLockbox().keys(withPrefix: "user.1.") == [])
+        XCTAssert(RGLockbox().removeAll(withPrefix: "user.1.") == 0)
+        XCTAssert(RGLockbox_KeyIndexSpec.enumerations == 1)
+    }
+    
+    func testNamespacesSeparate() {
+        self.writeUsers()
+        RGLockbox(withNamespace: "other").setString("token", key: "user.1.token")
+        XCTAssert(RGLockbox().keys(withPrefix: "user.1.") == [ "user.1.refresh", "user.1.token" ])
+        XCTAssert(RGLockbox(withNamespace: "other").keys(withPrefix: "user.") == [ "user.1.token" ])
+        XCTAssert(RGLockbox_KeyIndexSpec.enumerations == 1)
+        RGLockbox(withNamespace: "other").setString(nil, key: "user.1.token")
+    }
+    
+    func testExpiredKeysOmitted() {
+        self.writeUsers()
+        XCTAssert(RGLockbox().keys(withPrefix: "user.").count == 6)
+        RGLockbox().setData("abcd".data(using: String.Encoding.utf8)!, forKey: "user.3.token", ttl: 0.1)
+        XCTAssert(RGLockbox().keys(withPrefix: "user.3.") == [ "user.3.token" ])
+        Thread.sleep(forTimeInterval: 0.2)
+        XCTAssert(RGLockbox().keys(withPrefix: "user.3.") == [])
+    }
+    
+    func testExternalWriteAfterInvalidate() {
+        self.writeUsers()
+        XCTAssert(RGLockbox().keys(withPrefix: "user.4.") == [])
+        rg_external_write("abcd".data(using: String.Encoding.utf8)!,
+                          service: "\(RGLockbox.bundleIdentifier!).user.4.token")
+        RGLockbox.invalidateKeyIndexes()
+        XCTAssert(RGLockbox().keys(withPrefix: "user.4.") == [ "user.4.token" ])
+    }
+    
+// MARK: - Benchmarks
+    
+    func measurePrefixQueries(_ indexed:Bool) {
+        let lockbox = RGLockbox()
+        for user in 0 ..< 1000 {
+            lockbox.setItems([ "user.\(user).token" : Data(count: 16), "user.\(user).refresh" : Data(count: 16) ])
+        }
+        RGLockbox.keychainQueue.sync {}
+        _ = lockbox.allItems()
+        self.measure {
+            for user in 0 ..< 100 {
+                if indexed {
+                    XCTAssert(lockbox.keys(withPrefix: "user.\(user).").count == 2)
+                } else {
+                    XCTAssert(lockbox.allItems().filter({ $0.hasPrefix("user.\(user).") }).count == 2)
+                }
+            }
+        }
+        for user in 0 ..< 1000 {
+            lockbox.removeAll(withPrefix: "user.\(user).")
+        }
+    }
+    
+    func testPrefixQueriesIndexed() { self.measurePrefixQueries(true) }
+    func testPrefixQueriesEnumerated() { self.measurePrefixQueries(false) }
+}
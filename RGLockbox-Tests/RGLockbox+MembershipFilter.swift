@@ -0,0 +1,122 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+class RGLockbox_MembershipFilterSpec : XCTestCase {
+    
+    static var backendReads = 0
+    
+    override class func initialize() {
+        rg_SecItemCopyMatch = { query, value in
+            RGLockbox_MembershipFilterSpec.backendReads += 1
+            return replacementItemCopy(query, value)
+        }
+        rg_SecItemAdd = replacementAddItem
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
+    }
+    
+    override func setUp() {
+        RGLockbox.keychainQueue.sync {}
+        keychainLock.lock()
+        theKeychainLol.removeAll()
+        theKeychainAttributes.removeAll()
+        keychainLock.unlock()
+        RGLockbox.isMembershipFilterEnabled = true
+        RGLockbox.removeAllCachedValues()
+        RGLockbox_MembershipFilterSpec.backendReads = 0
+    }
+    
+    override func tearDown() {
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.isMembershipFilterEnabled = false
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    func testMissingKeysSkipBackend() {
+        RGLockbox().setString("abcd", key: kKey1)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.invalidateMembershipFilters()
+        RGLockbox.removeAllCachedValues()
+        RGLockbox_MembershipFilterSpec.backendReads = 0
+        for index in 0 ..< 50 {
+            XCTAssert(RGLockbox().dataForKey("optional\(index)") == nil)
+        }
+        XCTAssert(RGLockbox_MembershipFilterSpec.backendReads < 5)
+        XCTAssert(RGLockbox().stringForKey(kKey1) == "abcd")
+    }
+    
+    func testWrittenKeyVisible() {
+        XCTAssert(RGLockbox().dataForKey(kKey1) == nil)
+        RGLockbox().setString("abcd", key: kKey2)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox().stringForKey(kKey2) == "abcd")
+    }
+    
+    func testWriteVisibleToWiderScope() {
+        XCTAssert(RGLockbox().dataForKey(kKey1) == nil)
+        RGLockbox(withNamespace: RGLockbox.bundleIdentifier, accountName: "account").setString("abcd", key: kKey2)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox().stringForKey(kKey2) == "abcd")
+    }
+    
+    func testExternalWriteAfterInvalidate() {
+        XCTAssert(RGLockbox().dataForKey(kKey1) == nil)
+        rg_external_write("abcd".data(using: String.Encoding.utf8)!, service: "\(RGLockbox.bundleIdentifier!).\(kKey2)")
+        RGLockbox.invalidateMembershipFilters()
+        XCTAssert(RGLockbox().stringForKey(kKey2) == "abcd")
+    }
+    
+    func testUnavailableKeychainBuildsNoFilter() {
+        RGLockbox.invalidateMembershipFilters()
+        replacementStatusOverride = errSecInteractionNotAllowed
+        XCTAssert(RGLockbox().dataForKey(kKey1) == nil)
+        replacementStatusOverride = nil
+        rg_external_write("abcd".data(using: String.Encoding.utf8)!, service: "\(RGLockbox.bundleIdentifier!).\(kKey2)")
+        XCTAssert(RGLockbox().stringForKey(kKey2) == "abcd")
+    }
+    
+// MARK: - Benchmarks
+    
+    func measureColdProbes(_ filtered:Bool) {
+        for index in 0 ..< 100 {
+            RGLockbox().setString("value", key: "present\(index)")
+        }
+        RGLockbox.keychainQueue.sync {}
+        self.measure {
+            RGLockbox.isMembershipFilterEnabled = filtered
+            RGLockbox.removeAllCachedValues()
+            for index in 0 ..< 50 {
+                _ = RGLockbox().dataForKey("optional\(index)")
+            }
+        }
+    }
+    
+    func testColdProbesFiltered() { self.measureColdProbes(true) }
+    func testColdProbesUnfiltered() { self.measureColdProbes(false) }
+}
@@ -0,0 +1,231 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+let kMigrationSource = "com.rglockbox.migration.source"
+let kMigrationDestination = "com.rglockbox.migration.destination"
+
+class RGLockbox_MigrationSpec : XCTestCase {
+    
+    let progressURL = URL(fileURLWithPath: NSTemporaryDirectory()).appendingPathComponent("RGLockbox.migration")
+    
+    override class func initialize() {
+        rg_SecItemCopyMatch = replacementItemCopy
+        rg_SecItemAdd = replacementAddItem
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
+    }
+    
+    override func setUp() {
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.discardPackedItems()
+        keychainLock.lock()
+        theKeychainLol.removeAll()
+        theKeychainAttributes.removeAll()
+        keychainLock.unlock()
+        RGLockbox.removeAllCachedValues()
+        RGLockbox.invalidateMembershipFilters()
+        try? FileManager.default.removeItem(at: self.progressURL)
+    }
+    
+    override func tearDown() {
+        RGLockbox.migrationBatchSize = 100
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.discardPackedItems()
+        RGLockbox.removeAllCachedValues()
+        try? FileManager.default.removeItem(at: self.progressURL)
+    }
+    
+    func stored(_ service:String, account:String? = nil, accessGroup:String? = nil) -> Data? {
+        keychainLock.lock()
+        defer {
+            keychainLock.unlock()
+        }
+        return theKeychainLol[RGMultiKey(withFirst: service, second: account, third: accessGroup)]
+    }
+    
+    func testMoveToNamespace() {
+        let source = RGLockbox(withNamespace: kMigrationSource)
+        source.setString("abcd", key: kKey1)
+        source.setString("qwer", key: kKey2)
+        
+        let destination = RGLockbox(withNamespace: kMigrationDestination)
+        XCTAssert(source.migrate(to: destination) == 2)
+        XCTAssert(self.stored("\(kMigrationSource).\(kKey1)") == nil)
+        XCTAssert(self.stored("\(kMigrationSource).\(kKey2)") == nil)
+        XCTAssert(self.stored("\(kMigrationDestination).\(kKey1)") != nil)
+        XCTAssert(source.dataForKey(kKey1) == nil)
+        XCTAssert(destination.stringForKey(kKey1) == "abcd")
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(destination.stringForKey(kKey2) == "qwer")
+    }
+    
+    func testCopyKeepsSource() {
+        let source = RGLockbox(withNamespace: kMigrationSource)
+        source.setString("abcd", key: kKey1)
+        
+        let destination = RGLockbox(withNamespace: kMigrationDestination)
+        XCTAssert(source.migrate(to: destination, removingSource: false) == 1)
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(source.stringForKey(kKey1) == "abcd")
+        XCTAssert(destination.stringForKey(kKey1) == "abcd")
+    }
+    
+    func testMoveToAccount() {
+        let source = RGLockbox(withNamespace: kMigrationSource)
+        source.setString("abcd", key: kKey1)
+        
+        let destination = RGLockbox(withNamespace: kMigrationSource, accountName: "migrated")
+        XCTAssert(source.migrate(to: destination) == 1)
+        XCTAssert(self.stored("\(kMigrationSource).\(kKey1)") == nil)
+        XCTAssert(self.stored("\(kMigrationSource).\(kKey1)", account: "migrated") != nil)
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(destination.stringForKey(kKey1) == "abcd")
+    }
+    
+    func testMoveFromNilAccountKeepsDestination() {
+        let source = RGLockbox(withNamespace: kMigrationSource)
+        source.setString("abcd", key: kKey1)
+        source.setString("qwer", key: kKey2)
+        
+        let destination = RGLockbox(withNamespace: kMigrationSource, accountName: "migrated")
+        XCTAssert(source.migrate(to: destination) == 2)
+        XCTAssert(self.stored("\(kMigrationSource).\(kKey1)") == nil)
+        XCTAssert(self.stored("\(kMigrationSource).\(kKey1)", account: "migrated") != nil)
+        XCTAssert(self.stored("\(kMigrationSource).\(kKey2)", account: "migrated") != nil)
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(destination.stringForKey(kKey2) == "qwer")
+    }
+    
+    func testMoveToAccessGroup() {
+        let source = RGLockbox(withNamespace: kMigrationSource, accountName: "account")
+        source.setString("abcd", key: kKey1)
+        
+        let destination = RGLockbox(withNamespace: kMigrationSource, accountName: "account", accessGroup: "group")
+        XCTAssert(source.migrate(to: destination) == 1)
+        XCTAssert(self.stored("\(kMigrationSource).\(kKey1)", account: "account") == nil)
+        XCTAssert(self.stored("\(kMigrationSource).\(kKey1)", account: "account", accessGroup: "group") != nil)
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(destination.stringForKey(kKey1) == "abcd")
+    }
+    
+    func testChangesAccessibilityInPlace() {
+        let source = RGLockbox(withNamespace: kMigrationSource)
+        source.setString("abcd", key: kKey1)
+        
+        let destination = RGLockbox(withNamespace: kMigrationSource, accessibility: kSecAttrAccessibleWhenUnlocked)
+        XCTAssert(source.migrate(to: destination) == 1)
+        let service = RGMultiKey(withFirst: "\(kMigrationSource).\(kKey1)")
+        keychainLock.lock()
+        let accessibility = theKeychainAttributes[service]?[kSecAttrAccessible as String] as? String
+        keychainLock.unlock()
+        XCTAssert(accessibility == kSecAttrAccessibleWhenUnlocked as String)
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(destination.stringForKey(kKey1) == "abcd")
+    }
+    
+    func testExpiryPreserved() {
+        let source = RGLockbox(withNamespace: kMigrationSource)
+        source.setData("abcd".data(using: String.Encoding.utf8), forKey: kKey1, ttl: 3600)
+        
+        let destination = RGLockbox(withNamespace: kMigrationDestination)
+        XCTAssert(source.migrate(to: destination) == 1)
+        let service = RGMultiKey(withFirst: "\(kMigrationDestination).\(kKey1)")
+        keychainLock.lock()
+        let generic = theKeychainAttributes[service]?[kSecAttrGeneric as String]
+        keychainLock.unlock()
+        XCTAssert(generic != nil)
+    }
+    
+    func testPackedDestination() {
+        let source = RGLockbox(withNamespace: kMigrationSource)
+        source.setString("abcd", key: kKey1)
+        source.setString("qwer", key: kKey2)
+        
+        let destination = RGLockbox(withNamespace: kMigrationDestination, packed: true)
+        XCTAssert(source.migrate(to: destination) == 2)
+        RGLockbox.discardPackedItems()
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(destination.stringForKey(kKey1) == "abcd")
+        XCTAssert(destination.stringForKey(kKey2) == "qwer")
+        XCTAssert(source.dataForKey(kKey1) == nil)
+    }
+    
+    func testResumesSavedProgress() {
+        let source = RGLockbox(withNamespace: kMigrationSource)
+        source.setString("abcd", key: kKey1)
+        source.setString("qwer", key: kKey2)
+        RGLockbox.keychainQueue.sync {}
+        
+        let destination = RGLockbox(withNamespace: kMigrationDestination)
+        let accessibility = kSecAttrAccessibleAfterFirstUnlock as String
+        let identity = "\(kMigrationSource)|||\(accessibility)|false|false>" +
+                       "\(kMigrationDestination)|||\(accessibility)|false|false>true"
+        let keys = [ kKey1, kKey2 ].sorted()
+        let progress:[String:Any] = [ "identity" : identity, "keys" : keys, "completed" : 1 ]
+        let data = try! PropertyListSerialization.data(fromPropertyList: progress, format: .binary, options: 0)
+        try! data.write(to: self.progressURL)
+        
+        XCTAssert(source.migrate(to: destination, progressURL: self.progressURL) == 1)
+        XCTAssert(self.stored("\(kMigrationDestination).\(keys[0])") == nil)
+        XCTAssert(self.stored("\(kMigrationDestination).\(keys[1])") != nil)
+        XCTAssert(!FileManager.default.fileExists(atPath: self.progressURL.path))
+    }
+    
+    func testIgnoresOtherProgress() {
+        let source = RGLockbox(withNamespace: kMigrationSource)
+        source.setString("abcd", key: kKey1)
+        let progress:[String:Any] = [ "identity" : "other", "keys" : [ kKey1 ], "completed" : 1 ]
+        let data = try! PropertyListSerialization.data(fromPropertyList: progress, format: .binary, options: 0)
+        try! data.write(to: self.progressURL)
+        
+        let destination = RGLockbox(withNamespace: kMigrationDestination)
+        XCTAssert(source.migrate(to: destination, progressURL: self.progressURL) == 1)
+        XCTAssert(destination.stringForKey(kKey1) == "abcd")
+    }
+    
+    func testBatchesInBackground() {
+        RGLockbox.migrationBatchSize = 7
+        let source = RGLockbox(withNamespace: kMigrationSource)
+        for index in 0..<50 {
+            source.setString("value \(index)", key: "item.\(index)")
+        }
+        
+        let destination = RGLockbox(withNamespace: kMigrationDestination)
+        let done = self.expectation(description: "migration")
+        source.migrateInBackground(to: destination, progressURL: self.progressURL, completion: { migrated in
+            XCTAssert(Thread.isMainThread)
+            XCTAssert(migrated == 50)
+            done.fulfill()
+        })
+        self.waitForExpectations(timeout: 10, handler: nil)
+        RGLockbox.removeAllCachedValues()
+        for index in 0..<50 {
+            XCTAssert(destination.stringForKey("item.\(index)") == "value \(index)")
+            XCTAssert(source.dataForKey("item.\(index)") == nil)
+        }
+    }
+}
@@ -0,0 +1,239 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+let kPackedNamespace = "com.rglockbox.packed"
+
+class RGLockbox_PackedSpec : XCTestCase {
+    
+    static var backendReads = 0
+    static var backendWrites = 0
+    
+    override class func initialize() {
+        rg_SecItemCopyMatch = { query, value in
+            RGLockbox_PackedSpec.backendReads += 1
+            return replacementItemCopy(query, value)
+        }
+        rg_SecItemAdd = { query in
+            RGLockbox_PackedSpec.backendWrites += 1
+            return replacementAddItem(query)
+        }
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = { query, attributes in
+            RGLockbox_PackedSpec.backendWrites += 1
+            return replacementUpdateItem(query, attributes)
+        }
+    }
+    
+    override func setUp() {
+        RGLockbox.discardPackedItems()
+        keychainLock.lock()
+        theKeychainLol.removeAll()
+        theKeychainAttributes.removeAll()
+        keychainLock.unlock()
+        RGLockbox.removeAllCachedValues()
+        RGLockbox_PackedSpec.backendReads = 0
+        RGLockbox_PackedSpec.backendWrites = 0
+    }
+    
+    override func tearDown() {
+        replacementStatusOverride = nil
+        RGLockbox.discardPackedItems()
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    func packedManager() -> RGLockbox {
+        return RGLockbox(withNamespace: kPackedNamespace, packed: true)
+    }
+    
+    func reset() {
+        RGLockbox.discardPackedItems()
+        RGLockbox.removeAllCachedValues()
+        RGLockbox_PackedSpec.backendReads = 0
+        RGLockbox_PackedSpec.backendWrites = 0
+    }
+    
+    func testRoundTrip() {
+        self.packedManager().setString("abcd", key: kKey1)
+        self.packedManager().setString("qwer", key: kKey2)
+        self.reset()
+        XCTAssert(self.packedManager().stringForKey(kKey1) == "abcd")
+        XCTAssert(self.packedManager().stringForKey(kKey2) == "qwer")
+        XCTAssert(self.packedManager().allItems() == [ kKey1, kKey2 ].sorted())
+    }
+    
+    func testOneItemInKeychain() {
+        for key in testKeys {
+            self.packedManager().setString(key, key: key)
+        }
+        RGLockbox.flushPackedItems()
+        keychainLock.lock()
+        XCTAssert(theKeychainLol.count == 1)
+        keychainLock.unlock()
+    }
+    
+    func testColdStartReadsOnce() {
+        for key in testKeys {
+            self.packedManager().setString(key, key: key)
+        }
+        self.reset()
+        for key in testKeys {
+            XCTAssert(self.packedManager().stringForKey(key) == key)
+        }
+        XCTAssert(RGLockbox_PackedSpec.backendReads == 1)
+    }
+    
+    func testWritesBatched() {
+        _ = self.packedManager().stringForKey(kKey1)
+        for key in testKeys {
+            self.packedManager().setString(key, key: key)
+        }
+        RGLockbox.flushPackedItems()
+        XCTAssert(RGLockbox_PackedSpec.backendWrites == 1)
+    }
+    
+    func testRemoval() {
+        self.packedManager().setString("abcd", key: kKey1)
+        self.packedManager().setString("qwer", key: kKey2)
+        RGLockbox.flushPackedItems()
+        self.packedManager().setData(nil, forKey: kKey1)
+        self.reset()
+        XCTAssert(self.packedManager().dataForKey(kKey1) == nil)
+        XCTAssert(self.packedManager().stringForKey(kKey2) == "qwer")
+    }
+    
+    func testUnchangedValueElided() {
+        self.packedManager().setString("abcd", key: kKey1)
+        let count = RGLockbox.elidedWriteCount
+        self.packedManager().setString("abcd", key: kKey1)
+        XCTAssert(RGLockbox.elidedWriteCount == count + 1)
+    }
+    
+    func testFlushPreservesOtherWriters() {
+        self.packedManager().setString("abcd", key: kKey1)
+        RGLockbox.flushPackedItems()
+        // another process replaces the item with one holding only kKey2
+        let other = RGLockbox(withNamespace: "\(kPackedNamespace).other", packed: true)
+        other.setString("qwer", key: kKey2)
+        RGLockbox.flushPackedItems()
+        keychainLock.lock()
+        let item = RGMultiKey(withFirst: "\(kPackedNamespace).RGLockbox.packed")
+        theKeychainLol[item] = theKeychainLol[RGMultiKey(withFirst: "\(kPackedNamespace).other.RGLockbox.packed")]
+        keychainLock.unlock()
+        self.packedManager().setString("zxcv", key: kTestKey)
+        self.reset()
+        XCTAssert(self.packedManager().stringForKey(kKey2) == "qwer")
+        XCTAssert(self.packedManager().stringForKey(kTestKey) == "zxcv")
+    }
+    
+    func testFlushWhileLockedKeepsOtherKeys() {
+        self.packedManager().setString("abcd", key: kKey1)
+        self.packedManager().setString("qwer", key: kKey2)
+        self.reset()
+        replacementStatusOverride = errSecInteractionNotAllowed
+        self.packedManager().setString("zxcv", key: kTestKey)
+        XCTAssert(self.packedManager().stringForKey(kKey2) == nil)
+        RGLockbox.flushPackedItems()
+        Thread.sleep(forTimeInterval: 0.1)
+        replacementStatusOverride = nil
+        XCTAssert(self.packedManager().stringForKey(kKey2) == "qwer")
+        RGLockbox.flushPackedItems()
+        self.reset()
+        XCTAssert(self.packedManager().stringForKey(kKey1) == "abcd")
+        XCTAssert(self.packedManager().stringForKey(kKey2) == "qwer")
+        XCTAssert(self.packedManager().stringForKey(kTestKey) == "zxcv")
+        XCTAssert(RGLockbox.deferredWriteCount == 0)
+    }
+    
+    func testTTLInPackedItem() {
+        self.packedManager().setData("abcd".data(using: .utf8), forKey: kKey1, ttl: -1)
+        self.packedManager().setString("qwer", key: kKey2)
+        self.reset()
+        XCTAssert(self.packedManager().dataForKey(kKey1) == nil)
+        XCTAssert(self.packedManager().allItems() == [ kKey2 ])
+    }
+    
+    func testMalformedItemIgnored() {
+        keychainLock.lock()
+        theKeychainLol[RGMultiKey(withFirst: "\(kPackedNamespace).RGLockbox.packed")] = Data(bytes: [ 1, 2, 3 ])
+        keychainLock.unlock()
+        XCTAssert(self.packedManager().dataForKey(kKey1) == nil)
+    }
+    
+    func testPackedAndUnpackedSeparate() {
+        self.packedManager().setString("abcd", key: kKey1)
+        RGLockbox.flushPackedItems()
+        XCTAssert(RGLockbox(withNamespace: kPackedNamespace).dataForKey(kKey1) == nil)
+    }
+    
+// MARK: - Benchmarks
+    
+    func keys(_ count:Int) -> [String] {
+        return (0 ..< count).map({ "key\($0)" })
+    }
+    
+    func measureColdLoad(_ count:Int, packed:Bool) {
+        let manager = RGLockbox(withNamespace: kPackedNamespace, packed: packed)
+        let keys = self.keys(count)
+        for key in keys {
+            manager.setString(key, key: key)
+        }
+        RGLockbox.flushPackedItems()
+        self.measure {
+            self.reset()
+            for key in keys {
+                _ = manager.dataForKey(key)
+            }
+        }
+    }
+    
+    func measureWrites(_ count:Int, packed:Bool) {
+        let manager = RGLockbox(withNamespace: kPackedNamespace, packed: packed)
+        let keys = self.keys(count)
+        var round = 0
+        self.measure {
+            round += 1
+            for key in keys {
+                manager.setString("\(key)-\(round)", key: key)
+            }
+            RGLockbox.flushPackedItems()
+        }
+    }
+    
+    func testColdLoad10Packed() { self.measureColdLoad(10, packed: true) }
+    func testColdLoad10PerKey() { self.measureColdLoad(10, packed: false) }
+    func testColdLoad100Packed() { self.measureColdLoad(100, packed: true) }
+    func testColdLoad100PerKey() { self.measureColdLoad(100, packed: false) }
+    func testColdLoad1000Packed() { self.measureColdLoad(1000, packed: true) }
+    func testColdLoad1000PerKey() { self.measureColdLoad(1000, packed: false) }
+    
+    func testWrites10Packed() { self.measureWrites(10, packed: true) }
+    func testWrites10PerKey() { self.measureWrites(10, packed: false) }
+    func testWrites100Packed() { self.measureWrites(100, packed: true) }
+    func testWrites100PerKey() { self.measureWrites(100, packed: false) }
+    func testWrites1000Packed() { self.measureWrites(1000, packed: true) }
+    func testWrites1000PerKey() { self.measureWrites(1000, packed: false) }
+}
@@ -0,0 +1,141 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+class RGLockbox_PurgeSpec : XCTestCase {
+    
+    override class func initialize() {
+        rg_SecItemCopyMatch = replacementItemCopy
+        rg_SecItemAdd = replacementAddItem
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
+    }
+    
+    override func setUp() {
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    override func tearDown() {
+        RGLockbox().unpin(kKey1)
+        RGLockbox.purgeObserver = nil
+        RGLockbox.residentMemoryLimit = nil
+        for key in testKeys {
+            RGLockbox().setData(nil, forKey: key)
+        }
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    func cached(_ key:String) -> Any? {
+        return RGLockbox.cachedValue(for: RGMultiKey(withFirst: "\(RGLockbox.bundleIdentifier!).\(key)"))
+    }
+    
+    func testPurgeNegatives() {
+        RGLockbox().setString("abcd", key: kKey1)
+        XCTAssert(RGLockbox().dataForKey(kKey2) == nil)
+        XCTAssert(self.cached(kKey2) is NSNull)
+        let freed = RGLockbox.purge(.negatives)
+        XCTAssert(self.cached(kKey2) == nil)
+        XCTAssert(self.cached(kKey1) != nil)
+        XCTAssert(freed > 0)
+    }
+    
+    func testPurgeLargeValues() {
+        RGLockbox().setData(Data(count: 2000), forKey: kKey1)
+        RGLockbox().setData(Data(count: 20), forKey: kKey2)
+        let freed = RGLockbox.purge(.largerThan(1000))
+        XCTAssert(self.cached(kKey1) == nil)
+        XCTAssert(self.cached(kKey2) != nil)
+        XCTAssert(freed >= 2000)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(RGLockbox().dataForKey(kKey1) == Data(count: 2000))
+    }
+    
+    func testPurgeUnused() {
+        RGLockbox().setString("abcd", key: kKey1)
+        Thread.sleep(forTimeInterval: 1.2)
+        RGLockbox().setString("qwer", key: kKey2)
+        RGLockbox.purge(.unusedFor(1))
+        XCTAssert(self.cached(kKey1) == nil)
+        XCTAssert(self.cached(kKey2) != nil)
+    }
+    
+    func testReadCountsAsUse() {
+        RGLockbox().setString("abcd", key: kKey1)
+        Thread.sleep(forTimeInterval: 1.2)
+        XCTAssert(RGLockbox().stringForKey(kKey1) == "abcd")
+        RGLockbox.purge(.unusedFor(1))
+        XCTAssert(self.cached(kKey1) != nil)
+    }
+    
+    func testAccessUntrackedWithoutRecencyPolicy() {
+        let policies = RGLockbox.memoryWarningPolicies
+        RGLockbox.memoryWarningPolicies = [ .negatives ]
+        RGLockbox().setString("abcd", key: kKey1)
+        XCTAssert(RGLockbox().stringForKey(kKey1) == "abcd")
+        RGLockbox.purge(.unusedFor(3600))
+        RGLockbox.memoryWarningPolicies = policies
+        XCTAssert(self.cached(kKey1) == nil)
+    }
+    
+    func testPinnedKeysSurvive() {
+        RGLockbox().setString("abcd", key: kKey1)
+        RGLockbox().setString("qwer", key: kKey2)
+        RGLockbox().pin(kKey1)
+        RGLockbox.purge(.allExceptPinned)
+        XCTAssert(self.cached(kKey1) != nil)
+        XCTAssert(self.cached(kKey2) == nil)
+        RGLockbox().unpin(kKey1)
+        RGLockbox.purge(.allExceptPinned)
+        XCTAssert(self.cached(kKey1) == nil)
+    }
+    
+    func testMemoryWarningPurges() {
+        RGLockbox().setData(Data(count: 8192), forKey: kKey1)
+        var reported:Int? = nil
+        RGLockbox.purgeObserver = { reported = $0 }
+        NotificationCenter.default.post(name: RGApplicationDidReceiveMemoryWarning, object: nil)
+        XCTAssert(self.cached(kKey1) == nil)
+        XCTAssert(reported != nil && reported! >= 8192)
+    }
+    
+    func testResidentMemoryLimit() {
+        XCTAssert(RGLockbox.residentMemorySize != nil)
+        RGLockbox().setData(Data(count: 8192), forKey: kKey1)
+        let purged = self.expectation(description: "purged over the limit")
+        RGLockbox.purgeObserver = { _ in
+            RGLockbox.purgeObserver = nil
+            purged.fulfill()
+        }
+        RGLockbox.residentMemoryCheckInterval = 0.1
+        RGLockbox.residentMemoryLimit = 1
+        self.waitForExpectations(timeout: 2, handler: nil)
+        RGLockbox.residentMemoryLimit = nil
+        RGLockbox.residentMemoryCheckInterval = 5
+        XCTAssert(self.cached(kKey1) == nil)
+    }
+}
@@ -0,0 +1,153 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+class RGLockbox_SchedulerSpec : XCTestCase {
+    
+    override class func initialize() {
+        rg_SecItemCopyMatch = replacementItemCopy
+        rg_SecItemAdd = replacementAddItem
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
+    }
+    
+    override func setUp() {
+        RGLockbox.keychainQueue.sync {}
+        keychainLock.lock()
+        theKeychainLol.removeAll()
+        theKeychainAttributes.removeAll()
+        keychainLock.unlock()
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    override func tearDown() {
+        replacementDelay = 0
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.isPriorityScheduling = true
+        RGLockbox.removeAllCachedValues()
+    }
+    
+/**
+ Writes `count` items from a background queue and returns once they are all scheduled.
+ */
+    func writeInBackground(_ count:Int, prefix:String = "bulk") {
+        let group = DispatchGroup()
+        DispatchQueue.global(qos: .background).async(group: group, execute: {
+            for index in 0 ..< count {
+                RGLockbox().setString("value", key: "\(prefix)\(index)")
+            }
+        })
+        group.wait()
+    }
+    
+/**
+ - returns: How long an interactive read of `key` took.
+ */
+    func interactiveRead(_ key:String, expecting value:String?) -> TimeInterval {
+        var elapsed:TimeInterval = 0
+        let group = DispatchGroup()
+        DispatchQueue.global(qos: .userInteractive).async(group: group, execute: {
+            let start = Date()
+            XCTAssert(RGLockbox().stringForKey(key) == value)
+            elapsed = Date().timeIntervalSince(start)
+        })
+        group.wait()
+        return elapsed
+    }
+    
+    func testReadJumpsAheadOfBackgroundWrites() {
+        RGLockbox().setString("abcd", key: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        replacementDelay = 0.02
+        self.writeInBackground(20)
+        XCTAssert(self.interactiveRead(kTestKey, expecting: "abcd") < 0.15)
+        XCTAssert(RGLockbox.queueDepth > 0)
+    }
+    
+    func testReadWaitsBehindWriteOfSameKey() {
+        replacementDelay = 0.02
+        self.writeInBackground(5)
+        self.writeInBackground(1, prefix: kTestKey)
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(self.interactiveRead("\(kTestKey)0", expecting: "value") >= 0.02)
+    }
+    
+    func testFifoWhenDisabled() {
+        RGLockbox.isPriorityScheduling = false
+        replacementDelay = 0.02
+        self.writeInBackground(10)
+        XCTAssert(self.interactiveRead(kTestKey, expecting: nil) >= 0.15)
+    }
+    
+    func testFlushWaitsForAllWork() {
+        replacementDelay = 0.01
+        self.writeInBackground(10)
+        DispatchQueue.global(qos: .userInteractive).async(execute: {
+            _ = RGLockbox().dataForKey(kKey1)
+        })
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(RGLockbox.queueDepth == 0)
+        keychainLock.lock()
+        let count = theKeychainLol.count
+        keychainLock.unlock()
+        XCTAssert(count == 10)
+    }
+    
+// MARK: - Benchmarks
+    
+    func measureMixedLoad(_ prioritized:Bool) {
+        for index in 0 ..< 20 {
+            RGLockbox().setString("value", key: "read\(index)")
+        }
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.isPriorityScheduling = prioritized
+        replacementDelay = 0.002
+        var latencies:[TimeInterval] = []
+        self.measure {
+            RGLockbox.removeAllCachedValues()
+            let writer = DispatchGroup()
+            DispatchQueue.global(qos: .background).async(group: writer, execute: {
+                for index in 0 ..< 200 {
+                    RGLockbox().setData(Data(count: 64), forKey: "bulk\(index)")
+                }
+            })
+            Thread.sleep(forTimeInterval: 0.01)
+            for index in 0 ..< 20 {
+                latencies.append(self.interactiveRead("read\(index)", expecting: "value"))
+            }
+            writer.wait()
+            RGLockbox.keychainQueue.sync {}
+        }
+        latencies.sort()
+        print("RGLockbox interactive read latency, prioritized \(prioritized): "
+            + "median \(Int(latencies[latencies.count / 2] * 1000)) ms "
+            + "p95 \(Int(latencies[latencies.count * 95 / 100] * 1000)) ms")
+    }
+    
+    func testMixedLoadPrioritized() { self.measureMixedLoad(true) }
+    func testMixedLoadFifo() { self.measureMixedLoad(false) }
+}
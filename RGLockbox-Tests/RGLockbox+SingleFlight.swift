@@ -0,0 +1,111 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+enum RGProducerError: Error {
+    case unavailable
+}
+
+class RGLockbox_SingleFlightSpec : XCTestCase {
+    
+    override class func initialize() {
+        rg_SecItemCopyMatch = replacementItemCopy
+        rg_SecItemAdd = replacementAddItem
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
+    }
+    
+    override func setUp() {
+        RGLockbox().setData(nil, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    override func tearDown() {
+        RGLockbox().setData(nil, forKey: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    func testComputesAbsentValue() {
+        let value = try! RGLockbox().value(forKey: kTestKey, orCompute: { "abcd".data(using: String.Encoding.utf8)! })
+        XCTAssert(value == "abcd".data(using: String.Encoding.utf8))
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox().dataForKey(kTestKey) == value)
+    }
+    
+    func testExistingValueSkipsProducer() {
+        RGLockbox().setData("abcd".data(using: String.Encoding.utf8), forKey: kTestKey)
+        var calls = 0
+        let value = try! RGLockbox().value(forKey: kTestKey, orCompute: {
+            calls += 1
+            return Data()
+        })
+        XCTAssert(value == "abcd".data(using: String.Encoding.utf8))
+        XCTAssert(calls == 0)
+    }
+    
+    func testConcurrentCallersShareOneComputation() {
+        let callsLock = NSLock()
+        var calls = 0
+        var results:[Data] = []
+        DispatchQueue.concurrentPerform(iterations: 16, execute: { _ in
+            let value = try! RGLockbox().value(forKey: kTestKey, orCompute: {
+                callsLock.lock()
+                calls += 1
+                callsLock.unlock()
+                Thread.sleep(forTimeInterval: 0.2)
+                return "token".data(using: String.Encoding.utf8)!
+            })
+            callsLock.lock()
+            results.append(value)
+            callsLock.unlock()
+        })
+        XCTAssert(calls == 1)
+        XCTAssert(results.count == 16)
+        XCTAssert(results.filter({ $0 != "token".data(using: String.Encoding.utf8) }).count == 0)
+    }
+    
+    func testErrorSharedAndNotStored() {
+        let failuresLock = NSLock()
+        var failures = 0
+        DispatchQueue.concurrentPerform(iterations: 8, execute: { _ in
+            do {
+                _ = try RGLockbox().value(forKey: kTestKey, orCompute: {
+                    Thread.sleep(forTimeInterval: 0.2)
+                    throw RGProducerError.unavailable
+                })
+            } catch {
+                failuresLock.lock()
+                failures += error is RGProducerError ? 1 : 0
+                failuresLock.unlock()
+            }
+        })
+        XCTAssert(failures == 8)
+        XCTAssert(RGLockbox().dataForKey(kTestKey) == nil)
+    }
+}
@@ -0,0 +1,160 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+class RGLockbox_ThreadCacheSpec : XCTestCase {
+    
+    static var backendReads = 0
+    
+    override class func initialize() {
+        rg_SecItemCopyMatch = { query, value in
+            RGLockbox_ThreadCacheSpec.backendReads += 1
+            return replacementItemCopy(query, value)
+        }
+        rg_SecItemAdd = replacementAddItem
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
+    }
+    
+    override func setUp() {
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        RGLockbox.isThreadCacheEnabled = true
+        RGLockbox_ThreadCacheSpec.backendReads = 0
+    }
+    
+    override func tearDown() {
+        RGLockbox.isThreadCacheEnabled = false
+        for key in testKeys {
+            RGLockbox().setData(nil, forKey: key)
+        }
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    func testSharedCacheChangeInvalidates() {
+        RGLockbox().setString("abcd", key: kKey1)
+        XCTAssert(RGLockbox().stringForKey(kKey1) == "abcd")
+        let fullKey = RGMultiKey(withFirst: "\(RGLockbox.bundleIdentifier!).\(kKey1)")
+        RGLockbox.setCachedValue("qwer".data(using: String.Encoding.utf8), for: fullKey)
+        XCTAssert(RGLockbox().stringForKey(kKey1) == "qwer")
+    }
+    
+    func testSharedCacheClearInvalidates() {
+        RGLockbox().setString("abcd", key: kKey1)
+        XCTAssert(RGLockbox().stringForKey(kKey1) == "abcd")
+        RGLockbox.keychainQueue.sync {}
+        keychainLock.lock()
+        theKeychainLol[RGMultiKey(withFirst: "\(RGLockbox.bundleIdentifier!).\(kKey1)")] = nil
+        keychainLock.unlock()
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox().stringForKey(kKey1) == nil)
+    }
+    
+    func testGenerationTableInvalidates() {
+        let path = NSTemporaryDirectory() + "RGLockbox.threadcache.generations"
+        try? FileManager.default.removeItem(atPath: path)
+        RGLockbox().setString("abcd", key: kKey1)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(RGLockbox().stringForKey(kKey1) == "abcd")
+        RGLockbox.generationTable = RGGenerationTable(path: path)
+        let fullKey = RGMultiKey(withFirst: "\(RGLockbox.bundleIdentifier!).\(kKey1)")
+        rg_external_write("qwer".data(using: String.Encoding.utf8)!, service: fullKey.first!)
+        _ = RGGenerationTable(path: path)!.advance(fullKey)
+        XCTAssert(RGLockbox().stringForKey(kKey1) == "qwer")
+        RGLockbox.generationTable = nil
+        try? FileManager.default.removeItem(atPath: path)
+    }
+    
+    func testWriteInvalidates() {
+        RGLockbox().setString("abcd", key: kKey1)
+        XCTAssert(RGLockbox().stringForKey(kKey1) == "abcd")
+        RGLockbox().setString("qwer", key: kKey1)
+        XCTAssert(RGLockbox().stringForKey(kKey1) == "qwer")
+    }
+    
+    func testWriteOnOtherThreadInvalidates() {
+        RGLockbox().setString("abcd", key: kKey1)
+        XCTAssert(RGLockbox().stringForKey(kKey1) == "abcd")
+        let written = self.expectation(description: "write")
+        Thread.detachNewThread({
+            RGLockbox().setString("qwer", key: kKey1)
+            written.fulfill()
+        })
+        self.waitForExpectations(timeout: 1, handler: nil)
+        XCTAssert(RGLockbox().stringForKey(kKey1) == "qwer")
+    }
+    
+    func testCachesAbsence() {
+        XCTAssert(RGLockbox().dataForKey(kKey2) == nil)
+        XCTAssert(RGLockbox().dataForKey(kKey2) == nil)
+        let reads = RGLockbox_ThreadCacheSpec.backendReads
+        XCTAssert(RGLockbox().dataForKey(kKey2) == nil)
+        XCTAssert(RGLockbox_ThreadCacheSpec.backendReads == reads)
+        RGLockbox().setString("abcd", key: kKey2)
+        XCTAssert(RGLockbox().stringForKey(kKey2) == "abcd")
+    }
+    
+    func testPurgeInvalidates() {
+        RGLockbox().setString("abcd", key: kKey1)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(RGLockbox().stringForKey(kKey1) == "abcd")
+        let reads = RGLockbox_ThreadCacheSpec.backendReads
+        RGLockbox.purge([ .allExceptPinned ])
+        XCTAssert(RGLockbox().stringForKey(kKey1) == "abcd")
+        XCTAssert(RGLockbox_ThreadCacheSpec.backendReads > reads)
+    }
+    
+    func testExpiringValuesNotCached() {
+        RGLockbox().setData("abcd".data(using: String.Encoding.utf8), forKey: kKey1, ttl: 0.1)
+        XCTAssert(RGLockbox().stringForKey(kKey1) == "abcd")
+        Thread.sleep(forTimeInterval: 0.2)
+        XCTAssert(RGLockbox().dataForKey(kKey1) == nil)
+    }
+    
+    func testHitContention() {
+        RGLockbox().setString("abcd", key: kKey1)
+        RGLockbox().setString("qwer", key: kKey2)
+        RGLockbox.keychainQueue.sync {}
+        let reads = 400_000
+        for threads in [ 1, 4, 16 ] {
+            var rates:[Bool : Double] = [:]
+            for isEnabled in [ false, true ] {
+                RGLockbox.isThreadCacheEnabled = isEnabled
+                let start = Date()
+                DispatchQueue.concurrentPerform(iterations: threads, execute: { thread in
+                    let manager = RGLockbox()
+                    for index in 0 ..< reads / threads {
+                        _ = manager.dataForKey(testKeys[(index + thread) % testKeys.count])
+                    }
+                })
+                rates[isEnabled] = Double(reads) / Date().timeIntervalSince(start)
+            }
+            print("RGLockbox hits with \(threads) threads: shared cache \(Int(rates[false]!)) reads/s, " +
+                  "thread cache \(Int(rates[true]!)) reads/s")
+        }
+    }
+}
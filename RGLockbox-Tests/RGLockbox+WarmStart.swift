@@ -0,0 +1,187 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+class RGLockbox_WarmStartSpec : XCTestCase {
+    
+    static var backendReads = 0
+    
+    let warmStartURL = URL(fileURLWithPath: NSTemporaryDirectory()).appendingPathComponent("RGLockbox.warmstart")
+    
+    override class func initialize() {
+        rg_SecItemCopyMatch = { query, value in
+            RGLockbox_WarmStartSpec.backendReads += 1
+            return replacementItemCopy(query, value)
+        }
+        rg_SecItemAdd = replacementAddItem
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
+    }
+    
+    override func setUp() {
+        RGLockbox.keychainQueue.sync {}
+        keychainLock.lock()
+        theKeychainLol.removeAll()
+        theKeychainAttributes.removeAll()
+        keychainLock.unlock()
+        RGLockbox.removeAllCachedValues()
+        RGLockbox.invalidateMembershipFilters()
+        try? FileManager.default.removeItem(at: self.warmStartURL)
+        RGLockbox.warmStartURL = self.warmStartURL
+    }
+    
+    override func tearDown() {
+        RGLockbox.warmStartURL = nil
+        replacementDelay = 0
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        try? FileManager.default.removeItem(at: self.warmStartURL)
+    }
+    
+    func service(_ key:String) -> String {
+        return "\(RGLockbox.bundleIdentifier!).\(key)"
+    }
+    
+/**
+ Stands in for a relaunch: nothing is cached until the warm start cache loads.
+ */
+    func relaunch() -> Int {
+        RGLockbox.removeAllCachedValues()
+        RGLockbox.invalidateMembershipFilters()
+        return RGLockbox.loadWarmStartCache()
+    }
+    
+    func testRoundTrip() {
+        RGLockbox().setString("abcd", key: kKey1)
+        RGLockbox().setString("qwer", key: kKey2)
+        RGLockbox.saveWarmStartCache()
+        XCTAssert(self.relaunch() == 2)
+        RGLockbox_WarmStartSpec.backendReads = 0
+        XCTAssert(RGLockbox().stringForKey(kKey1) == "abcd")
+        XCTAssert(RGLockbox().stringForKey(kKey2) == "qwer")
+        XCTAssert(RGLockbox_WarmStartSpec.backendReads == 0)
+    }
+    
+    func testFileIsEncrypted() {
+        RGLockbox().setString("plaintext secret", key: kKey1)
+        RGLockbox.saveWarmStartCache()
+        let file = try! Data(contentsOf: self.warmStartURL)
+        XCTAssert(file.range(of: "plaintext secret".data(using: String.Encoding.utf8)!) == nil)
+        XCTAssert(file.range(of: kKey1.data(using: String.Encoding.utf8)!) == nil)
+    }
+    
+    func testKeyReadableOnlyWhenUnlocked() {
+        RGLockbox().setString("abcd", key: kKey1)
+        RGLockbox.saveWarmStartCache()
+        let item = RGMultiKey(withFirst: "RGLockbox.warmstart")
+        keychainLock.lock()
+        let accessibility = theKeychainAttributes[item]?[kSecAttrAccessible as String] as? String
+        keychainLock.unlock()
+        XCTAssert(accessibility == kSecAttrAccessibleWhenUnlockedThisDeviceOnly as String)
+    }
+    
+    func testChangedItemFallsThrough() {
+        RGLockbox().setString("abcd", key: kKey1)
+        RGLockbox().setString("qwer", key: kKey2)
+        RGLockbox.saveWarmStartCache()
+        Thread.sleep(forTimeInterval: 0.01)
+        rg_external_write("zxcv".data(using: String.Encoding.utf8)!, service: self.service(kKey1))
+        XCTAssert(self.relaunch() == 1)
+        XCTAssert(RGLockbox().stringForKey(kKey1) == "zxcv")
+        XCTAssert(RGLockbox().stringForKey(kKey2) == "qwer")
+    }
+    
+    func testRemovedItemFallsThrough() {
+        RGLockbox().setString("abcd", key: kKey1)
+        RGLockbox.saveWarmStartCache()
+        keychainLock.lock()
+        theKeychainLol[RGMultiKey(withFirst: self.service(kKey1))] = nil
+        theKeychainAttributes[RGMultiKey(withFirst: self.service(kKey1))] = nil
+        keychainLock.unlock()
+        XCTAssert(self.relaunch() == 0)
+        XCTAssert(RGLockbox().dataForKey(kKey1) == nil)
+    }
+    
+    func testTamperedFileDiscarded() {
+        RGLockbox().setString("abcd", key: kKey1)
+        RGLockbox.saveWarmStartCache()
+        var file = try! Data(contentsOf: self.warmStartURL)
+        file[20] ^= 1
+        try! file.write(to: self.warmStartURL)
+        XCTAssert(self.relaunch() == 0)
+        XCTAssert(!FileManager.default.fileExists(atPath: self.warmStartURL.path))
+        XCTAssert(RGLockbox().stringForKey(kKey1) == "abcd")
+    }
+    
+    func testLostKeyDiscardsFile() {
+        RGLockbox().setString("abcd", key: kKey1)
+        RGLockbox.saveWarmStartCache()
+        keychainLock.lock()
+        theKeychainLol[RGMultiKey(withFirst: "RGLockbox.warmstart")] = nil
+        keychainLock.unlock()
+        XCTAssert(self.relaunch() == 0)
+        XCTAssert(RGLockbox().stringForKey(kKey1) == "abcd")
+    }
+    
+    func testExpiringValuesNotSaved() {
+        RGLockbox().setData("abcd".data(using: String.Encoding.utf8), forKey: kKey1, ttl: 3600)
+        RGLockbox().setString("qwer", key: kKey2)
+        RGLockbox.saveWarmStartCache()
+        XCTAssert(self.relaunch() == 1)
+    }
+    
+    func testKeyItemNotEnumerated() {
+        RGLockbox().setString("abcd", key: kKey1)
+        RGLockbox.saveWarmStartCache()
+        XCTAssert(!RGLockbox(withNamespace: nil).allItems().contains("RGLockbox.warmstart"))
+    }
+    
+    func testColdStart() {
+        let keys = (0..<50).map({ "item.\($0)" })
+        for key in keys {
+            RGLockbox().setString("value of \(key)", key: key)
+        }
+        RGLockbox.saveWarmStartCache()
+        replacementDelay = 0.001
+        
+        RGLockbox.removeAllCachedValues()
+        RGLockbox.invalidateMembershipFilters()
+        var start = Date()
+        for key in keys {
+            XCTAssert(RGLockbox().stringForKey(key) == "value of \(key)")
+        }
+        let direct = Date().timeIntervalSince(start)
+        
+        start = Date()
+        XCTAssert(self.relaunch() == keys.count)
+        for key in keys {
+            XCTAssert(RGLockbox().stringForKey(key) == "value of \(key)")
+        }
+        let warm = Date().timeIntervalSince(start)
+        print("RGLockbox cold start of \(keys.count) keys: keychain \(Int(direct * 1000)) ms, " +
+              "warm start \(Int(warm * 1000)) ms")
+    }
+}
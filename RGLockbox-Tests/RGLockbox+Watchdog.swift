@@ -0,0 +1,136 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+class RGLockbox_WatchdogSpec : XCTestCase {
+    
+    override class func initialize() {
+        rg_SecItemCopyMatch = replacementItemCopy
+        rg_SecItemAdd = replacementAddItem
+        rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
+    }
+    
+    override func setUp() {
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        RGLockbox.slowOperationThreshold = 0.05
+    }
+    
+    override func tearDown() {
+        RGLockbox.slowOperationObserver = nil
+        RGLockbox.slowOperationThreshold = 1
+        replacementDelay = 0
+        for key in testKeys + [ kTestKey ] {
+            RGLockbox().setData(nil, forKey: key)
+        }
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+    }
+    
+    var serviceHash:UInt64 {
+        return RGMultiKey(withFirst: "\(RGLockbox.bundleIdentifier!).\(kTestKey)").stableHash
+    }
+    
+/**
+ Fulfills an expectation with the first report matching `operation`.
+ */
+    func expectReport(_ operation:RGKeychainOperation, _ check:@escaping (RGSlowOperation) -> Void) {
+        let reported = self.expectation(description: "\(operation)")
+        var isFulfilled = false
+        RGLockbox.slowOperationObserver = { report in
+            if report.operation == operation && !isFulfilled {
+                isFulfilled = true
+                check(report)
+                reported.fulfill()
+            }
+        }
+    }
+    
+    func testReportsSlowRead() {
+        RGLockbox().setString("abcd", key: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        replacementDelay = 0.1
+        self.expectReport(.copyMatching, { report in
+            XCTAssert(report.keyHash == self.serviceHash)
+            XCTAssert(report.elapsed >= 0.1)
+        })
+        XCTAssert(RGLockbox().stringForKey(kTestKey) == "abcd")
+        self.waitForExpectations(timeout: 2, handler: nil)
+    }
+    
+    func testFastCallsNotReported() {
+        var reports = 0
+        RGLockbox.slowOperationThreshold = 10
+        RGLockbox.slowOperationObserver = { _ in
+            reports += 1
+        }
+        RGLockbox().setString("abcd", key: kTestKey)
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox().stringForKey(kTestKey) == "abcd")
+        Thread.sleep(forTimeInterval: 0.1)
+        XCTAssert(reports == 0)
+    }
+    
+    func testReportsQueueWait() {
+        replacementDelay = 0.05
+        self.expectReport(.queueWait, { report in
+            XCTAssert(report.keyHash == nil)
+            XCTAssert(report.elapsed >= 0.05)
+        })
+        for key in testKeys + [ kTestKey ] {
+            RGLockbox().setString("abcd", key: key)
+        }
+        self.waitForExpectations(timeout: 5, handler: nil)
+    }
+    
+    func testReportsStallBeforeCallReturns() {
+        replacementDelay = 0.5
+        let start = Date()
+        self.expectReport(.queueStall, { report in
+            XCTAssert(Date().timeIntervalSince(start) < 0.5)
+            XCTAssert(report.keyHash == self.serviceHash)
+            XCTAssert(report.queueDepth == 1)
+        })
+        RGLockbox().setString("abcd", key: kTestKey)
+        RGLockbox().setString("qwer", key: kKey1)
+        self.waitForExpectations(timeout: 2, handler: nil)
+    }
+    
+    func testQueueDepth() {
+        replacementDelay = 0.1
+        XCTAssert(RGLockbox.queueDepth == 0)
+        RGLockbox().setString("abcd", key: kTestKey)
+        RGLockbox().setString("qwer", key: kKey1)
+        RGLockbox().setString("zxcv", key: kKey2)
+        Thread.sleep(forTimeInterval: 0.05)
+        XCTAssert(RGLockbox.queueDepth == 2)
+        RGLockbox.keychainQueue.sync {}
+        XCTAssert(RGLockbox.queueDepth == 0)
+    }
+}
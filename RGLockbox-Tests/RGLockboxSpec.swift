@@ -33,12 +33,28 @@ let testKeys = [
     kKey2
 ]
 
+/**
+ - returns: The counter stored by `rg_counter_data`, 0 if absent.
+ */
+func rg_counter_value(_ data:Data?) -> Int {
+    let string = data != nil ? String(data: data!, encoding: String.Encoding.utf8) : nil
+    return Int(string ?? "0") ?? 0
+}
+
+/**
+ - returns: `value` encoded as a decimal string.
+ */
+func rg_counter_data(_ value:Int) -> Data {
+    return "\(value)".data(using: String.Encoding.utf8)!
+}
+
 class RGLockboxSpec : XCTestCase {
     
     override class func initialize() {
         rg_SecItemCopyMatch = replacementItemCopy
         rg_SecItemAdd = replacementAddItem
         rg_SecItemDelete = replacementDeleteItem
+        rg_SecItemUpdate = replacementUpdateItem
         rg_set_logging_severity(.trace)
     }
     
@@ -51,7 +67,7 @@ class RGLockboxSpec : XCTestCase {
         for key in manager.allItems() {
             manager.setData(nil, forKey: key)
         }
-        RGLockbox.valueCache.removeAll()
+        RGLockbox.removeAllCachedValues()
     }
     
     override func tearDown() {
@@ -62,7 +78,7 @@ class RGLockboxSpec : XCTestCase {
         for key in manager.allItems() {
             manager .setData(nil, forKey: key)
         }
-        RGLockbox.valueCache.removeAll()
+        RGLockbox.removeAllCachedValues()
     }
     
 // MARK: - Reading / Writing / Deleting
@@ -94,7 +110,7 @@ class RGLockboxSpec : XCTestCase {
         let fullKey = RGMultiKey(withFirst: "\(RGLockbox().namespace!).\(kKey2)")
         let data = "abcd".data(using: String.Encoding.utf8)
         RGLockbox().setData(data, forKey: kKey2)
-        RGLockbox.valueCache[fullKey] = nil
+        RGLockbox.removeCachedValue(for: fullKey)
         let readData = RGLockbox().dataForKey(kKey2)
         XCTAssert(readData == data)
     }
@@ -114,11 +130,82 @@ class RGLockboxSpec : XCTestCase {
         let secondData = "qwew".data(using: String.Encoding.utf8)!
         RGLockbox().setData(firstData, forKey: kKey1)
         RGLockbox().setData(secondData, forKey: kKey1)
-        RGLockbox.valueCache[fullKey] = nil
+        RGLockbox.removeCachedValue(for: fullKey)
         let readData = RGLockbox().dataForKey(kKey1)
         XCTAssert(readData == secondData)
     }
     
+// MARK: - update
+    func testUpdateAbsentValue() {
+        var seen:Data? = Data()
+        let result = RGLockbox().update(forKey: kKey1, { current in
+            seen = current
+            return "abcd".data(using: String.Encoding.utf8)
+        })
+        XCTAssert(seen == nil)
+        XCTAssert(result == "abcd".data(using: String.Encoding.utf8))
+        XCTAssert(RGLockbox().dataForKey(kKey1) == result)
+    }
+    
+    func testUpdateToNil() {
+        RGLockbox().setData(Data(), forKey: kKey1)
+        RGLockbox().update(forKey: kKey1, { _ in nil })
+        RGLockbox.keychainQueue.sync {}
+        RGLockbox.removeAllCachedValues()
+        XCTAssert(RGLockbox().dataForKey(kKey1) == nil)
+    }
+    
+    func testUpdateIsAtomic() {
+        let iterations = 400
+        DispatchQueue.concurrentPerform(iterations: iterations, execute: { _ in
+            RGLockbox().update(forKey: kKey1, { current in
+                return rg_counter_data(rg_counter_value(current) + 1)
+            })
+        })
+        XCTAssert(rg_counter_value(RGLockbox().dataForKey(kKey1)) == iterations)
+    }
+    
+    func testUpdateMayWriteKeySharingLock() {
+        let stripe = RGMultiKey(withFirst: "\(RGLockbox.bundleIdentifier!).\(kKey1)").stableHash % 64
+        let other = (0 ..< 1000).map({ "other\($0)" }).first(where: {
+            RGMultiKey(withFirst: "\(RGLockbox.bundleIdentifier!).\($0)").stableHash % 64 == stripe
+        })!
+        RGLockbox().update(forKey: kKey1, { _ in
+            RGLockbox().setString("qwer", key: other)
+            return "abcd".data(using: String.Encoding.utf8)
+        })
+        XCTAssert(RGLockbox().stringForKey(kKey1) == "abcd")
+        XCTAssert(RGLockbox().stringForKey(other) == "qwer")
+        RGLockbox().setData(nil, forKey: other)
+    }
+    
+    func testUpdateContentionPerformance() {
+        self.measure {
+            DispatchQueue.concurrentPerform(iterations: 8, execute: { thread in
+                for _ in 0..<200 {
+                    RGLockbox().update(forKey: testKeys[thread % testKeys.count], { current in
+                        return rg_counter_data(rg_counter_value(current) + 1)
+                    })
+                }
+            })
+        }
+    }
+    
+    func testLockWrappedContentionPerformance() {
+        let globalLock = NSLock()
+        self.measure {
+            DispatchQueue.concurrentPerform(iterations: 8, execute: { thread in
+                for _ in 0..<200 {
+                    let key = testKeys[thread % testKeys.count]
+                    globalLock.lock()
+                    let current = RGLockbox().dataForKey(key)
+                    RGLockbox().setData(rg_counter_data(rg_counter_value(current) + 1), forKey: key)
+                    globalLock.unlock()
+                }
+            })
+        }
+    }
+    
 // MARK: - allItems
     func testAllItemsNamespaced() {
         RGLockbox().setData(Data(), forKey: kKey1)
@@ -167,7 +254,7 @@ class RGLockboxSpec : XCTestCase {
                                 synchronized: true)
         manager.setData(Data(), forKey: kKey2)
         RGLockbox.keychainQueue.sync {}
-        RGLockbox.valueCache.removeAll()
+        RGLockbox.removeAllCachedValues()
         let value = manager.dataForKey(kKey2)
         XCTAssert(value == Data())
     }
@@ -179,7 +266,7 @@ class RGLockboxSpec : XCTestCase {
         RGLockbox().setData(Data(), forKey: "abcd")
         manager.setData("abew".data(using: String.Encoding.utf8), forKey: kKey1)
         RGLockbox.keychainQueue.sync {}
-        RGLockbox.valueCache.removeAll()
+        RGLockbox.removeAllCachedValues()
         RGLockbox().setData(Data(), forKey: kKey2)
         let items = manager.allItems()
         XCTAssert(items.first == kKey1)
@@ -193,14 +280,14 @@ class RGLockboxSpec : XCTestCase {
         var value = nonSyncManager.dataForKey(kKey1)
         XCTAssert(value == "abew".data(using: String.Encoding.utf8))
         RGLockbox.keychainQueue.sync {}
-        RGLockbox.valueCache.removeAll()
+        RGLockbox.removeAllCachedValues()
         syncManager.setData("abcd".data(using: String.Encoding.utf8), forKey: kKey1)
         RGLockbox.keychainQueue.sync {}
-        RGLockbox.valueCache.removeAll()
+        RGLockbox.removeAllCachedValues()
         value = syncManager.dataForKey(kKey1)
         XCTAssert(value == "abcd".data(using: String.Encoding.utf8))
         RGLockbox.keychainQueue.sync {}
-        RGLockbox.valueCache.removeAll()
+        RGLockbox.removeAllCachedValues()
         value = nonSyncManager.dataForKey(kKey1)
         XCTAssert(value == "abcd".data(using: String.Encoding.utf8))
     }
@@ -210,18 +297,18 @@ class RGLockboxSpec : XCTestCase {
         let syncManager = RGLockbox(accessibility: kSecAttrAccessibleAlways, synchronized: true)
         syncManager.setData("qwas".data(using: String.Encoding.utf8), forKey: kKey2)
         RGLockbox.keychainQueue.sync {}
-        RGLockbox.valueCache.removeAll()
+        RGLockbox.removeAllCachedValues()
         var value = nonSyncManager.dataForKey(kKey2)
         XCTAssert(value == "qwas".data(using: String.Encoding.utf8))
         RGLockbox.keychainQueue.sync {}
-        RGLockbox.valueCache.removeAll()
+        RGLockbox.removeAllCachedValues()
         nonSyncManager.setData("abcd".data(using: String.Encoding.utf8), forKey: kKey2)
         RGLockbox.keychainQueue.sync {}
-        RGLockbox.valueCache.removeAll()
+        RGLockbox.removeAllCachedValues()
         value = nonSyncManager.dataForKey(kKey2)
         XCTAssert(value == "abcd".data(using: String.Encoding.utf8))
         RGLockbox.keychainQueue.sync {}
-        RGLockbox.valueCache.removeAll()
+        RGLockbox.removeAllCachedValues()
         value = syncManager.dataForKey(kKey2)
         XCTAssert(value == "abcd".data(using: String.Encoding.utf8))
     }
@@ -0,0 +1,132 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import XCTest
+import RGLockboxIOS
+
+class RGTimingWheelSpec : XCTestCase {
+    
+    let origin = Date(timeIntervalSince1970: 1000)
+    
+    func testEmptyWheel() {
+        let wheel = RGTimingWheel(origin: self.origin)
+        XCTAssert(wheel.advance(to: self.origin.addingTimeInterval(10)).count == 0)
+        XCTAssert(wheel.count == 0)
+    }
+    
+    func testExpiresOnLevelZero() {
+        let wheel = RGTimingWheel(origin: self.origin)
+        let key = RGMultiKey(withFirst: "abcd")
+        wheel.schedule(key, at: self.origin.addingTimeInterval(5))
+        XCTAssert(wheel.advance(to: self.origin.addingTimeInterval(4)).count == 0)
+        XCTAssert(wheel.advance(to: self.origin.addingTimeInterval(5)) == [ key ])
+        XCTAssert(wheel.count == 0)
+    }
+    
+    func testNeverExpiresEarly() {
+        let wheel = RGTimingWheel(origin: self.origin)
+        let key = RGMultiKey(withFirst: "abcd")
+        wheel.schedule(key, at: self.origin.addingTimeInterval(2.5))
+        XCTAssert(wheel.advance(to: self.origin.addingTimeInterval(2.9)).count == 0)
+        XCTAssert(wheel.advance(to: self.origin.addingTimeInterval(3)) == [ key ])
+    }
+    
+    func testCascadesFromHigherLevels() {
+        let wheel = RGTimingWheel(slotsPerLevel: 4, levels: 3, origin: self.origin)
+        let near = RGMultiKey(withFirst: "near")
+        let middle = RGMultiKey(withFirst: "middle")
+        let far = RGMultiKey(withFirst: "far")
+        wheel.schedule(near, at: self.origin.addingTimeInterval(3))
+        wheel.schedule(middle, at: self.origin.addingTimeInterval(9))
+        wheel.schedule(far, at: self.origin.addingTimeInterval(50))
+        var expired:[RGMultiKey] = []
+        var expiredAt:[RGMultiKey : Int] = [:]
+        for second in 1...60 {
+            for key in wheel.advance(to: self.origin.addingTimeInterval(TimeInterval(second))) {
+                expired.append(key)
+                expiredAt[key] = second
+            }
+        }
+        XCTAssert(expired == [ near, middle, far ])
+        XCTAssert(expiredAt[near] == 3)
+        XCTAssert(expiredAt[middle] == 9)
+        XCTAssert(expiredAt[far] == 50)
+    }
+    
+    func testLongJump() {
+        let wheel = RGTimingWheel(slotsPerLevel: 4, levels: 2, origin: self.origin)
+        let key1 = RGMultiKey(withFirst: "abcd")
+        let key2 = RGMultiKey(withFirst: "qwer")
+        wheel.schedule(key1, at: self.origin.addingTimeInterval(10))
+        wheel.schedule(key2, at: self.origin.addingTimeInterval(1000))
+        XCTAssert(wheel.advance(to: self.origin.addingTimeInterval(500)) == [ key1 ])
+        XCTAssert(wheel.advance(to: self.origin.addingTimeInterval(1000)) == [ key2 ])
+    }
+    
+    func testNextDeadline() {
+        let wheel = RGTimingWheel(origin: self.origin)
+        XCTAssert(wheel.nextDeadline == nil)
+        wheel.schedule(RGMultiKey(withFirst: "late"), at: self.origin.addingTimeInterval(300))
+        let deadline = wheel.schedule(RGMultiKey(withFirst: "early"), at: self.origin.addingTimeInterval(2.5))
+        XCTAssert(deadline == self.origin.addingTimeInterval(3))
+        XCTAssert(wheel.nextDeadline == deadline)
+        XCTAssert(wheel.advance(to: deadline).count == 1)
+        XCTAssert(wheel.nextDeadline == self.origin.addingTimeInterval(300))
+    }
+    
+    func testNextDeadlineSkipsCancelledAndRescheduled() {
+        let wheel = RGTimingWheel(origin: self.origin)
+        let moved = RGMultiKey(withFirst: "moved")
+        let cancelled = RGMultiKey(withFirst: "cancelled")
+        wheel.schedule(moved, at: self.origin.addingTimeInterval(5))
+        wheel.schedule(cancelled, at: self.origin.addingTimeInterval(10))
+        wheel.schedule(RGMultiKey(withFirst: "late"), at: self.origin.addingTimeInterval(60))
+        wheel.schedule(moved, at: self.origin.addingTimeInterval(20))
+        wheel.cancel(cancelled)
+        XCTAssert(wheel.nextDeadline == self.origin.addingTimeInterval(20))
+        for index in 0 ..< 1000 {
+            wheel.schedule(moved, at: self.origin.addingTimeInterval(Double(100 + index)))
+        }
+        XCTAssert(wheel.nextDeadline == self.origin.addingTimeInterval(60))
+        XCTAssert(wheel.advance(to: self.origin.addingTimeInterval(60)).count == 1)
+        XCTAssert(wheel.nextDeadline == self.origin.addingTimeInterval(1099))
+    }
+    
+    func testCancel() {
+        let wheel = RGTimingWheel(origin: self.origin)
+        let key = RGMultiKey(withFirst: "abcd")
+        wheel.schedule(key, at: self.origin.addingTimeInterval(5))
+        wheel.cancel(key)
+        XCTAssert(wheel.advance(to: self.origin.addingTimeInterval(10)).count == 0)
+    }
+    
+    func testReschedule() {
+        let wheel = RGTimingWheel(origin: self.origin)
+        let key = RGMultiKey(withFirst: "abcd")
+        wheel.schedule(key, at: self.origin.addingTimeInterval(5))
+        wheel.schedule(key, at: self.origin.addingTimeInterval(100))
+        XCTAssert(wheel.advance(to: self.origin.addingTimeInterval(99)).count == 0)
+        XCTAssert(wheel.advance(to: self.origin.addingTimeInterval(100)) == [ key ])
+    }
+}
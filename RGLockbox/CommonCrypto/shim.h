@@ -0,0 +1 @@
+#include <CommonCrypto/CommonCrypto.h>
@@ -0,0 +1,109 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+
+/**
+ `RGBloomFilter` is a fixed size Bloom filter of strings.  `mayContain(_:)` never returns `false` for an inserted string
+   and returns `true` for a string which was not inserted at close to `falsePositiveRate` while at most `capacity`
+   strings have been inserted.  Not threadsafe; callers provide their own locking.
+ */
+open class RGBloomFilter {
+    
+/**
+ The number of strings the filter was sized for.
+ */
+    open let capacity:Int
+    
+/**
+ The expected false positive rate at `capacity`.
+ */
+    open let falsePositiveRate:Double
+    
+/**
+ The number of bits and the number of bits set per string.
+ */
+    open let bitCount:Int
+    open let hashCount:Int
+    
+/**
+ The number of inserts which set at least one new bit.  Inserting a string again never counts, and a new string whose
+   bits are all set already isn't counted either, so this slightly undercounts distinct strings near `capacity`.
+ */
+    open private(set) var count = 0
+    
+    private var words:[UInt64]
+    
+/**
+ - parameter capacity: The number of strings the filter should hold.
+ - parameter falsePositiveRate: The acceptable rate of false positives, between 0 and 1.
+ */
+    public init(capacity:Int, falsePositiveRate:Double = 0.01) {
+        let capacity = max(capacity, 1)
+        let bitCount = Int(ceil(-Double(capacity) * log(falsePositiveRate) / (M_LN2 * M_LN2)))
+        self.capacity = capacity
+        self.falsePositiveRate = falsePositiveRate
+        self.bitCount = max(64, bitCount)
+        self.hashCount = max(1, Int(round(Double(self.bitCount) / Double(capacity) * M_LN2)))
+        self.words = [UInt64](repeating: 0, count: (self.bitCount + 63) / 64)
+    }
+    
+    open func insert(_ string:String) {
+        var isNew = false
+        for bit in self.bits(string) {
+            let mask:UInt64 = 1 << UInt64(bit & 63)
+            if self.words[bit >> 6] & mask == 0 {
+                self.words[bit >> 6] |= mask
+                isNew = true
+            }
+        }
+        if isNew {
+            self.count += 1
+        }
+    }
+    
+/**
+ - returns: `false` if `string` was certainly never inserted.
+ */
+    open func mayContain(_ string:String) -> Bool {
+        for bit in self.bits(string) where self.words[bit >> 6] & (1 << UInt64(bit & 63)) == 0 {
+            return false
+        }
+        return true
+    }
+    
+/**
+ The bits of `string` by double hashing of its FNV-1a hash and a remix of it.
+ */
+    private func bits(_ string:String) -> [Int] {
+        let primary = RGMultiKey(withFirst: string).stableHash
+        var secondary = primary ^ (primary >> 33)
+        secondary = secondary &* 0xff51afd7ed558ccd
+        secondary = (secondary ^ (secondary >> 33)) | 1
+        var bits:[Int] = []
+        for index in 0 ..< UInt64(self.hashCount) {
+            bits.append(Int((primary &+ index &* secondary) % UInt64(self.bitCount)))
+        }
+        return bits
+    }
+}
@@ -0,0 +1,178 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+
+/**
+ Appends little-endian integers and raw bytes to a growing buffer.  Used by the library's compact binary formats.
+ */
+struct RGByteWriter {
+    
+/**
+ The bytes written so far.
+ */
+    var bytes:[UInt8] = []
+    
+    init() {
+    }
+    
+/**
+ The bytes written so far as `Data`.
+ */
+    var data:Data {
+        return Data(bytes: self.bytes)
+    }
+    
+    mutating func write(_ value:UInt8) {
+        self.bytes.append(value)
+    }
+    
+    mutating func write(_ value:UInt16) {
+        self.bytes.append(UInt8(truncatingBitPattern: value))
+        self.bytes.append(UInt8(truncatingBitPattern: value >> 8))
+    }
+    
+    mutating func write(_ value:UInt32) {
+        for shift:UInt32 in [ 0, 8, 16, 24 ] {
+            self.bytes.append(UInt8(truncatingBitPattern: value >> shift))
+        }
+    }
+    
+    mutating func write(_ value:UInt64) {
+        for shift:UInt64 in [ 0, 8, 16, 24, 32, 40, 48, 56 ] {
+            self.bytes.append(UInt8(truncatingBitPattern: value >> shift))
+        }
+    }
+    
+    mutating func write(_ value:Data) {
+        self.bytes.append(contentsOf: [UInt8](value))
+    }
+    
+    mutating func write(_ value:[UInt8]) {
+        self.bytes.append(contentsOf: value)
+    }
+    
+/**
+ Writes the UTF-8 bytes of `value` preceded by their count as a `UInt32`.
+ */
+    mutating func write(_ value:String) {
+        let utf8 = [UInt8](value.utf8)
+        self.write(UInt32(utf8.count))
+        self.bytes.append(contentsOf: utf8)
+    }
+}
+
+/**
+ Reads the values written by `RGByteWriter`.  Every read returns `nil` instead of reading past the end.
+ */
+struct RGByteReader {
+    
+/**
+ The bytes being read.
+ */
+    let bytes:[UInt8]
+    
+/**
+ The position of the next read.
+ */
+    var offset = 0
+    
+    init(_ data:Data) {
+        self.bytes = [UInt8](data)
+    }
+    
+    init(_ bytes:[UInt8]) {
+        self.bytes = bytes
+    }
+    
+/**
+ The number of bytes not yet read.
+ */
+    var remaining:Int {
+        return self.bytes.count - self.offset
+    }
+    
+    mutating func readUInt8() -> UInt8? {
+        if self.remaining < 1 {
+            return nil
+        }
+        self.offset += 1
+        return self.bytes[self.offset - 1]
+    }
+    
+    mutating func readUInt16() -> UInt16? {
+        if self.remaining < 2 {
+            return nil
+        }
+        let value = UInt16(self.bytes[self.offset]) | UInt16(self.bytes[self.offset + 1]) << 8
+        self.offset += 2
+        return value
+    }
+    
+    mutating func readUInt32() -> UInt32? {
+        if self.remaining < 4 {
+            return nil
+        }
+        var value:UInt32 = 0
+        for index in 0..<4 {
+            value |= UInt32(self.bytes[self.offset + index]) << UInt32(8 * index)
+        }
+        self.offset += 4
+        return value
+    }
+    
+    mutating func readUInt64() -> UInt64? {
+        if self.remaining < 8 {
+            return nil
+        }
+        var value:UInt64 = 0
+        for index in 0..<8 {
+            value |= UInt64(self.bytes[self.offset + index]) << UInt64(8 * index)
+        }
+        self.offset += 8
+        return value
+    }
+    
+    mutating func readBytes(_ count:Int) -> [UInt8]? {
+        if count < 0 || self.remaining < count {
+            return nil
+        }
+        self.offset += count
+        return Array(self.bytes[(self.offset - count)..<self.offset])
+    }
+    
+    mutating func readData(_ count:Int) -> Data? {
+        let bytes = self.readBytes(count)
+        return bytes != nil ? Data(bytes: bytes!) : nil
+    }
+    
+/**
+ Reads a string written by `RGByteWriter.write(_:String)`.
+ */
+    mutating func readString() -> String? {
+        guard let count = self.readUInt32(), let utf8 = self.readBytes(Int(count)) else {
+            return nil
+        }
+        return String(bytes: utf8, encoding: String.Encoding.utf8)
+    }
+}
@@ -0,0 +1,124 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import CommonCrypto
+
+/**
+ HMAC-SHA-256 through CommonCrypto, fed incrementally.
+ */
+struct RGHMAC {
+    
+    static let tagLength = Int(CC_SHA256_DIGEST_LENGTH)
+    
+    private var context = CCHmacContext()
+    
+    init(key:[UInt8]) {
+        CCHmacInit(&self.context, CCHmacAlgorithm(kCCHmacAlgSHA256), key, key.count)
+    }
+    
+    static func authenticate(_ bytes:[UInt8], key:[UInt8]) -> [UInt8] {
+        var mac = RGHMAC(key: key)
+        mac.update(bytes)
+        return mac.finalize()
+    }
+    
+    mutating func update(_ bytes:[UInt8]) {
+        CCHmacUpdate(&self.context, bytes, bytes.count)
+    }
+    
+/**
+ - returns: The 32 byte tag.  The instance must not be used afterwards.
+ */
+    mutating func finalize() -> [UInt8] {
+        var tag = [UInt8](repeating: 0, count: RGHMAC.tagLength)
+        CCHmacFinal(&self.context, &tag)
+        return tag
+    }
+    
+/**
+ - returns: Whether the tags are equal, in time independent of where they differ.
+ */
+    static func isEqual(_ lhs:[UInt8], _ rhs:[UInt8]) -> Bool {
+        guard lhs.count == rhs.count else {
+            return false
+        }
+        var difference:UInt8 = 0
+        for index in 0 ..< lhs.count {
+            difference |= lhs[index] ^ rhs[index]
+        }
+        return difference == 0
+    }
+}
+
+/**
+ AES-256 in counter mode through CommonCrypto.  The 16 byte counter block is the nonce followed by the big-endian block
+   number.  Encrypting and decrypting are the same operation.
+ */
+final class RGCipher {
+    
+    static let blockLength = kCCBlockSizeAES128
+    
+    private var cryptor:CCCryptorRef? = nil
+    
+/**
+ - parameter key: 32 bytes.
+ - parameter nonce: 12 bytes, never reused with the same key.
+ - parameter counter: The first block number.
+ - returns: `nil` if CommonCrypto can't create the cipher.
+ */
+    init?(key:[UInt8], nonce:[UInt8], counter:UInt32 = 0) {
+        precondition(key.count == kCCKeySizeAES256 && nonce.count == 12)
+        var block = nonce
+        for shift:UInt32 in [ 24, 16, 8, 0 ] {
+            block.append(UInt8(truncatingBitPattern: counter >> shift))
+        }
+        let status = CCCryptorCreateWithMode(CCOperation(kCCEncrypt), CCMode(kCCModeCTR), CCAlgorithm(kCCAlgorithmAES),
+                                             CCPadding(ccNoPadding), block, key, key.count, nil, 0, 0,
+                                             CCModeOptions(kCCModeOptionCTR_BE), &self.cryptor)
+        if status != CCCryptorStatus(kCCSuccess) {
+            return nil
+        }
+    }
+    
+    deinit {
+        if let cryptor = self.cryptor {
+            CCCryptorRelease(cryptor)
+        }
+    }
+    
+/**
+ XORs the next `bytes.count` bytes of the keystream into `bytes`.
+ */
+    func apply(_ bytes:inout [UInt8]) {
+        let count = bytes.count
+        guard count > 0 else {
+            return
+        }
+        var moved = 0
+        bytes.withUnsafeMutableBytes({ buffer in
+            let status = CCCryptorUpdate(self.cryptor, buffer.baseAddress, count, buffer.baseAddress, count, &moved)
+            assert(status == CCCryptorStatus(kCCSuccess) && moved == count)
+        })
+    }
+}
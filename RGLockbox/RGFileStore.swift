@@ -0,0 +1,1007 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import Security
+import libkern
+
+/**
+ When a write to an `RGFileStore` reaches the disk.
+ */
+public enum RGFileDurability {
+    
+/**
+ Each call returns once its records are written and synced.  Callers arriving while a sync is in progress are
+   committed together by the next one.
+ */
+    case perWrite
+    
+/**
+ Each call returns once its records are queued; the queue is written and synced at most this many seconds later.  A
+   crash loses at most one window of writes.
+ */
+    case batch(TimeInterval)
+    
+/**
+ Each call returns once its records are queued; the queue is written in the background and only synced by
+   `synchronize()` or a compaction.  A crash of the process loses nothing written, a crash of the system may.
+ */
+    case async
+}
+
+/**
+ An item of an `RGFileStore` with the attributes the library reads back.
+ */
+struct RGFileItem {
+    let data:Data
+    let generic:Data?
+    let type:UInt32?
+    let accessible:String?
+    let isSynchronized:Bool
+    let modified:Date
+    
+/**
+ The length of the record which stores this item.
+ */
+    var recordLength = 0
+    
+    init(data:Data, generic:Data?, type:UInt32?, accessible:String?, isSynchronized:Bool, modified:Date) {
+        self.data = data
+        self.generic = generic
+        self.type = type
+        self.accessible = accessible
+        self.isSynchronized = isSynchronized
+        self.modified = modified
+    }
+}
+
+/**
+ The items a keychain query selects: those whose service, account, and access group equal the ones the query gives.
+ */
+struct RGFileQuery {
+    let service:String?
+    let account:String?
+    let accessGroup:String?
+    let returnsData:Bool
+    let returnsAttributes:Bool
+    let returnsAll:Bool
+    
+    init(_ query:CFDictionary) {
+        let dictionary = query as NSDictionary
+        self.service = dictionary[kSecAttrService as String] as? String
+        self.account = dictionary[kSecAttrAccount as String] as? String
+        self.accessGroup = dictionary[kSecAttrAccessGroup as String] as? String
+        self.returnsData = (dictionary[kSecReturnData as String] as? NSNumber)?.boolValue ?? false
+        self.returnsAttributes = (dictionary[kSecReturnAttributes as String] as? NSNumber)?.boolValue ?? false
+        self.returnsAll = (dictionary[kSecMatchLimit as String] as? String) == (kSecMatchLimitAll as String)
+    }
+    
+/**
+ The key of the item the query names.
+ */
+    var key:RGMultiKey {
+        return RGMultiKey(withFirst: self.service, second: self.account, third: self.accessGroup)
+    }
+    
+    func matches(_ key:RGMultiKey) -> Bool {
+        return (self.service == nil || key.first == self.service)
+            && (self.account == nil || key.second == self.account)
+            && (self.accessGroup == nil || key.third == self.accessGroup)
+    }
+}
+
+/**
+ The records other stores appended to a log since it was last read.
+ */
+struct RGFileDelta {
+    let epoch:Int64
+    let tail:Int
+    let changes:[(RGMultiKey, RGFileItem?)]
+    
+/**
+ Whether `changes` replay the whole log because it was compacted since it was last read.  `descriptor` is then open on
+   the new log.
+ */
+    let isComplete:Bool
+    let descriptor:Int32
+}
+
+/**
+ `RGFileStore` keeps generic password items in an append-only log file instead of the keychain, for platforms or
+   tests without one.  `install()` routes the `rg_SecItem*` hooks through it.  Items are held in memory; every change
+   appends a record to the log and the log is rewritten with only the live items once mostly superseded.
+ 
+ Writes are committed in groups: each call appends its records to a shared batch under a lock and the first caller
+   to find no commit in progress writes and syncs the whole batch while later callers join the next one.  Every caller
+   in a batch is released by the same sync, so concurrent writers share the cost of one `fdatasync` rather than
+   paying for one each.  Writes made through `RGLockbox` arrive one at a time from `keychainQueue`; use `.batch` to
+   keep that queue from waiting on the disk.
+ 
+ When the log is opened, anything past its committed length is discarded, as is a record whose checksum shows it
+   was torn by a crash, together with everything after it.
+ 
+ Any number of stores, in this or other processes, may share a log.  They coordinate through a small index file next to
+   it which each maps into memory: its header holds the length of the log up to the last committed record and an epoch
+   advanced by every compaction.  A store appends under an exclusive `flock` of the index, first reading the records
+   others appended since its own last commit.  Before answering a call a store compares the shared length and epoch
+   with its own and, if another store appended, reads only the new tail of the log; after a compaction it reads the new
+   log once.  Two processes adding the same item at once may both succeed; the later record wins.
+ */
+open class RGFileStore {
+    
+    static let magic:UInt64 = 0x52545346424c4752 // "RGLBFSTR"
+    static let version:UInt8 = 1
+    
+/**
+ Identifies a file as the index of a log ("RGLBFIDX"); it is the first word of the index.  The second word is the
+   committed length of the log and the third its epoch.
+ */
+    static let indexMagic:Int64 = 0x52474C4246494458
+    static let indexWords = 3
+    
+    static let putRecord:UInt8 = 1
+    static let removeRecord:UInt8 = 2
+    
+/**
+ The path of the log.
+ */
+    open let path:String
+    
+/**
+ When writes reach the disk.
+ */
+    open let durability:RGFileDurability
+    
+/**
+ The log is compacted once it is longer than this and more than half of it is superseded records.
+ */
+    open var compactionThreshold = 1 << 20
+    
+/**
+ The shared index and its header mapped into memory.
+ */
+    private let indexDescriptor:Int32
+    private let index:UnsafeMutablePointer<Int64>
+    
+    private let flushQueue:DispatchQueue
+    
+/**
+ This lock guards every property below.  It is not held while a batch is written or synced.
+ */
+    private let condition = NSCondition()
+    private var items:[RGMultiKey : RGFileItem]
+    private var liveBytes = 0
+    
+/**
+ The open log, the epoch it was read at, and its length up to the last record read or written.  While a commit is in
+   progress these belong to the committing thread.
+ */
+    private var descriptor:Int32
+    private var epoch:Int64
+    private var fileLength:Int
+    
+/**
+ Records not yet written and the items they change, and the sequence of the last call which appended to them.
+ */
+    private var batch:[UInt8] = []
+    private var batchKeys = Set<RGMultiKey>()
+    private var appendedSequence = 0
+    private var writtenSequence = 0
+    private var durableSequence = 0
+    
+/**
+ The sequences of calls whose batch could not be written; their changes were rolled back.
+ */
+    private var lostSequences:[CountableClosedRange<Int>] = []
+    private var isCommitting = false
+    private var isFlushScheduled = false
+    private var syncs = 0
+    private var records = 0
+    
+/**
+ Opens or creates the log at `path` and loads its items.  The log is opened under an exclusive `flock` of the index so
+   no compaction can replace it before it is read.
+ - parameter path: Location of the log.
+ - parameter durability: When writes reach the disk.
+ - returns: `nil` if the file cannot be opened or is not a log.
+ */
+    public init?(path:String, durability:RGFileDurability = .perWrite) {
+        let indexFD = open(path + ".index", O_RDWR | O_CREAT, 0o600)
+        if indexFD < 0 {
+            RGLogs(.error, "unable to open file store index at \(path) errno \(errno)")
+            return nil
+        }
+        flock(indexFD, LOCK_EX)
+        defer { flock(indexFD, LOCK_UN) }
+        let fd = open(path, O_RDWR | O_CREAT, 0o600)
+        if fd < 0 {
+            RGLogs(.error, "unable to open file store at \(path) errno \(errno)")
+            close(indexFD)
+            return nil
+        }
+        let indexLength = RGFileStore.indexWords * MemoryLayout<Int64>.size
+        var info = stat()
+        fstat(indexFD, &info)
+        let pointer = info.st_size >= off_t(indexLength) || ftruncate(indexFD, off_t(indexLength)) == 0
+            ? mmap(nil, indexLength, PROT_READ | PROT_WRITE, MAP_SHARED, indexFD, 0) : nil
+        if pointer == nil || pointer == UnsafeMutableRawPointer(bitPattern: -1) {
+            RGLogs(.error, "unable to map file store index at \(path) errno \(errno)")
+            close(indexFD)
+            close(fd)
+            return nil
+        }
+        let index = pointer!.bindMemory(to: Int64.self, capacity: RGFileStore.indexWords)
+        let isIndexed = index[0] == RGFileStore.indexMagic
+        let published = isIndexed ? Int(index[1]) : 0
+        var epoch = isIndexed ? index[2] : 0
+        fstat(fd, &info)
+        var bytes = RGFileStore.read(fd, from: 0, to: Int(info.st_size)) ?? []
+        if bytes.count == 0 {
+            var writer = RGByteWriter()
+            writer.write(RGFileStore.magic)
+            writer.write(RGFileStore.version)
+            bytes = writer.bytes
+            if !RGFileStore.write(bytes, to: fd, at: 0) || !RGFileStore.sync(fd) {
+                RGLogs(.error, "unable to create file store at \(path) errno \(errno)")
+                munmap(pointer, indexLength)
+                close(indexFD)
+                close(fd)
+                return nil
+            }
+        }
+        if isIndexed && bytes.count >= published {
+            bytes = Array(bytes[0 ..< published])
+        }
+        guard let (changes, length) = RGFileStore.replay(bytes) else {
+            RGLogs(.error, "file store at \(path) has an incompatible header")
+            munmap(pointer, indexLength)
+            close(indexFD)
+            close(fd)
+            return nil
+        }
+        if isIndexed && length != published {
+            epoch += 1
+        }
+        if length < Int(info.st_size) {
+            RGLogs(.warning, "discarding \(Int(info.st_size) - length) torn bytes at the end of file store \(path)")
+            ftruncate(fd, off_t(length))
+            _ = RGFileStore.sync(fd)
+        }
+        index[1] = Int64(length)
+        index[2] = epoch
+        OSMemoryBarrier()
+        index[0] = RGFileStore.indexMagic
+        msync(pointer, indexLength, MS_SYNC)
+        let items = RGFileStore.items(from: changes)
+        self.path = path
+        self.durability = durability
+        self.indexDescriptor = indexFD
+        self.index = index
+        self.flushQueue = DispatchQueue(label: "RGFileStore-Flush", qos: .utility)
+        self.items = items
+        self.liveBytes = items.values.reduce(0, { $0 + $1.recordLength })
+        self.descriptor = fd
+        self.epoch = epoch
+        self.fileLength = length
+    }
+    
+    deinit {
+        munmap(self.index, RGFileStore.indexWords * MemoryLayout<Int64>.size)
+        close(self.indexDescriptor)
+        close(self.descriptor)
+    }
+    
+/**
+ Routes `rg_SecItemCopyMatch`, `rg_SecItemAdd`, `rg_SecItemUpdate`, and `rg_SecItemDelete` through this store.
+ */
+    open func install() {
+        rg_SecItemCopyMatch = { self.copyMatching($0, $1) }
+        rg_SecItemAdd = { self.add($0) }
+        rg_SecItemUpdate = { self.update($0, $1) }
+        rg_SecItemDelete = { self.delete($0) }
+    }
+    
+/**
+ Routes the `rg_SecItem*` hooks back to the keychain.
+ */
+    open static func uninstall() {
+        rg_SecItemCopyMatch = { SecItemCopyMatching($0, $1) }
+        rg_SecItemAdd = { SecItemAdd($0, nil) }
+        rg_SecItemUpdate = { SecItemUpdate($0, $1) }
+        rg_SecItemDelete = { SecItemDelete($0) }
+    }
+    
+/**
+ The number of syncs issued, each of which made one or more batches durable.
+ */
+    open var syncCount:Int {
+        self.condition.lock()
+        defer { self.condition.unlock() }
+        return self.syncs
+    }
+    
+/**
+ The number of writes whose records reached the log since it was opened.
+ */
+    open var recordCount:Int {
+        self.condition.lock()
+        defer { self.condition.unlock() }
+        return self.records
+    }
+    
+/**
+ The length of the log in bytes up to the last record this store read or wrote.
+ */
+    open var length:Int {
+        self.condition.lock()
+        defer { self.condition.unlock() }
+        return self.fileLength
+    }
+    
+/**
+ Answers like `SecItemCopyMatching`.
+ */
+    open func copyMatching(_ query:CFDictionary, _ result:UnsafeMutablePointer<CFTypeRef?>?) -> OSStatus {
+        let query = RGFileQuery(query)
+        self.condition.lock()
+        self.refresh()
+        var matches:[(RGMultiKey, RGFileItem)] = []
+        if query.service != nil && query.account != nil && query.accessGroup != nil {
+            if let item = self.items[query.key] {
+                matches.append((query.key, item))
+            }
+        } else {
+            for (key, item) in self.items where query.matches(key) {
+                matches.append((key, item))
+                if !query.returnsAll {
+                    break
+                }
+            }
+        }
+        self.condition.unlock()
+        if matches.count == 0 {
+            return errSecItemNotFound
+        }
+        let values = matches.map({ RGFileStore.value(of: $0.1, key: $0.0, query: query) })
+        if query.returnsAll {
+            result?.pointee = values as NSArray
+        } else if query.returnsData || query.returnsAttributes {
+            result?.pointee = values[0]
+        }
+        return errSecSuccess
+    }
+    
+/**
+ Adds an item like `SecItemAdd`.
+ */
+    open func add(_ query:CFDictionary) -> OSStatus {
+        let fileQuery = RGFileQuery(query)
+        let dictionary = query as NSDictionary
+        guard fileQuery.service != nil, let data = dictionary[kSecValueData as String] as? Data else {
+            return errSecParam
+        }
+        let item = RGFileItem(data: data,
+                              generic: dictionary[kSecAttrGeneric as String] as? Data,
+                              type: (dictionary[kSecAttrType as String] as? NSNumber)?.uint32Value,
+                              accessible: dictionary[kSecAttrAccessible as String] as? String,
+                              isSynchronized: (dictionary[kSecAttrSynchronizable as String] as? NSNumber)?.boolValue
+                                ?? false,
+                              modified: Date())
+        self.condition.lock()
+        self.refresh()
+        if self.items[fileQuery.key] != nil {
+            self.condition.unlock()
+            return errSecDuplicateItem
+        }
+        return self.commit([ (fileQuery.key, item) ])
+    }
+    
+/**
+ Changes the value and attributes of every matching item like `SecItemUpdate`.
+ */
+    open func update(_ query:CFDictionary, _ attributes:CFDictionary) -> OSStatus {
+        let fileQuery = RGFileQuery(query)
+        let attributes = attributes as NSDictionary
+        let date = Date()
+        self.condition.lock()
+        self.refresh()
+        let changes = self.items.filter({ fileQuery.matches($0.key) }).map({ (key, item) -> (RGMultiKey, RGFileItem?) in
+            let synchronizable = (attributes[kSecAttrSynchronizable as String] as? NSNumber)?.boolValue
+            return (key, RGFileItem(data: attributes[kSecValueData as String] as? Data ?? item.data,
+                                    generic: attributes[kSecAttrGeneric as String] as? Data ?? item.generic,
+                                    type: (attributes[kSecAttrType as String] as? NSNumber)?.uint32Value ?? item.type,
+                                    accessible: attributes[kSecAttrAccessible as String] as? String ?? item.accessible,
+                                    isSynchronized: synchronizable ?? item.isSynchronized,
+                                    modified: date))
+        })
+        if changes.count == 0 {
+            self.condition.unlock()
+            return errSecItemNotFound
+        }
+        return self.commit(changes)
+    }
+    
+/**
+ Removes every matching item like `SecItemDelete`.
+ */
+    open func delete(_ query:CFDictionary) -> OSStatus {
+        let fileQuery = RGFileQuery(query)
+        self.condition.lock()
+        self.refresh()
+        let changes = self.items.keys.filter({ fileQuery.matches($0) }).map({ (key) -> (RGMultiKey, RGFileItem?) in
+            return (key, nil)
+        })
+        if changes.count == 0 {
+            self.condition.unlock()
+            return errSecItemNotFound
+        }
+        return self.commit(changes)
+    }
+    
+/**
+ Waits until every write made so far is written and synced.
+ - returns: `false` if any of them could not be written.
+ */
+    @discardableResult
+    open func synchronize() -> Bool {
+        self.condition.lock()
+        let status = self.awaitDurable(self.appendedSequence)
+        self.condition.unlock()
+        return status == errSecSuccess
+    }
+    
+/**
+ Rewrites the log with only the live items.
+ - returns: `false` if the new log could not be written; the old one is kept.
+ */
+    @discardableResult
+    open func compact() -> Bool {
+        self.condition.lock()
+        while self.isCommitting {
+            self.condition.wait()
+        }
+        let compacted = self.compactLocked()
+        self.condition.unlock()
+        return compacted
+    }
+    
+/**
+ Applies `changes` to `items`, appends their records to `batch`, and waits as `durability` requires.  Must hold
+   `condition`, which is released on return.
+ - returns: `errSecSuccess`, or `errSecIO` if the batch could not be written and the changes were rolled back.
+ */
+    private func commit(_ changes:[(RGMultiKey, RGFileItem?)]) -> OSStatus {
+        for (key, item) in changes {
+            let record = RGFileStore.record(key, item: item)
+            self.liveBytes -= self.items[key]?.recordLength ?? 0
+            if var item = item {
+                item.recordLength = record.count
+                self.liveBytes += record.count
+                self.items[key] = item
+            } else {
+                self.items[key] = nil
+            }
+            self.batch.append(contentsOf: record)
+            self.batchKeys.insert(key)
+        }
+        self.appendedSequence += 1
+        let sequence = self.appendedSequence
+        var status = errSecSuccess
+        switch self.durability {
+        case .perWrite:
+            status = self.awaitDurable(sequence)
+        case .batch(let window):
+            self.scheduleFlush(after: window, sync: true)
+        case .async:
+            self.scheduleFlush(after: 0, sync: false)
+        }
+        self.condition.unlock()
+        return status
+    }
+    
+/**
+ Waits until the call with `sequence` is durable, committing the batch itself whenever no one else is.  Must hold
+   `condition`.
+ */
+    private func awaitDurable(_ sequence:Int) -> OSStatus {
+        while true {
+            if self.lostSequences.contains(where: { $0.contains(sequence) }) {
+                return errSecIO
+            } else if self.durableSequence >= sequence {
+                return errSecSuccess
+            } else if !self.isCommitting {
+                self.commitBatch(sync: true)
+            } else {
+                self.condition.wait()
+            }
+        }
+    }
+    
+    private func scheduleFlush(after delay:TimeInterval, sync:Bool) {
+        if self.isFlushScheduled {
+            return
+        }
+        self.isFlushScheduled = true
+        self.flushQueue.asyncAfter(deadline: .now() + delay, execute: {
+            self.condition.lock()
+            self.isFlushScheduled = false
+            while self.isCommitting {
+                self.condition.wait()
+            }
+            if self.writtenSequence < self.appendedSequence || (sync && self.durableSequence < self.writtenSequence) {
+                self.commitBatch(sync: sync)
+            }
+            self.condition.unlock()
+        })
+    }
+    
+/**
+ Reads the records other stores committed and writes `batch` after them, syncing it if `sync`.  Must hold `condition`
+   with no commit in progress; it is released while writing so other callers may append to the next batch.
+ */
+    private func commitBatch(sync:Bool) {
+        self.isCommitting = true
+        let pending = self.batch
+        let pendingKeys = self.batchKeys
+        let through = self.appendedSequence
+        self.batch.removeAll()
+        self.batchKeys.removeAll()
+        self.condition.unlock()
+        flock(self.indexDescriptor, LOCK_EX)
+        let delta = self.readShared()
+        var isWritten = false
+        if let delta = delta {
+            isWritten = RGFileStore.write(pending, to: delta.descriptor, at: delta.tail)
+            if isWritten && sync {
+                isWritten = RGFileStore.sync(delta.descriptor)
+            }
+            if isWritten {
+                self.publish(tail: delta.tail + pending.count, epoch: delta.epoch, sync: sync)
+            } else {
+                ftruncate(delta.descriptor, off_t(delta.tail))
+            }
+        }
+        flock(self.indexDescriptor, LOCK_UN)
+        self.condition.lock()
+        self.isCommitting = false
+        if let delta = delta {
+            self.apply(delta, preserving: pendingKeys.union(self.batchKeys))
+        }
+        if isWritten {
+            self.fileLength += pending.count
+            self.records += through - self.writtenSequence
+            self.writtenSequence = through
+            if sync {
+                self.syncs += 1
+                self.durableSequence = through
+                if self.fileLength > self.compactionThreshold && self.fileLength > 2 * self.liveBytes {
+                    self.compactLocked()
+                }
+            }
+        } else {
+            self.rollBack()
+        }
+        self.condition.broadcast()
+    }
+    
+/**
+ Discards every change not yet written after a failed write and reloads `items` from the log.  Must hold `condition`.
+ */
+    private func rollBack() {
+        RGLogs(.error, "unable to write file store at \(self.path) errno \(errno)")
+        if self.writtenSequence < self.appendedSequence {
+            self.lostSequences.append((self.writtenSequence + 1) ... self.appendedSequence)
+        }
+        self.writtenSequence = self.appendedSequence
+        self.batch.removeAll()
+        self.batchKeys.removeAll()
+        if let bytes = RGFileStore.read(self.descriptor, from: 0, to: self.fileLength),
+           let (changes, _) = RGFileStore.replay(bytes) {
+            self.items = RGFileStore.items(from: changes)
+            self.liveBytes = self.items.values.reduce(0, { $0 + $1.recordLength })
+        }
+    }
+    
+/**
+ Reads what other stores committed if the shared index shows any.  Must hold `condition` with no commit in progress.
+ */
+    private func refresh() {
+        if self.isCommitting || (self.sharedEpoch == self.epoch && self.sharedTail == self.fileLength) {
+            return
+        }
+        flock(self.indexDescriptor, LOCK_SH)
+        let delta = self.readShared()
+        flock(self.indexDescriptor, LOCK_UN)
+        if let delta = delta {
+            self.apply(delta, preserving: self.batchKeys)
+        } else {
+            RGLogs(.error, "unable to read file store at \(self.path) errno \(errno)")
+        }
+    }
+    
+/**
+ The committed length of the log and its epoch, read without a lock.
+ */
+    private var sharedTail:Int {
+        return Int(OSAtomicAdd64Barrier(0, self.index + 1))
+    }
+    
+    private var sharedEpoch:Int64 {
+        return OSAtomicAdd64Barrier(0, self.index + 2)
+    }
+    
+/**
+ Records a commit in the shared index.  The index is synced too if `sync`, since the log is cut back to the committed
+   length when opened and a synced record past a stale length would be lost.  Must hold an exclusive `flock` of the
+   index.
+ */
+    private func publish(tail:Int, epoch:Int64, sync:Bool) {
+        self.index[2] = epoch
+        OSMemoryBarrier()
+        self.index[1] = Int64(tail)
+        OSMemoryBarrier()
+        if sync && msync(self.index, RGFileStore.indexWords * MemoryLayout<Int64>.size, MS_SYNC) != 0 {
+            RGLogs(.error, "unable to sync file store index at \(self.path) errno \(errno)")
+        }
+    }
+    
+/**
+ Reads the records committed since `fileLength`, or the whole log if it was compacted since `epoch`.  Must hold a
+   `flock` of the index and either `condition` or the commit in progress.
+ - returns: `nil` if the log could not be read.
+ */
+    private func readShared() -> RGFileDelta? {
+        let epoch = self.sharedEpoch
+        let tail = self.sharedTail
+        if epoch != self.epoch {
+            let fd = open(self.path, O_RDWR)
+            if fd >= 0, let bytes = RGFileStore.read(fd, from: 0, to: tail),
+               let (changes, _) = RGFileStore.replay(bytes) {
+                return RGFileDelta(epoch: epoch, tail: tail, changes: changes, isComplete: true, descriptor: fd)
+            }
+            if fd >= 0 {
+                close(fd)
+            }
+            return nil
+        }
+        let start = min(self.fileLength, tail)
+        guard let bytes = RGFileStore.read(self.descriptor, from: start, to: tail) else {
+            return nil
+        }
+        let (changes, _) = RGFileStore.records(in: bytes, from: 0)
+        return RGFileDelta(epoch: epoch, tail: tail, changes: changes, isComplete: false, descriptor: self.descriptor)
+    }
+    
+/**
+ Applies what other stores committed to `items`, leaving alone the items in `keys` which this store changed since.
+   Must hold `condition`.
+ */
+    private func apply(_ delta:RGFileDelta, preserving keys:Set<RGMultiKey>) {
+        if delta.isComplete {
+            var items = RGFileStore.items(from: delta.changes)
+            for key in keys {
+                items[key] = self.items[key]
+            }
+            self.items = items
+            self.liveBytes = items.values.reduce(0, { $0 + $1.recordLength })
+            if delta.descriptor != self.descriptor {
+                close(self.descriptor)
+                self.descriptor = delta.descriptor
+            }
+        } else {
+            for (key, item) in delta.changes where !keys.contains(key) {
+                self.liveBytes += (item?.recordLength ?? 0) - (self.items[key]?.recordLength ?? 0)
+                self.items[key] = item
+            }
+        }
+        self.epoch = delta.epoch
+        self.fileLength = delta.tail
+    }
+    
+/**
+ Replaces the log with a new one holding only `items` and advances the epoch so other stores read it again.  Must hold
+   `condition` with no commit in progress.
+ */
+    @discardableResult
+    private func compactLocked() -> Bool {
+        flock(self.indexDescriptor, LOCK_EX)
+        defer { flock(self.indexDescriptor, LOCK_UN) }
+        guard let delta = self.readShared() else {
+            RGLogs(.error, "unable to read file store at \(self.path) errno \(errno)")
+            return false
+        }
+        self.apply(delta, preserving: self.batchKeys)
+        var writer = RGByteWriter()
+        writer.write(RGFileStore.magic)
+        writer.write(RGFileStore.version)
+        for (key, item) in self.items {
+            writer.write(RGFileStore.record(key, item: item))
+        }
+        let temporary = self.path + ".compacting"
+        let fd = open(temporary, O_RDWR | O_CREAT | O_TRUNC, 0o600)
+        if fd < 0 || !RGFileStore.write(writer.bytes, to: fd, at: 0) || !RGFileStore.sync(fd)
+            || rename(temporary, self.path) != 0 {
+            RGLogs(.error, "unable to compact file store at \(self.path) errno \(errno)")
+            if fd >= 0 {
+                close(fd)
+                unlink(temporary)
+            }
+            return false
+        }
+        let directory = open((self.path as NSString).deletingLastPathComponent, O_RDONLY)
+        if directory >= 0 {
+            fsync(directory)
+            close(directory)
+        }
+        close(self.descriptor)
+        self.descriptor = fd
+        self.epoch += 1
+        self.fileLength = writer.bytes.count
+        self.publish(tail: self.fileLength, epoch: self.epoch, sync: true)
+        self.batch.removeAll()
+        self.batchKeys.removeAll()
+        self.records += self.appendedSequence - self.writtenSequence
+        self.writtenSequence = self.appendedSequence
+        self.durableSequence = self.appendedSequence
+        self.syncs += 1
+        return true
+    }
+    
+/**
+ - returns: What the keychain would return for `item` under `query`.
+ */
+    static func value(of item:RGFileItem, key:RGMultiKey, query:RGFileQuery) -> AnyObject {
+        if !query.returnsAttributes {
+            return item.data as NSData
+        }
+        var attributes:[String:Any] = [
+            kSecClass as String : kSecClassGenericPassword,
+            kSecAttrService as String : key.first ?? "",
+            kSecAttrSynchronizable as String : item.isSynchronized as NSNumber,
+            kSecAttrModificationDate as String : item.modified
+        ]
+        attributes[kSecAttrAccount as String] = key.second
+        attributes[kSecAttrAccessGroup as String] = key.third
+        attributes[kSecAttrGeneric as String] = item.generic
+        attributes[kSecAttrType as String] = item.type.map({ NSNumber(value: $0) })
+        attributes[kSecAttrAccessible as String] = item.accessible
+        attributes[kSecValueData as String] = query.returnsData ? item.data : nil
+        return attributes as NSDictionary
+    }
+    
+/**
+ A record is its length, the FNV-1a hash of its body, and a body naming the item followed by its value and attributes
+   unless it removes the item.
+ - returns: The record which stores `item` at `key`, or removes `key` if `item` is `nil`.
+ */
+    static func record(_ key:RGMultiKey, item:RGFileItem?) -> [UInt8] {
+        var body = RGByteWriter()
+        body.write(item != nil ? RGFileStore.putRecord : RGFileStore.removeRecord)
+        var flags:UInt8 = key.second != nil ? 1 : 0
+        flags |= key.third != nil ? 2 : 0
+        flags |= item?.generic != nil ? 4 : 0
+        flags |= item?.accessible != nil ? 8 : 0
+        flags |= (item?.isSynchronized ?? false) ? 16 : 0
+        flags |= item?.type != nil ? 32 : 0
+        body.write(flags)
+        for component in [ key.first, key.second, key.third ] {
+            if let component = component {
+                body.write(component)
+            }
+        }
+        if let item = item {
+            body.write(item.modified.timeIntervalSinceReferenceDate.bitPattern)
+            body.write(UInt32(item.data.count))
+            body.write(item.data)
+            if let generic = item.generic {
+                body.write(UInt32(generic.count))
+                body.write(generic)
+            }
+            if let accessible = item.accessible {
+                body.write(accessible)
+            }
+            if let type = item.type {
+                body.write(type)
+            }
+        }
+        var record = RGByteWriter()
+        record.write(UInt32(body.bytes.count))
+        record.write(RGFileStore.checksum(body.bytes))
+        record.write(body.bytes)
+        return record.bytes
+    }
+    
+/**
+ - returns: The changes recorded by a log in order and the length of its intact prefix, `nil` if `bytes` is not a log.
+ */
+    static func replay(_ bytes:[UInt8]) -> ([(RGMultiKey, RGFileItem?)], Int)? {
+        var reader = RGByteReader(bytes)
+        guard reader.readUInt64() == RGFileStore.magic, reader.readUInt8() == RGFileStore.version else {
+            return nil
+        }
+        return RGFileStore.records(in: bytes, from: reader.offset)
+    }
+    
+/**
+ - returns: The changes recorded by the records of `bytes` from `offset` on and the offset after the last intact one.
+ */
+    static func records(in bytes:[UInt8], from offset:Int) -> ([(RGMultiKey, RGFileItem?)], Int) {
+        var reader = RGByteReader(bytes)
+        reader.offset = offset
+        var changes:[(RGMultiKey, RGFileItem?)] = []
+        var length = offset
+        while let count = reader.readUInt32(),
+              let checksum = reader.readUInt64(),
+              let body = reader.readBytes(Int(count)),
+              checksum == RGFileStore.checksum(body),
+              let (key, item) = RGFileStore.parse(body) {
+            if var item = item {
+                item.recordLength = reader.offset - length
+                changes.append((key, item))
+            } else {
+                changes.append((key, nil))
+            }
+            length = reader.offset
+        }
+        return (changes, length)
+    }
+    
+/**
+ - returns: The items left by applying `changes` in order.
+ */
+    static func items(from changes:[(RGMultiKey, RGFileItem?)]) -> [RGMultiKey : RGFileItem] {
+        var items:[RGMultiKey : RGFileItem] = [:]
+        for (key, item) in changes {
+            items[key] = item
+        }
+        return items
+    }
+    
+/**
+ - returns: The key and item of a record body, `nil` if it is malformed.
+ */
+    static func parse(_ body:[UInt8]) -> (RGMultiKey, RGFileItem?)? {
+        var reader = RGByteReader(body)
+        guard let kind = reader.readUInt8(), let flags = reader.readUInt8(), let service = reader.readString() else {
+            return nil
+        }
+        var key = RGMultiKey(withFirst: service)
+        if flags & 1 != 0 {
+            guard let account = reader.readString() else {
+                return nil
+            }
+            key.second = account
+        }
+        if flags & 2 != 0 {
+            guard let accessGroup = reader.readString() else {
+                return nil
+            }
+            key.third = accessGroup
+        }
+        if kind == RGFileStore.removeRecord {
+            if reader.remaining != 0 {
+                return nil
+            }
+            let removed:RGFileItem? = nil
+            return (key, removed)
+        }
+        guard kind == RGFileStore.putRecord,
+              let modified = reader.readUInt64(),
+              let count = reader.readUInt32(),
+              let data = reader.readData(Int(count)) else {
+            return nil
+        }
+        var generic:Data? = nil
+        if flags & 4 != 0 {
+            guard let genericCount = reader.readUInt32(), let genericData = reader.readData(Int(genericCount)) else {
+                return nil
+            }
+            generic = genericData
+        }
+        var accessible:String? = nil
+        if flags & 8 != 0 {
+            guard let value = reader.readString() else {
+                return nil
+            }
+            accessible = value
+        }
+        var type:UInt32? = nil
+        if flags & 32 != 0 {
+            guard let value = reader.readUInt32() else {
+                return nil
+            }
+            type = value
+        }
+        if reader.remaining != 0 {
+            return nil
+        }
+        let item = RGFileItem(data: data,
+                              generic: generic,
+                              type: type,
+                              accessible: accessible,
+                              isSynchronized: flags & 16 != 0,
+                              modified: Date(timeIntervalSinceReferenceDate: Double(bitPattern: modified)))
+        return (key, item)
+    }
+    
+/**
+ - returns: The 64-bit FNV-1a hash of `bytes`.
+ */
+    static func checksum(_ bytes:[UInt8]) -> UInt64 {
+        var hash:UInt64 = 0xcbf29ce484222325
+        for byte in bytes {
+            hash = (hash ^ UInt64(byte)) &* 0x100000001b3
+        }
+        return hash
+    }
+    
+/**
+ - returns: The bytes of `fd` from `start` up to `end`, `nil` if they could not all be read.
+ */
+    static func read(_ fd:Int32, from start:Int, to end:Int) -> [UInt8]? {
+        var bytes = [UInt8](repeating: 0, count: max(end - start, 0))
+        var count = 0
+        while count < bytes.count {
+            let read = bytes.withUnsafeMutableBufferPointer({ buffer -> Int in
+                return pread(fd, buffer.baseAddress! + count, buffer.count - count, off_t(start + count))
+            })
+            if read < 0 && errno == EINTR {
+                continue
+            } else if read <= 0 {
+                return nil
+            }
+            count += read
+        }
+        return bytes
+    }
+    
+/**
+ Writes all of `bytes` to `fd` starting at `offset`.
+ */
+    static func write(_ bytes:[UInt8], to fd:Int32, at offset:Int) -> Bool {
+        var written = 0
+        while written < bytes.count {
+            let count = bytes.withUnsafeBufferPointer({ buffer -> Int in
+                return pwrite(fd, buffer.baseAddress! + written, bytes.count - written, off_t(offset + written))
+            })
+            if count < 0 && errno == EINTR {
+                continue
+            } else if count <= 0 {
+                return false
+            }
+            written += count
+        }
+        return true
+    }
+    
+/**
+ Flushes the data written to `fd` to stable storage.
+ */
+    static func sync(_ fd:Int32) -> Bool {
+        #if os(Linux)
+            return fdatasync(fd) == 0
+        #else
+            return fcntl(fd, F_FULLFSYNC) == 0 || fsync(fd) == 0
+        #endif
+    }
+}
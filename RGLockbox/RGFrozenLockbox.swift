@@ -0,0 +1,268 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+
+/**
+ `RGFrozenLockbox` is an immutable snapshot of some items of an `RGLockbox`.  Keys are placed by a minimal perfect hash
+   built with hash and displace: each key hashes to a bucket, and each bucket stores the displacement which sends all of
+   its keys to distinct free slots of a table exactly as large as the key set.  A read hashes the key once, reads one
+   displacement, and compares the key in its slot; it takes no locks and builds no `RGMultiKey`.  Keys and values are
+   each packed contiguously.  Should no seed out of `maximumSeeds` place every key, slots are found through a dictionary
+   instead.  Threadsafe.
+ */
+open class RGFrozenLockbox {
+    
+/**
+ The number of items in the snapshot.
+ */
+    open let count:Int
+    
+    private let bucketCount:Int
+    private let seed:UInt64
+    private let displacements:[UInt32]
+    private let keyBytes:[UInt8]
+    private let keyOffsets:[Int]
+    private let valueBytes:Data
+    private let valueOffsets:[Int]
+    
+/**
+ The slot of each key when no perfect hash was found, `nil` otherwise.
+ */
+    private let fallbackSlots:[String : Int]?
+    
+/**
+ Each bucket holds this many keys on average.  Larger buckets save memory and take longer to place.
+ */
+    static let keysPerBucket = 4
+    
+/**
+ The number of seeds tried before giving up on a perfect hash.  Each seed fails only with small probability, so this
+   is reached only by key sets whose hashes collide whatever the seed.
+ */
+    static let maximumSeeds = 32
+    
+/**
+ - parameter values: The items of the snapshot by key.
+ */
+    public init(values:[String : Data]) {
+        let keys = values.keys.map({ $0 })
+        let count = keys.count
+        let bucketCount = max(1, (count + RGFrozenLockbox.keysPerBucket - 1) / RGFrozenLockbox.keysPerBucket)
+        var seed:UInt64 = 0
+        var displacements:[UInt32] = []
+        var slots:[Int] = []
+        var attempts = 0
+        while slots.count != count && attempts < RGFrozenLockbox.maximumSeeds {
+            seed = seed &+ 0x9e3779b97f4a7c15
+            (displacements, slots) = RGFrozenLockbox.place(keys, bucketCount: bucketCount, seed: seed)
+            attempts += 1
+        }
+        var fallbackSlots:[String : Int]? = nil
+        if slots.count != count {
+            RGLogs(.warning, "no perfect hash for \(count) keys after \(attempts) seeds, using a dictionary")
+            slots = Array(0 ..< count)
+            fallbackSlots = [:]
+            for (index, key) in keys.enumerated() {
+                fallbackSlots![key] = index
+            }
+        }
+        
+        var ordered = [Int](repeating: 0, count: count)
+        for (index, slot) in slots.enumerated() {
+            ordered[slot] = index
+        }
+        var keyBytes:[UInt8] = []
+        var keyOffsets:[Int] = [ 0 ]
+        var valueBytes = Data()
+        var valueOffsets:[Int] = [ 0 ]
+        for index in ordered {
+            keyBytes.append(contentsOf: keys[index].utf8)
+            keyOffsets.append(keyBytes.count)
+            valueBytes.append(values[keys[index]]!)
+            valueOffsets.append(valueBytes.count)
+        }
+        self.count = count
+        self.bucketCount = bucketCount
+        self.seed = seed
+        self.displacements = displacements
+        self.keyBytes = keyBytes
+        self.keyOffsets = keyOffsets
+        self.valueBytes = valueBytes
+        self.valueOffsets = valueOffsets
+        self.fallbackSlots = fallbackSlots
+    }
+    
+/**
+ - returns: The value of `key` when the snapshot was taken, `nil` if it had none.
+ */
+    open func dataForKey(_ key:String) -> Data? {
+        guard let slot = self.slot(of: key) else {
+            return nil
+        }
+        return self.valueBytes.subdata(in: self.valueOffsets[slot] ..< self.valueOffsets[slot + 1])
+    }
+    
+    open func stringForKey(_ key:String) -> String? {
+        guard let data = self.dataForKey(key) else {
+            return nil
+        }
+        return String(data: data, encoding: String.Encoding.utf8)
+    }
+    
+/**
+ The keys of the snapshot in slot order.
+ */
+    open var allKeys:[String] {
+        return (0 ..< self.count).map({ slot in
+            let bytes = self.keyBytes[self.keyOffsets[slot] ..< self.keyOffsets[slot + 1]]
+            return String(bytes: bytes, encoding: String.Encoding.utf8)!
+        })
+    }
+    
+/**
+ - returns: The slot holding `key`, `nil` if `key` is not in the snapshot.
+ */
+    private func slot(of key:String) -> Int? {
+        if self.count == 0 {
+            return nil
+        }
+        if let fallbackSlots = self.fallbackSlots {
+            return fallbackSlots[key]
+        }
+        let hashes = RGFrozenLockbox.hashes(key, seed: self.seed)
+        let displacement = UInt64(self.displacements[Int(hashes.bucket % UInt64(self.bucketCount))])
+        let slot = RGFrozenLockbox.slot(hashes, displacement: displacement, count: UInt64(self.count))
+        var offset = self.keyOffsets[slot]
+        let end = self.keyOffsets[slot + 1]
+        for byte in key.utf8 {
+            if offset == end || self.keyBytes[offset] != byte {
+                return nil
+            }
+            offset += 1
+        }
+        return offset == end ? slot : nil
+    }
+    
+/**
+ Places the largest buckets first, giving each the smallest displacement which sends its keys to free slots.
+ - returns: The displacement of each bucket and the slot of each key, or no slots if some bucket could not be placed
+   with this seed.
+ */
+    private static func place(_ keys:[String], bucketCount:Int, seed:UInt64) -> ([UInt32], [Int]) {
+        let count = keys.count
+        let hashes = keys.map({ RGFrozenLockbox.hashes($0, seed: seed) })
+        var buckets = [[Int]](repeating: [], count: bucketCount)
+        for (index, hash) in hashes.enumerated() {
+            buckets[Int(hash.bucket % UInt64(bucketCount))].append(index)
+        }
+        let order = (0 ..< bucketCount).sorted(by: { buckets[$0].count > buckets[$1].count })
+        var displacements = [UInt32](repeating: 0, count: bucketCount)
+        var slots = [Int](repeating: 0, count: count)
+        var isTaken = [Bool](repeating: false, count: count)
+        let maxDisplacement = UInt64(count) * 64
+        for bucket in order where buckets[bucket].count > 0 {
+            var displacement:UInt64 = 0
+            var placed:[Int] = []
+            while displacement < maxDisplacement {
+                placed.removeAll(keepingCapacity: true)
+                for index in buckets[bucket] {
+                    let hash = hashes[index]
+                    let slot = RGFrozenLockbox.slot(hash, displacement: displacement, count: UInt64(count))
+                    if isTaken[slot] || placed.contains(slot) {
+                        break
+                    }
+                    placed.append(slot)
+                }
+                if placed.count == buckets[bucket].count {
+                    break
+                }
+                displacement += 1
+            }
+            if placed.count != buckets[bucket].count {
+                return ([], [])
+            }
+            displacements[bucket] = UInt32(displacement)
+            for (index, slot) in zip(buckets[bucket], placed) {
+                slots[index] = slot
+                isTaken[slot] = true
+            }
+        }
+        return (displacements, slots)
+    }
+    
+/**
+ The slot of a key for a displacement, split as in CHD into a multiple of `step` and an offset so that every run of
+   `count` displacements visits every slot whatever `step` is.
+ */
+    private static func slot(_ hashes:(bucket:UInt64, position:UInt64, step:UInt64),
+                             displacement:UInt64,
+                             count:UInt64) -> Int {
+        return Int((hashes.position &+ (displacement / count) &* hashes.step &+ displacement % count) % count)
+    }
+    
+/**
+ Three independent hashes of `key` remixed from one seeded FNV-1a pass over its UTF-8.
+ */
+    private static func hashes(_ key:String, seed:UInt64) -> (bucket:UInt64, position:UInt64, step:UInt64) {
+        var hash:UInt64 = 0xcbf29ce484222325 ^ seed
+        for byte in key.utf8 {
+            hash = (hash ^ UInt64(byte)) &* 0x100000001b3
+        }
+        let bucket = RGFrozenLockbox.mix(hash)
+        let position = RGFrozenLockbox.mix(bucket)
+        return (bucket, position, RGFrozenLockbox.mix(position) | 1)
+    }
+    
+/**
+ The finalizer of SplitMix64.
+ */
+    private static func mix(_ value:UInt64) -> UInt64 {
+        var value = value &+ 0x9e3779b97f4a7c15
+        value = (value ^ (value >> 30)) &* 0xbf58476d1ce4e5b9
+        value = (value ^ (value >> 27)) &* 0x94d049bb133111eb
+        return value ^ (value >> 31)
+    }
+}
+
+extension RGLockbox {
+    
+/**
+ Loads `keys` and takes an immutable snapshot of their current values for fast reads.  Later writes are not seen by
+   the snapshot.  Keys without a value are left out.
+ - parameter keys: The keys to snapshot.
+ - returns: The snapshot.
+ */
+    public func freeze(keys:[String]) -> RGFrozenLockbox {
+        if keys.count > 1 {
+            _ = self.allItems()
+        }
+        var values:[String : Data] = [:]
+        for key in keys {
+            if let data = self.dataForKey(key) {
+                values[key] = data
+            }
+        }
+        return RGFrozenLockbox(values: values)
+    }
+}
@@ -0,0 +1,151 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import libkern
+
+/**
+ `RGGenerationTable` maps a small shared file of per-bucket generation counters into memory.  Every process which opens
+   the same path observes the same counters: writers advance the bucket of the key they wrote and readers compare the
+   generation they cached against the current one before trusting a cached value.
+ */
+open class RGGenerationTable {
+    
+/**
+ Identifies a file as a generation table ("RGLBGEN1"); it is the first word of the file's header.
+ */
+    static let magic:Int64 = 0x52474C4247454E31
+    
+/**
+ Number of `Int64` words preceding the counters: the magic and the bucket count.
+ */
+    static let headerWords = 2
+    
+/**
+ The path of the backing file.
+ */
+    open let path:String
+    
+/**
+ The number of counters in the table.  Every process sharing `path` must agree on this value.
+ */
+    open let bucketCount:Int
+    
+/**
+ The base address and length of the shared mapping.
+ */
+    private let mapping:UnsafeMutableRawPointer
+    private let mappingLength:Int
+    
+/**
+ The first counter within `mapping`.
+ */
+    private let counters:UnsafeMutablePointer<Int64>
+    
+/**
+ Opens or creates the table at `path`.
+ - parameter path: Location of the shared file, for example inside an app group container.
+ - parameter bucketCount: The number of counters; keys are hashed into buckets by `RGMultiKey.stableHash`.
+ - returns: `nil` if the file cannot be mapped or was created with a different `bucketCount`.
+ */
+    public init?(path:String, bucketCount:Int = 4096) {
+        precondition(bucketCount > 0, "a generation table needs at least one bucket")
+        let length = (RGGenerationTable.headerWords + bucketCount) * MemoryLayout<Int64>.size
+        let fd = open(path, O_RDWR | O_CREAT, 0o644)
+        if fd < 0 {
+            RGLogs(.error, "unable to open generation table at \(path) errno \(errno)")
+            return nil
+        }
+        defer { close(fd) }
+        flock(fd, LOCK_EX)
+        defer { flock(fd, LOCK_UN) }
+        var info = stat()
+        fstat(fd, &info)
+        let isNew = info.st_size == 0
+        if isNew && ftruncate(fd, off_t(length)) != 0 {
+            RGLogs(.error, "unable to size generation table at \(path) errno \(errno)")
+            return nil
+        } else if !isNew && Int(info.st_size) != length {
+            RGLogs(.error, "generation table at \(path) has size \(info.st_size) expected \(length)")
+            return nil
+        }
+        let pointer = mmap(nil, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+        if pointer == nil || pointer == UnsafeMutableRawPointer(bitPattern: -1) {
+            RGLogs(.error, "unable to map generation table at \(path) errno \(errno)")
+            return nil
+        }
+        let header = pointer!.bindMemory(to: Int64.self, capacity: RGGenerationTable.headerWords + bucketCount)
+        if isNew {
+            header[1] = Int64(bucketCount)
+            OSMemoryBarrier()
+            header[0] = RGGenerationTable.magic
+        } else if header[0] != RGGenerationTable.magic || header[1] != Int64(bucketCount) {
+            RGLogs(.error, "generation table at \(path) has an incompatible header")
+            munmap(pointer, length)
+            return nil
+        }
+        self.path = path
+        self.bucketCount = bucketCount
+        self.mapping = pointer!
+        self.mappingLength = length
+        self.counters = header + RGGenerationTable.headerWords
+    }
+    
+    deinit {
+        munmap(self.mapping, self.mappingLength)
+    }
+    
+/**
+ - parameter key: The key of any item.
+ - returns: The index of the counter covering `key`.
+ */
+    open func bucket(for key:RGMultiKey) -> Int {
+        return Int(key.stableHash % UInt64(self.bucketCount))
+    }
+    
+/**
+ - parameter key: The key of any item.
+ - returns: The current generation of the bucket covering `key`.
+ */
+    open func generation(for key:RGMultiKey) -> Int64 {
+        return OSAtomicAdd64Barrier(0, self.counters + self.bucket(for: key))
+    }
+    
+/**
+ - parameter bucket: The index of a counter.
+ - returns: The current generation of that bucket.
+ */
+    open func generation(atBucket bucket:Int) -> Int64 {
+        return OSAtomicAdd64Barrier(0, self.counters + bucket)
+    }
+    
+/**
+ Marks every item in the bucket covering `key` as changed in all processes sharing the table.
+ - parameter key: The key of the item which was written.
+ - returns: The new generation of the bucket.
+ */
+    @discardableResult
+    open func advance(_ key:RGMultiKey) -> Int64 {
+        return OSAtomicIncrement64Barrier(self.counters + self.bucket(for: key))
+    }
+}
@@ -0,0 +1,135 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+
+/**
+ `RGKeyIndex` is a set of strings kept sorted by their UTF-8 bytes so the strings sharing a prefix, or falling between
+   two bounds, are found with a binary search and returned in order.  Not threadsafe; callers provide their own locking.
+ */
+open class RGKeyIndex {
+    
+    private var keys:[String]
+    
+/**
+ - parameter keys: The strings to index in any order, duplicates are dropped.
+ */
+    public init<S : Sequence>(keys:S) where S.Iterator.Element == String {
+        var sorted = keys.sorted(by: RGKeyIndex.precedes)
+        var unique = 0
+        for index in 0 ..< sorted.count where unique == 0 || !RGKeyIndex.matches(sorted[index], sorted[unique - 1]) {
+            sorted[unique] = sorted[index]
+            unique += 1
+        }
+        sorted.removeSubrange(unique ..< sorted.count)
+        self.keys = sorted
+    }
+    
+/**
+ The number of strings in the index.
+ */
+    open var count:Int {
+        return self.keys.count
+    }
+    
+/**
+ The order of the index: bytewise on UTF-8 so every string with a given prefix sorts next to the others.
+ */
+    open static func precedes(_ lhs:String, _ rhs:String) -> Bool {
+        return lhs.utf8.lexicographicallyPrecedes(rhs.utf8)
+    }
+    
+    private static func matches(_ lhs:String, _ rhs:String) -> Bool {
+        return lhs.utf8.elementsEqual(rhs.utf8)
+    }
+    
+    open func contains(_ key:String) -> Bool {
+        let index = self.lowerBound(key)
+        return index < self.keys.count && RGKeyIndex.matches(self.keys[index], key)
+    }
+    
+/**
+ - returns: `true` if `key` was not already in the index.
+ */
+    @discardableResult
+    open func insert(_ key:String) -> Bool {
+        let index = self.lowerBound(key)
+        if index < self.keys.count && RGKeyIndex.matches(self.keys[index], key) {
+            return false
+        }
+        self.keys.insert(key, at: index)
+        return true
+    }
+    
+/**
+ - returns: `true` if `key` was in the index.
+ */
+    @discardableResult
+    open func remove(_ key:String) -> Bool {
+        let index = self.lowerBound(key)
+        if index == self.keys.count || !RGKeyIndex.matches(self.keys[index], key) {
+            return false
+        }
+        self.keys.remove(at: index)
+        return true
+    }
+    
+/**
+ - returns: Every string beginning with the bytes of `prefix`, in order.
+ */
+    open func keys(withPrefix prefix:String) -> [String] {
+        var results:[String] = []
+        var index = self.lowerBound(prefix)
+        while index < self.keys.count && self.keys[index].utf8.starts(with: prefix.utf8) {
+            results.append(self.keys[index])
+            index += 1
+        }
+        return results
+    }
+    
+/**
+ - returns: Every string from `lower` up to but not including `upper`, in order.
+ */
+    open func keys(from lower:String, to upper:String) -> [String] {
+        let start = self.lowerBound(lower)
+        let end = max(start, self.lowerBound(upper))
+        return Array(self.keys[start ..< end])
+    }
+    
+/**
+ - returns: The position of the first string not ordered before `key`.
+ */
+    private func lowerBound(_ key:String) -> Int {
+        var low = 0
+        var high = self.keys.count
+        while low < high {
+            let middle = (low + high) / 2
+            if RGKeyIndex.precedes(self.keys[middle], key) {
+                low = middle + 1
+            } else {
+                high = middle
+            }
+        }
+        return low
+    }
+}
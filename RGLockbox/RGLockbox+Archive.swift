@@ -0,0 +1,284 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import Security
+
+/**
+ Reasons an archive could not be written or read.
+ */
+public enum RGArchiveError: Error {
+    
+/**
+ The archive key is not 32 bytes.
+ */
+    case invalidKey
+    
+/**
+ The system could not provide a random nonce.
+ */
+    case randomUnavailable
+    
+/**
+ The system could not create the cipher.
+ */
+    case cipherUnavailable
+    
+/**
+ The archive file could not be created or read.
+ */
+    case inaccessible
+    
+/**
+ The file is not an archive or was written by a newer version.
+ */
+    case malformed
+    
+/**
+ The archive was modified or the key is wrong.
+ */
+    case authenticationFailed
+}
+
+/**
+ Export and import of a manager's items through an encrypted archive.
+ 
+ An archive is a 4 byte magic, a version, and a 12 byte nonce followed by the records encrypted with AES-256 in
+   counter mode and a 32 byte HMAC-SHA-256 of everything before it.  Each record is a 1 byte marker, the 32-bit length
+   prefixed key, the 32-bit length prefixed value, and the expiry; a 0 marker ends the records.  The encryption and
+   authentication keys are both derived from the caller's 32 byte key.
+ */
+extension RGLockbox {
+    
+    static let archiveMagic:UInt32 = 0x414c4752 // "RGLA"
+    static let archiveVersion:UInt8 = 1
+    static let archiveHeaderLength = 17
+    static let archiveTagLength = 32
+    
+/**
+ Records are encrypted and written once this many bytes are buffered, and archives are read this many bytes at a time.
+ */
+    static let archiveBufferLength = 64 * 1024
+    
+/**
+ Writes every unexpired item of this manager, with its expiry, to an archive at `url`.
+ - parameter url: A file URL; any existing file is replaced.
+ - parameter key: 32 bytes known only to the exporter and the importer.
+ - returns: The number of items written.
+ */
+    @discardableResult
+    public func export(to url:URL, key:Data) throws -> Int {
+        guard key.count == 32 else {
+            throw RGArchiveError.invalidKey
+        }
+        var nonce = [UInt8](repeating: 0, count: 12)
+        guard SecRandomCopyBytes(kSecRandomDefault, nonce.count, &nonce) == 0 else {
+            throw RGArchiveError.randomUnavailable
+        }
+        let keys = RGLockbox.archiveKeys([UInt8](key))
+        guard let cipher = RGCipher(key: keys.encryption, nonce: nonce) else {
+            throw RGArchiveError.cipherUnavailable
+        }
+        guard FileManager.default.createFile(atPath: url.path, contents: nil),
+              let handle = try? FileHandle(forWritingTo: url) else {
+            throw RGArchiveError.inaccessible
+        }
+        defer {
+            handle.closeFile()
+        }
+        var mac = RGHMAC(key: keys.authentication)
+        var header = RGByteWriter()
+        header.write(RGLockbox.archiveMagic)
+        header.write(RGLockbox.archiveVersion)
+        header.write(nonce)
+        mac.update(header.bytes)
+        handle.write(header.data)
+        var records = RGByteWriter()
+        let flush = {
+            var bytes = records.bytes
+            cipher.apply(&bytes)
+            mac.update(bytes)
+            handle.write(Data(bytes: bytes))
+            records = RGByteWriter()
+        }
+        var count = 0
+        for name in self.allItems() {
+            guard let data = self.dataForKey(name) else {
+                continue
+            }
+            RGLockbox.valueCacheLock.lock()
+            let expiry = RGLockbox.expirations[self.fullKey(for: name)]
+            RGLockbox.valueCacheLock.unlock()
+            records.write(UInt8(1))
+            records.write(name)
+            records.write(UInt32(data.count))
+            records.write(data)
+            records.write(expiry?.timeIntervalSince1970.bitPattern ?? 0)
+            count += 1
+            if records.bytes.count >= RGLockbox.archiveBufferLength {
+                flush()
+            }
+        }
+        records.write(UInt8(0))
+        flush()
+        handle.write(Data(bytes: mac.finalize()))
+        return count
+    }
+    
+/**
+ Writes every unexpired item in the archive at `url` to this manager and waits for them to reach the keychain.  The
+   archive is read twice a chunk at a time: first to authenticate it, then to decrypt it and write its records in
+   batches as they are parsed.  Nothing is written unless the whole archive authenticates; an archive modified between
+   the two reads throws `authenticationFailed` once its end is reached.
+ - parameter url: A file written by `export(to:key:)`.
+ - parameter key: The key the archive was exported with.
+ - returns: The number of items written.
+ */
+    @discardableResult
+    public func `import`(from url:URL, key:Data) throws -> Int {
+        guard key.count == 32 else {
+            throw RGArchiveError.invalidKey
+        }
+        guard let handle = try? FileHandle(forReadingFrom: url) else {
+            throw RGArchiveError.inaccessible
+        }
+        defer {
+            handle.closeFile()
+        }
+        let fileLength = Int(handle.seekToEndOfFile())
+        guard fileLength >= RGLockbox.archiveHeaderLength + RGLockbox.archiveTagLength else {
+            throw RGArchiveError.malformed
+        }
+        handle.seek(toFileOffset: 0)
+        let header = [UInt8](handle.readData(ofLength: RGLockbox.archiveHeaderLength))
+        var reader = RGByteReader(header)
+        guard reader.readUInt32() == RGLockbox.archiveMagic,
+              reader.readUInt8() == RGLockbox.archiveVersion,
+              let nonce = reader.readBytes(12) else {
+            throw RGArchiveError.malformed
+        }
+        let bodyEnd = fileLength - RGLockbox.archiveTagLength
+        let keys = RGLockbox.archiveKeys([UInt8](key))
+        let readBody = { (body:([UInt8]) -> Void) -> [UInt8] in
+            var mac = RGHMAC(key: keys.authentication)
+            mac.update(header)
+            var offset = RGLockbox.archiveHeaderLength
+            handle.seek(toFileOffset: UInt64(offset))
+            while offset < bodyEnd {
+                let chunk = [UInt8](handle.readData(ofLength: min(RGLockbox.archiveBufferLength, bodyEnd - offset)))
+                if chunk.count == 0 {
+                    break
+                }
+                mac.update(chunk)
+                body(chunk)
+                offset += chunk.count
+            }
+            return mac.finalize()
+        }
+        let expected = readBody({ _ in })
+        handle.seek(toFileOffset: UInt64(bodyEnd))
+        let stored = [UInt8](handle.readData(ofLength: RGLockbox.archiveTagLength))
+        guard RGHMAC.isEqual(expected, stored) else {
+            throw RGArchiveError.authenticationFailed
+        }
+        guard let cipher = RGCipher(key: keys.encryption, nonce: nonce) else {
+            throw RGArchiveError.cipherUnavailable
+        }
+        let now = Date()
+        var pending:[UInt8] = []
+        var needed = 0
+        var isFinished = false
+        var entries:[(String, Data?, Date?)] = []
+        var batchBytes = 0
+        var count = 0
+        let applied = readBody({ chunk in
+            var plaintext = chunk
+            cipher.apply(&plaintext)
+            if isFinished {
+                return
+            }
+            pending += plaintext
+            if pending.count < needed {
+                return
+            }
+            var reader = RGByteReader(pending)
+            var consumed = 0
+            while let marker = reader.readUInt8() {
+                if marker == 0 {
+                    isFinished = true
+                    break
+                }
+                guard let name = reader.readString(),
+                      let length = reader.readUInt32(),
+                      let data = reader.readData(Int(length)),
+                      let expiryBits = reader.readUInt64() else {
+                    var record = RGByteReader(pending)
+                    record.offset = consumed + 1
+                    if let nameLength = record.readUInt32(),
+                       record.readBytes(Int(nameLength)) != nil,
+                       let length = record.readUInt32() {
+                        needed = record.offset + Int(length) + 8 - consumed
+                    }
+                    break
+                }
+                consumed = reader.offset
+                needed = 0
+                let expiry = expiryBits != 0 ? Date(timeIntervalSince1970: TimeInterval(bitPattern: expiryBits)) : nil
+                if expiry == nil || expiry! > now {
+                    entries.append((name, data, expiry))
+                    batchBytes += data.count
+                }
+            }
+            pending.removeFirst(isFinished ? pending.count : consumed)
+            if batchBytes >= RGLockbox.archiveBufferLength {
+                self.storeBatch(entries, policy: .block)
+                count += entries.count
+                entries.removeAll()
+                batchBytes = 0
+            }
+        })
+        self.storeBatch(entries, policy: .block)
+        count += entries.count
+        if self.isPacked {
+            RGLockbox.flushPackedItems()
+        } else {
+            RGLockbox.keychainQueue.sync(execute: {})
+        }
+        guard RGHMAC.isEqual(applied, stored) else {
+            RGLogs(.error, "archive at \(url) changed while it was imported")
+            throw RGArchiveError.authenticationFailed
+        }
+        guard isFinished else {
+            throw RGArchiveError.malformed
+        }
+        return count
+    }
+    
+/**
+ - returns: Independent encryption and authentication keys derived from `key`.
+ */
+    static func archiveKeys(_ key:[UInt8]) -> (encryption:[UInt8], authentication:[UInt8]) {
+        return (RGHMAC.authenticate([UInt8]("RGLockbox.archive.encryption".utf8), key: key),
+                RGHMAC.authenticate([UInt8]("RGLockbox.archive.authentication".utf8), key: key))
+    }
+}
@@ -0,0 +1,382 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+
+/**
+ What a write does when the backlog of queued writes is full.
+ */
+public enum RGBacklogPolicy {
+    
+/**
+ Wait until the backlog has room.
+ */
+    case block
+    
+/**
+ Refuse the write.  The throwing variants of `setData` report it with `RGBacklogError.full`; the others drop it with a
+   warning.
+ */
+    case failFast
+    
+/**
+ Cache the value and park the write with the deferred writes, saved to `deferredWritesURL` when it is set, to be
+   written once the backlog drains.  Writes which need more than one item, and writes of an item which already has a
+   write queued, wait instead.
+ */
+    case spill
+}
+
+public enum RGBacklogError : Error {
+    
+/**
+ The write backlog was full and the write was refused.
+ */
+    case full
+}
+
+/**
+ The outcome of admitting writes to the backlog.
+ */
+enum RGBacklogAdmission {
+    case queue
+    case spill
+    case reject
+}
+
+/**
+ One queued write counted in the backlog.
+ */
+final class RGPendingWrite {
+    let fullKey:RGMultiKey
+    
+/**
+ The item write for a single item write, replaced in place when superseded; `nil` for chunked and enveloped writes.
+ */
+    var write:RGItemWrite?
+    
+    var bytes:Int
+    
+/**
+ Whether the work running this write has been handed to the scheduler.
+ */
+    var isScheduled = false
+    
+    var isStarted = false
+    
+    init(fullKey:RGMultiKey, write:RGItemWrite?, bytes:Int) {
+        self.fullKey = fullKey
+        self.write = write
+        self.bytes = bytes
+    }
+}
+
+/**
+ Writes waiting for `keychainQueue` are bounded by `writeBacklogLimit` writes and `writeBacklogByteLimit` bytes of
+   values.  A write of an item whose previous write has not started yet replaces that write in place instead of queueing
+   another, as long as nothing else touching the item was scheduled in between.  When the backlog is full the writer
+   follows its `RGBacklogPolicy`.  Packed managers batch their own writes and are not counted.
+ */
+extension RGLockbox {
+    
+/**
+ The number of queued writes at which new writes follow the backlog policy.
+ */
+    open static var writeBacklogLimit = 10_000
+    
+/**
+ The bytes of queued values at which new writes follow the backlog policy.  A single write larger than this is let
+   through once the backlog is empty.
+ */
+    open static var writeBacklogByteLimit = 32 * 1024 * 1024
+    
+/**
+ The policy of `setData(_:forKey:)` and the other writes which do not take one.
+ */
+    open static var writeBacklogPolicy = RGBacklogPolicy.block
+    
+/**
+ This lock controls access to the backlog state below.  It may be taken while holding `valueCacheLock` or
+   `schedulerLock` but never the reverse.
+ */
+    static let backlogCondition = NSCondition()
+    
+/**
+ The queued single item writes which a newer write of the same item may still replace.
+ */
+    static var supersedableWrites:[RGMultiKey : RGPendingWrite] = [:]
+    
+/**
+ The number of queued or running writes of each item.
+ */
+    static var unfinishedWrites:[RGMultiKey : Int] = [:]
+    
+    static var backlogCount = 0
+    static var backlogBytes = 0
+    static var backlogHighWaterCount = 0
+    static var backlogHighWaterBytes = 0
+    static var supersededWrites = 0
+    static var spilledWrites = 0
+    
+/**
+ Whether writes were parked since the backlog last drained.
+ */
+    static var hasSpilledWrites = false
+    
+/**
+ The number of writes and bytes of values waiting for `keychainQueue`.
+ */
+    public static var writeBacklog:(count:Int, bytes:Int) {
+        RGLockbox.backlogCondition.lock()
+        defer {
+            RGLockbox.backlogCondition.unlock()
+        }
+        return (RGLockbox.backlogCount, RGLockbox.backlogBytes)
+    }
+    
+/**
+ The largest `writeBacklog` seen since launch or `resetWriteBacklogHighWater()`, each measured on its own.
+ */
+    public static var writeBacklogHighWater:(count:Int, bytes:Int) {
+        RGLockbox.backlogCondition.lock()
+        defer {
+            RGLockbox.backlogCondition.unlock()
+        }
+        return (RGLockbox.backlogHighWaterCount, RGLockbox.backlogHighWaterBytes)
+    }
+    
+    public static func resetWriteBacklogHighWater() {
+        RGLockbox.backlogCondition.lock()
+        RGLockbox.backlogHighWaterCount = RGLockbox.backlogCount
+        RGLockbox.backlogHighWaterBytes = RGLockbox.backlogBytes
+        RGLockbox.backlogCondition.unlock()
+    }
+    
+/**
+ The number of queued writes replaced by a newer write of the same item before they started.
+ */
+    public static var supersededWriteCount:Int {
+        RGLockbox.backlogCondition.lock()
+        defer {
+            RGLockbox.backlogCondition.unlock()
+        }
+        return RGLockbox.supersededWrites
+    }
+    
+/**
+ The number of writes parked under `RGBacklogPolicy.spill`.
+ */
+    public static var spilledWriteCount:Int {
+        RGLockbox.backlogCondition.lock()
+        defer {
+            RGLockbox.backlogCondition.unlock()
+        }
+        return RGLockbox.spilledWrites
+    }
+    
+/**
+ Writes `data` as `setData(_:forKey:)`, following `policy` if the write backlog is full.
+ - throws: `RGBacklogError.full` if the write was refused under `.failFast`.
+ */
+    public func setData(_ data:Data?, forKey key:String, policy:RGBacklogPolicy) throws {
+        let fullKey = self.fullKey(for: key)
+        let keyLock = RGLockbox.keyLock(for: fullKey)
+        keyLock.lock()
+        let isStored = self.store(data, forKey: key, fullKey: fullKey, expiry: nil, policy: policy)
+        keyLock.unlock()
+        if !isStored {
+            throw RGBacklogError.full
+        }
+    }
+    
+/**
+ Writes `items` as `setItems(_:)`, following `policy` if the write backlog is full.
+ - throws: `RGBacklogError.full` if the writes were refused under `.failFast`; none of them were made.
+ */
+    public func setItems(_ items:[String : Data], policy:RGBacklogPolicy) throws {
+        if !self.storeBatch(items.map({ ($0.key, $0.value, nil) }), policy: policy) {
+            throw RGBacklogError.full
+        }
+    }
+    
+/**
+ Waits for room for writes of `fullKeys` carrying `bytes` of values, or decides otherwise by `policy`.  Writes which
+   will replace a queued write in place need no room.  Must not hold `valueCacheLock`.
+ */
+    static func admitWrites(_ fullKeys:[RGMultiKey], bytes:Int, policy:RGBacklogPolicy) -> RGBacklogAdmission {
+        RGLockbox.backlogCondition.lock()
+        defer {
+            RGLockbox.backlogCondition.unlock()
+        }
+        let added = fullKeys.filter({ RGLockbox.supersedableWrites[$0] == nil }).count
+        while added > 0 && RGLockbox.backlogCount > 0
+            && (RGLockbox.backlogCount + added > RGLockbox.writeBacklogLimit
+                || RGLockbox.backlogBytes + bytes > RGLockbox.writeBacklogByteLimit) {
+            switch policy {
+            case .block:
+                RGLockbox.backlogCondition.wait()
+            case .failFast:
+                return .reject
+            case .spill:
+                return .spill
+            }
+        }
+        return .queue
+    }
+    
+/**
+ Counts a staged write in the backlog.  Must hold `valueCacheLock`.
+ - parameter write: The item write of a single item write, which later writes of the item may replace.
+ */
+    static func trackPendingWrite(_ fullKey:RGMultiKey, write:RGItemWrite?, bytes:Int) -> RGPendingWrite {
+        let pending = RGPendingWrite(fullKey: fullKey, write: write, bytes: bytes)
+        RGLockbox.backlogCondition.lock()
+        RGLockbox.backlogCount += 1
+        RGLockbox.backlogBytes += bytes
+        RGLockbox.updateBacklogHighWater()
+        RGLockbox.unfinishedWrites[fullKey] = (RGLockbox.unfinishedWrites[fullKey] ?? 0) + 1
+        RGLockbox.supersedableWrites[fullKey] = write != nil ? pending : nil
+        RGLockbox.backlogCondition.unlock()
+        return pending
+    }
+    
+/**
+ Replaces the queued write of the same item with `write` if it has not started.  Must hold `valueCacheLock`.
+ - returns: `true` if it did, in which case `write` needs no work of its own.
+ */
+    static func supersedePendingWrite(_ write:RGItemWrite) -> Bool {
+        RGLockbox.backlogCondition.lock()
+        defer {
+            RGLockbox.backlogCondition.unlock()
+        }
+        guard let pending = RGLockbox.supersedableWrites[write.fullKey], !pending.isStarted else {
+            return false
+        }
+        let bytes = write.data?.count ?? 0
+        RGLockbox.backlogBytes += bytes - pending.bytes
+        RGLockbox.updateBacklogHighWater()
+        pending.bytes = bytes
+        pending.write = write
+        RGLockbox.supersededWrites += 1
+        RGLockbox.backlogCondition.broadcast()
+        RGLogs(.trace, "superseding queued write of \(write.fullKey.first)")
+        return true
+    }
+    
+/**
+ Parks `write` unless the item has a write queued or running, which must go first.  Must hold `valueCacheLock`.
+ - returns: `true` if the write was parked.
+ */
+    static func spillWrite(_ write:RGItemWrite) -> Bool {
+        RGLockbox.backlogCondition.lock()
+        if RGLockbox.unfinishedWrites[write.fullKey] != nil {
+            RGLockbox.backlogCondition.unlock()
+            return false
+        }
+        RGLockbox.spilledWrites += 1
+        RGLockbox.hasSpilledWrites = true
+        RGLockbox.backlogCondition.unlock()
+        RGLockbox.deferredWritesLock.lock()
+        RGLockbox.deferredWrites[write.fullKey] = write
+        RGLockbox.deferredAttempts[write.fullKey] = 0
+        RGLockbox.deferredWritesLock.unlock()
+        RGLogs(.debug, "write backlog is full, parking write of \(write.fullKey.first)")
+        DispatchQueue.global(qos: .utility).async(execute: {
+            RGLockbox.saveDeferredWrites()
+        })
+        RGLockbox.retrySpilledWritesIfDrained()
+        return true
+    }
+    
+/**
+ Closes the queued writes of `keys`, or of every item if `nil`, to replacement once work touching them is scheduled
+   after them.  Called by `enqueue(qos:keys:execute:)`.
+ */
+    static func schedulePendingWrites(_ keys:[RGMultiKey]?) {
+        RGLockbox.backlogCondition.lock()
+        for fullKey in keys ?? Array(RGLockbox.supersedableWrites.keys) {
+            guard let pending = RGLockbox.supersedableWrites[fullKey] else {
+                continue
+            }
+            if pending.isScheduled {
+                RGLockbox.supersedableWrites[fullKey] = nil
+            } else {
+                pending.isScheduled = true
+            }
+        }
+        RGLockbox.backlogCondition.unlock()
+    }
+    
+/**
+ Takes `pending` out of the backlog as its work starts.  Called on `keychainQueue`.
+ - returns: The item write to perform, the newest if it was superseded.
+ */
+    static func startPendingWrite(_ pending:RGPendingWrite) -> RGItemWrite? {
+        RGLockbox.backlogCondition.lock()
+        pending.isStarted = true
+        if RGLockbox.supersedableWrites[pending.fullKey] === pending {
+            RGLockbox.supersedableWrites[pending.fullKey] = nil
+        }
+        RGLockbox.backlogCount -= 1
+        RGLockbox.backlogBytes -= pending.bytes
+        RGLockbox.backlogCondition.broadcast()
+        RGLockbox.backlogCondition.unlock()
+        RGLockbox.retrySpilledWritesIfDrained()
+        return pending.write
+    }
+    
+/**
+ Called on `keychainQueue` once the work of `pending` is done.
+ */
+    static func finishPendingWrite(_ pending:RGPendingWrite) {
+        RGLockbox.backlogCondition.lock()
+        let remaining = RGLockbox.unfinishedWrites[pending.fullKey]! - 1
+        RGLockbox.unfinishedWrites[pending.fullKey] = remaining > 0 ? remaining : nil
+        RGLockbox.backlogCondition.unlock()
+    }
+    
+/**
+ Retries the parked writes once the backlog is down to half of its limits, if any were parked for lack of room.
+ */
+    static func retrySpilledWritesIfDrained() {
+        RGLockbox.backlogCondition.lock()
+        let isDrained = RGLockbox.hasSpilledWrites
+            && RGLockbox.backlogCount <= RGLockbox.writeBacklogLimit / 2
+            && RGLockbox.backlogBytes <= RGLockbox.writeBacklogByteLimit / 2
+        if isDrained {
+            RGLockbox.hasSpilledWrites = false
+        }
+        RGLockbox.backlogCondition.unlock()
+        if isDrained {
+            RGLockbox.retryDeferredWrites()
+        }
+    }
+    
+/**
+ Must hold `backlogCondition`.
+ */
+    static func updateBacklogHighWater() {
+        RGLockbox.backlogHighWaterCount = max(RGLockbox.backlogHighWaterCount, RGLockbox.backlogCount)
+        RGLockbox.backlogHighWaterBytes = max(RGLockbox.backlogHighWaterBytes, RGLockbox.backlogBytes)
+    }
+}
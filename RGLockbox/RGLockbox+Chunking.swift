@@ -0,0 +1,402 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import Security
+
+/**
+ A value stored outside its own keychain item.  The item and `valueCache` hold only the serialized reference.
+ */
+protocol RGValueReference : class {
+    
+/**
+ The serialized reference, as held by the value's keychain item.
+ */
+    var data:Data { get }
+    
+    var length:Int { get }
+    
+/**
+ The `RGContentDigest` hashes of the whole value.
+ */
+    var primary:UInt64 { get }
+    var secondary:UInt64 { get }
+}
+
+/**
+ Describes a value stored across several chunk items.  The manifest is what the value's own keychain item holds and what
+   `valueCache` holds for it, so the value itself is never resident as a whole.  The item is marked with
+   `RGLockbox.referenceItemType`, so a stored value which happens to look like a manifest is never taken for one.
+ 
+ Chunk items are named after a random token chosen per write, so the chunks of one write are never modified once written
+   and may be cached by name alone.
+ */
+final class RGChunkManifest : RGValueReference {
+    
+    static let magic:UInt64 = 0x4b4e4843424c4752 // "RGLBCHNK"
+    static let version:UInt8 = 1
+    static let encodedLength = 45
+    
+    let token:UInt64
+    let length:Int
+    let chunkSize:Int
+    
+/**
+ The `RGContentDigest` hashes of the whole value.
+ */
+    let primary:UInt64
+    let secondary:UInt64
+    
+    init(token:UInt64, length:Int, chunkSize:Int, primary:UInt64, secondary:UInt64) {
+        self.token = token
+        self.length = length
+        self.chunkSize = chunkSize
+        self.primary = primary
+        self.secondary = secondary
+    }
+    
+/**
+ - parameter data: The contents of a keychain item.
+ - returns: The manifest held by `data`, `nil` if `data` is not a manifest.
+ */
+    convenience init?(_ data:Data?) {
+        guard let data = data, data.count == RGChunkManifest.encodedLength else {
+            return nil
+        }
+        var reader = RGByteReader(data)
+        guard reader.readUInt64() == RGChunkManifest.magic,
+              reader.readUInt8() == RGChunkManifest.version,
+              let token = reader.readUInt64(),
+              let length = reader.readUInt64(),
+              let chunkSize = reader.readUInt32(),
+              let primary = reader.readUInt64(),
+              let secondary = reader.readUInt64(),
+              chunkSize > 0 else {
+            return nil
+        }
+        self.init(token: token, length: Int(length), chunkSize: Int(chunkSize), primary: primary, secondary: secondary)
+    }
+    
+/**
+ The serialized manifest.
+ */
+    var data:Data {
+        var writer = RGByteWriter()
+        writer.write(RGChunkManifest.magic)
+        writer.write(RGChunkManifest.version)
+        writer.write(self.token)
+        writer.write(UInt64(self.length))
+        writer.write(UInt32(self.chunkSize))
+        writer.write(self.primary)
+        writer.write(self.secondary)
+        return writer.data
+    }
+    
+    var chunkCount:Int {
+        return (self.length + self.chunkSize - 1) / self.chunkSize
+    }
+    
+/**
+ - returns: The key of chunk `index` of the value stored at `fullKey`.
+ */
+    func chunkKey(_ index:Int, of fullKey:RGMultiKey) -> RGMultiKey {
+        let service = "\(RGLockbox.chunkItemPrefix)\(self.token).\(index).\(fullKey.first ?? "")"
+        return RGMultiKey(withFirst: service, second: fullKey.second, third: fullKey.third)
+    }
+}
+
+/**
+ Values longer than `chunkSize` are split across chunk items and read back only as far as a ranged read needs.  Chunks
+   are cached separately from `valueCache` in a least recently used cache of at most `chunkCacheBudget` bytes.
+ */
+extension RGLockbox {
+    
+/**
+ The service prefix of chunk items.  Chunk items are not reported by `allItems()`.
+ */
+    static let chunkItemPrefix = "RGLockbox.chunk."
+    
+/**
+ The `kSecAttrType` of items holding a chunk manifest or envelope, "RGrf".  Items holding a value directly are written
+   without it.
+ */
+    static let referenceItemType:UInt32 = 0x52477266
+    
+/**
+ Values longer than this many bytes are written in chunks of this size.
+ */
+    open static var chunkSize = 32 * 1024
+    
+/**
+ The most bytes of chunks kept in memory.
+ */
+    open static var chunkCacheBudget = 4 * 1024 * 1024
+    
+/**
+ Cached chunks, their last use, and their total size.  Guarded by `valueCacheLock`.
+ */
+    static var chunkCache:[RGMultiKey : Data] = [:]
+    static var chunkCacheUses:[RGMultiKey : UInt64] = [:]
+    static var chunkCacheClock:UInt64 = 0
+    static var chunkCacheBytes = 0
+    
+/**
+ The number of bytes of chunks currently held in memory.
+ */
+    public static var chunkCacheSize:Int {
+        RGLockbox.valueCacheLock.lock()
+        let size = RGLockbox.chunkCacheBytes
+        RGLockbox.valueCacheLock.unlock()
+        return size
+    }
+    
+/**
+ - parameter isReference: Whether the item is marked with `referenceItemType`.
+ - returns: The entry `valueCache` holds for an item containing `data`.
+ */
+    static func cacheEntry(for data:Data?, isReference:Bool) -> Any {
+        if isReference, let reference = RGLockbox.valueReference(data) {
+            return reference
+        }
+        return data != nil ? data! : NSNull()
+    }
+    
+/**
+ - returns: Whether `item`, as returned by the keychain with its attributes, is marked with `referenceItemType`.
+ */
+    static func isReferenceItem(_ item:Dictionary<String, Any>?) -> Bool {
+        return (item?[kSecAttrType as String] as? NSNumber)?.uint32Value == RGLockbox.referenceItemType
+    }
+    
+/**
+ - returns: The chunk manifest or envelope held by `item`, `nil` if it holds the value itself.
+ */
+    static func valueReference(fromAttributes item:Dictionary<String, Any>?) -> RGValueReference? {
+        guard RGLockbox.isReferenceItem(item) else {
+            return nil
+        }
+        return RGLockbox.valueReference(item?[kSecValueData as String] as? Data)
+    }
+    
+/**
+ - returns: The chunk manifest or envelope serialized in `data`, `nil` if it is neither.  Only items marked with
+   `referenceItemType` hold one.
+ */
+    static func valueReference(_ data:Data?) -> RGValueReference? {
+        if let manifest = RGChunkManifest(data) {
+            return manifest
+        }
+        return RGEnvelope(data)
+    }
+    
+/**
+ Reads `range` of a value stored by `reference`.  Must hold `valueCacheLock`.
+ */
+    static func referencedValue(_ reference:RGValueReference, forKey fullKey:RGMultiKey, range:Range<Int>?) -> Data? {
+        if let manifest = reference as? RGChunkManifest {
+            return RGLockbox.chunkedValue(manifest, forKey: fullKey, range: range)
+        }
+        return RGLockbox.envelopeValue(reference as! RGEnvelope, forKey: fullKey, range: range)
+    }
+    
+/**
+ Deletes the chunk items or envelope file of `reference`.  Must be called on `keychainQueue`.
+ */
+    static func removeStorage(of reference:RGValueReference, forKey fullKey:RGMultiKey) {
+        if let manifest = reference as? RGChunkManifest {
+            RGLockbox.removeChunks(of: manifest, forKey: fullKey)
+        } else {
+            RGLockbox.removeEnvelope(reference as! RGEnvelope)
+        }
+    }
+    
+/**
+ - returns: The cached chunk for `chunkKey`, marking it used.  Must hold `valueCacheLock`.
+ */
+    static func cachedChunk(_ chunkKey:RGMultiKey) -> Data? {
+        guard let chunk = RGLockbox.chunkCache[chunkKey] else {
+            return nil
+        }
+        RGLockbox.chunkCacheClock += 1
+        RGLockbox.chunkCacheUses[chunkKey] = RGLockbox.chunkCacheClock
+        return chunk
+    }
+    
+/**
+ Caches `chunk` and evicts the least recently used chunks beyond `chunkCacheBudget`.  Must hold `valueCacheLock`.
+ */
+    static func cacheChunk(_ chunk:Data, forKey chunkKey:RGMultiKey) {
+        if chunk.count > RGLockbox.chunkCacheBudget {
+            return
+        }
+        RGLockbox.chunkCacheBytes -= RGLockbox.chunkCache[chunkKey]?.count ?? 0
+        RGLockbox.chunkCache[chunkKey] = chunk
+        RGLockbox.chunkCacheBytes += chunk.count
+        RGLockbox.chunkCacheClock += 1
+        RGLockbox.chunkCacheUses[chunkKey] = RGLockbox.chunkCacheClock
+        while RGLockbox.chunkCacheBytes > RGLockbox.chunkCacheBudget {
+            let oldest = RGLockbox.chunkCacheUses.min(by: { $0.value < $1.value })!.key
+            RGLockbox.chunkCacheBytes -= RGLockbox.chunkCache.removeValue(forKey: oldest)!.count
+            RGLockbox.chunkCacheUses[oldest] = nil
+        }
+    }
+    
+/**
+ Caches the manifest of `data` for `fullKey`.  Must hold `valueCacheLock`.
+ - returns: The keychain work writing the chunks and then the manifest, followed by the removal of the chunks of the
+   value being replaced.
+ */
+    func stageChunks(_ data:Data, forKey fullKey:RGMultiKey, digest:RGContentDigest, expiry:Date?,
+                     replacing previous:RGValueReference?) -> () -> Void {
+        let token = (UInt64(arc4random()) << 32) | UInt64(arc4random())
+        let manifest = RGChunkManifest(token: token,
+                                       length: data.count,
+                                       chunkSize: RGLockbox.chunkSize,
+                                       primary: digest.primary,
+                                       secondary: digest.secondary)
+        RGLockbox.cachedValues[fullKey] = manifest
+        RGLockbox.valueDigests[fullKey] = digest
+        RGLockbox.trackExpiry(expiry, forKey: fullKey)
+        var writes:[RGItemWrite] = []
+        for index in 0 ..< manifest.chunkCount {
+            let start = index * manifest.chunkSize
+            let chunk = data.subdata(in: start ..< min(start + manifest.chunkSize, data.count))
+            let chunkKey = manifest.chunkKey(index, of: fullKey)
+            RGLockbox.cacheChunk(chunk, forKey: chunkKey)
+            writes.append(RGItemWrite(fullKey: chunkKey,
+                                      data: chunk,
+                                      accessibility: self.itemAccessibility,
+                                      isSynchronized: self.isSynchronized,
+                                      expiry: nil,
+                                      updatesInPlace: false,
+                                      isReference: false))
+        }
+        writes.append(RGItemWrite(fullKey: fullKey,
+                                  data: manifest.data,
+                                  accessibility: self.itemAccessibility,
+                                  isSynchronized: self.isSynchronized,
+                                  expiry: expiry,
+                                  updatesInPlace: false,
+                                  isReference: true))
+        return {
+            let replaced = previous ?? RGLockbox.readReference(fullKey)
+            for write in writes {
+                RGLockbox.perform(write)
+            }
+            if let replaced = replaced, RGLockbox.deferredWrite(for: fullKey) == nil {
+                RGLockbox.removeStorage(of: replaced, forKey: fullKey)
+            }
+        }
+    }
+    
+/**
+ Reads `range` of a chunked value, loading the chunks it covers which are not cached in one block on `keychainQueue`.
+ - returns: The bytes, or `nil` if a chunk is missing because the value was replaced by another process.  Must hold
+   `valueCacheLock`.
+ */
+    static func chunkedValue(_ manifest:RGChunkManifest, forKey fullKey:RGMultiKey, range:Range<Int>?) -> Data? {
+        let lower = min(range?.lowerBound ?? 0, manifest.length)
+        let upper = min(range?.upperBound ?? manifest.length, manifest.length)
+        if lower >= upper {
+            return Data()
+        }
+        let first = lower / manifest.chunkSize
+        let last = (upper - 1) / manifest.chunkSize
+        var chunks:[Int : Data] = [:]
+        var missing:[Int] = []
+        for index in first ... last {
+            if let chunk = RGLockbox.cachedChunk(manifest.chunkKey(index, of: fullKey)) {
+                chunks[index] = chunk
+            } else {
+                missing.append(index)
+            }
+        }
+        if missing.count > 0 {
+            RGLockbox.enqueueAndWait(keys: [ fullKey ], execute: {
+                for index in missing {
+                    chunks[index] = RGLockbox.readItem(manifest.chunkKey(index, of: fullKey))
+                }
+            })
+            for index in missing where chunks[index] != nil {
+                RGLockbox.cacheChunk(chunks[index]!, forKey: manifest.chunkKey(index, of: fullKey))
+            }
+        }
+        var output = Data(capacity: upper - lower)
+        for index in first ... last {
+            let start = index * manifest.chunkSize
+            guard let chunk = chunks[index], start + chunk.count >= min(upper, start + manifest.chunkSize) else {
+                RGLogs(.warning, "chunk \(index) of \(fullKey.first) is missing, the value was replaced")
+                RGLockbox.cachedValues[fullKey] = nil
+                RGLockbox.valueDigests[fullKey] = nil
+                return nil
+            }
+            output.append(chunk.subdata(in: (max(lower, start) - start) ..< (min(upper, start + chunk.count) - start)))
+        }
+        return output
+    }
+    
+/**
+ - returns: The contents of the item for `fullKey`, preferring a parked write of it.  Must be called on `keychainQueue`.
+ */
+    static func readItem(_ fullKey:RGMultiKey) -> Data? {
+        if let pending = RGLockbox.deferredWrite(for: fullKey) {
+            return pending.data
+        }
+        var query = RGLockbox.itemQuery(fullKey)
+        query[kSecMatchLimit] = kSecMatchLimitOne
+        query[kSecReturnData] = kCFBooleanTrue
+        var data:AnyObject? = nil
+        let status = RGLockbox.watchedCopyMatching(query as NSDictionary, &data)
+        RGLogs(.trace, "SecItemCopyMatching with \(query) returned \(status)")
+        return RGLockbox.decodeValue(data as? Data)
+    }
+    
+/**
+ - returns: The chunk manifest or envelope held by the item for `fullKey`, preferring a parked write of it.  Must be
+   called on `keychainQueue`.
+ */
+    static func readReference(_ fullKey:RGMultiKey) -> RGValueReference? {
+        if let pending = RGLockbox.deferredWrite(for: fullKey) {
+            return pending.isReference ? RGLockbox.valueReference(pending.data) : nil
+        }
+        var query = RGLockbox.itemQuery(fullKey)
+        query[kSecMatchLimit] = kSecMatchLimitOne
+        query[kSecReturnData] = kCFBooleanTrue
+        query[kSecReturnAttributes] = kCFBooleanTrue
+        var data:AnyObject? = nil
+        let status = RGLockbox.watchedCopyMatching(query as NSDictionary, &data)
+        RGLogs(.trace, "SecItemCopyMatching of reference with \(query) returned \(status)")
+        return RGLockbox.valueReference(fromAttributes: RGLockbox.decodedItem(data as? Dictionary<String, Any>))
+    }
+    
+/**
+ Deletes the chunk items of `manifest`.  Must be called on `keychainQueue`.
+ */
+    static func removeChunks(of manifest:RGChunkManifest, forKey fullKey:RGMultiKey) {
+        for index in 0 ..< manifest.chunkCount {
+            let query = RGLockbox.itemQuery(manifest.chunkKey(index, of: fullKey))
+            let status = RGLockbox.watchedDelete(query as NSDictionary)
+            RGLogs(.trace, "SecItemDelete of chunk with \(query) returned \(status)")
+        }
+    }
+}
@@ -0,0 +1,209 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import Security
+import Compression
+
+/**
+ The algorithms values may be compressed with before they are written to the keychain.
+ */
+public enum RGValueCompression {
+    case none
+    case zlib
+    case lz4
+}
+
+/**
+ Values longer than `compressionThreshold` are compressed on their way into the keychain and decompressed on their way
+   out, so `valueCache` only ever holds the original bytes.
+ 
+ An encoded item starts with the four bytes of `compressionMagic`, a format version, a byte naming the encoding, and
+   the 32-bit length of the original value.  Headers are only written and stripped while `valueCompression` is on or
+   `readsCompressedValues` is set, so with compression off values are stored and read exactly as given.  An item which
+   happens to start with the magic is only decoded if its version, length, and payload check out, and anything else is
+   returned as is.  New values which would be mistaken for an encoded item are written with the `stored` encoding.
+ */
+extension RGLockbox {
+    
+    static let compressionMagic = Data(bytes: [ 0x89, 0x52, 0x47, 0x5a ])
+    static let compressionVersion:UInt8 = 1
+    static let compressionHeaderLength = 10
+    
+    static let storedEncoding:UInt8 = 0
+    static let zlibEncoding:UInt8 = 1
+    static let lz4Encoding:UInt8 = 2
+    
+/**
+ No value decodes to more than this many times the length of its payload, which is above the best ratio zlib can reach.
+ */
+    static let maximumExpansion = 1032
+    
+/**
+ No value decodes to more than this many bytes, so a damaged length can't make a read allocate gigabytes.
+ */
+    static let maximumDecodedLength = 16 * 1024 * 1024
+    
+/**
+ The algorithm new values are compressed with.  Defaults to `none` because compressed items can't be read by earlier
+   versions of this library.  Compression needs iOS 9, macOS 10.11, watchOS 2, or tvOS 9 and is skipped on earlier
+   systems.
+ */
+    open static var valueCompression = RGValueCompression.none
+    
+/**
+ Whether items written compressed are decoded while `valueCompression` is `none`.  Set this after turning compression
+   back off, or in a process which only reads items another process writes compressed.
+ */
+    open static var readsCompressedValues = false
+    
+/**
+ Values of at most this many bytes are written uncompressed.
+ */
+    open static var compressionThreshold = 256
+    
+/**
+ Whether values are encoded with a header on their way in and decoded on their way out.
+ */
+    static var isValueEncodingEnabled:Bool {
+        return RGLockbox.valueCompression != .none || RGLockbox.readsCompressedValues
+    }
+    
+/**
+ - returns: `payload` behind a header naming `encoding` and the original length `length`.
+ */
+    static func encodedValue(_ payload:Data, encoding:UInt8, length:Int) -> Data {
+        var writer = RGByteWriter()
+        writer.write(RGLockbox.compressionMagic)
+        writer.write(RGLockbox.compressionVersion)
+        writer.write(encoding)
+        writer.write(UInt32(length))
+        writer.write(payload)
+        return writer.data
+    }
+    
+/**
+ - returns: The bytes to store in the keychain for `data`.
+ */
+    static func encodeValue(_ data:Data) -> Data {
+        guard RGLockbox.isValueEncodingEnabled else {
+            return data
+        }
+        if data.count > RGLockbox.compressionThreshold, #available(iOS 9.0, OSX 10.11, watchOS 2.0, tvOS 9.0, *) {
+            var encoding:UInt8 = 0
+            var algorithm:compression_algorithm? = nil
+            switch RGLockbox.valueCompression {
+            case .zlib:
+                encoding = RGLockbox.zlibEncoding
+                algorithm = COMPRESSION_ZLIB
+            case .lz4:
+                encoding = RGLockbox.lz4Encoding
+                algorithm = COMPRESSION_LZ4
+            case .none:
+                break
+            }
+            if let algorithm = algorithm, let compressed = RGLockbox.compress(data, algorithm: algorithm) {
+                return RGLockbox.encodedValue(compressed, encoding: encoding, length: data.count)
+            }
+        }
+        let magic = RGLockbox.compressionMagic
+        guard data.count >= magic.count && data.subdata(in: 0 ..< magic.count) == magic else {
+            return data
+        }
+        return RGLockbox.encodedValue(data, encoding: RGLockbox.storedEncoding, length: data.count)
+    }
+    
+/**
+ - returns: The original value of the stored bytes `data`.
+ */
+    static func decodeValue(_ data:Data?) -> Data? {
+        let magic = RGLockbox.compressionMagic
+        guard RGLockbox.isValueEncodingEnabled,
+              let data = data,
+              data.count >= RGLockbox.compressionHeaderLength,
+              data.subdata(in: 0 ..< magic.count) == magic else {
+            return data
+        }
+        var reader = RGByteReader(data.subdata(in: magic.count ..< RGLockbox.compressionHeaderLength))
+        let version = reader.readUInt8()!
+        let encoding = reader.readUInt8()!
+        let length = Int(reader.readUInt32()!)
+        let payload = data.subdata(in: RGLockbox.compressionHeaderLength ..< data.count)
+        guard version == RGLockbox.compressionVersion && encoding <= RGLockbox.lz4Encoding else {
+            return data
+        }
+        if encoding == RGLockbox.storedEncoding {
+            return payload.count == length ? payload : data
+        }
+        guard length <= payload.count * RGLockbox.maximumExpansion && length <= RGLockbox.maximumDecodedLength else {
+            RGLogs(.warning, "value claims to decode to \(length) bytes from \(payload.count), returning it as stored")
+            return data
+        }
+        if #available(iOS 9.0, OSX 10.11, watchOS 2.0, tvOS 9.0, *) {
+            let algorithm = encoding == RGLockbox.zlibEncoding ? COMPRESSION_ZLIB : COMPRESSION_LZ4
+            if let decoded = RGLockbox.decompress(payload, length: length, algorithm: algorithm) {
+                return decoded
+            }
+        }
+        RGLogs(.warning, "value with encoding \(encoding) could not be decoded, returning it as stored")
+        return data
+    }
+    
+/**
+ - returns: `item` as returned by the keychain with its `kSecValueData` decoded.
+ */
+    static func decodedItem(_ item:Dictionary<String, Any>?) -> Dictionary<String, Any>? {
+        guard var item = item, let data = item[kSecValueData as String] as? Data else {
+            return item
+        }
+        item[kSecValueData as String] = RGLockbox.decodeValue(data)
+        return item
+    }
+    
+/**
+ - returns: `data` compressed with `algorithm`, `nil` if it does not get smaller.
+ */
+    @available(iOS 9.0, OSX 10.11, watchOS 2.0, tvOS 9.0, *)
+    static func compress(_ data:Data, algorithm:compression_algorithm) -> Data? {
+        var output = [UInt8](repeating: 0, count: data.count)
+        let count = data.withUnsafeBytes({ (bytes:UnsafePointer<UInt8>) -> Int in
+            return compression_encode_buffer(&output, output.count, bytes, data.count, nil, algorithm)
+        })
+        guard count > 0 && count + RGLockbox.compressionHeaderLength < data.count else {
+            return nil
+        }
+        return Data(bytes: output, count: count)
+    }
+    
+/**
+ - returns: `data` decompressed with `algorithm`, `nil` unless it decompresses to exactly `length` bytes.
+ */
+    @available(iOS 9.0, OSX 10.11, watchOS 2.0, tvOS 9.0, *)
+    static func decompress(_ data:Data, length:Int, algorithm:compression_algorithm) -> Data? {
+        var output = [UInt8](repeating: 0, count: length + 1)
+        let count = data.withUnsafeBytes({ (bytes:UnsafePointer<UInt8>) -> Int in
+            return compression_decode_buffer(&output, output.count, bytes, data.count, nil, algorithm)
+        })
+        return count == length ? Data(bytes: output, count: count) : nil
+    }
+}
@@ -0,0 +1,203 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+
+/**
+ The outcome of a read bounded by a deadline.
+ */
+public enum RGReadResult<Value> {
+    
+/**
+ The current value, `nil` if the item does not exist.
+ */
+    case value(Value?)
+    
+/**
+ The deadline passed; this is the cached value, which another process may have replaced since.
+ */
+    case stale(Value?)
+    
+/**
+ The deadline passed with nothing cached.
+ */
+    case timedOut
+    
+/**
+ The current or stale value, `nil` if absent or timed out.
+ */
+    public var value:Value? {
+        switch self {
+        case .value(let value), .stale(let value):
+            return value
+        case .timedOut:
+            return nil
+        }
+    }
+    
+    public var isTimedOut:Bool {
+        if case .timedOut = self {
+            return true
+        }
+        return false
+    }
+    
+/**
+ - returns: The same outcome with its value converted by `transform`, `nil` if it cannot be.
+ */
+    public func map<Result>(_ transform:(Value) -> Result?) -> RGReadResult<Result> {
+        switch self {
+        case .value(let value):
+            return .value(value.flatMap(transform))
+        case .stale(let value):
+            return .stale(value.flatMap(transform))
+        case .timedOut:
+            return .timedOut
+        }
+    }
+}
+
+/**
+ Reads which must return by a deadline, for example on the main thread.  A value cached and current is returned at
+   once.  Otherwise the keychain is read on a background queue and waited for until the deadline; if it passes the
+   cached value is returned as stale, or `.timedOut` if there is none, and the read carries on to fill `valueCache` for
+   the next caller.  Concurrent deadline reads of one key share a single background read.
+ */
+extension RGLockbox {
+    
+/**
+ The background read in progress for each key.  Guarded by `deadlineLock`.
+ */
+    static var deadlineReads:[RGMultiKey : RGFlight] = [:]
+    
+/**
+ The number of deadline reads which ran out of time so far.  Guarded by `deadlineLock`.
+ */
+    static var deadlineExpirations = 0
+    
+/**
+ This lock controls access to `deadlineReads` and `deadlineExpirations`.
+ */
+    static let deadlineLock = NSLock()
+    
+/**
+ The number of calls to `dataForKey(_:deadline:)` and its variants which returned before the keychain answered.
+ */
+    public static var deadlineExpirationCount:Int {
+        RGLockbox.deadlineLock.lock()
+        let count = RGLockbox.deadlineExpirations
+        RGLockbox.deadlineLock.unlock()
+        return count
+    }
+    
+/**
+ Reads the value of `key`, giving up on the keychain at `deadline`.
+ - parameter key: The identifier of the keychain item.
+ - parameter deadline: When to stop waiting; a past date returns only what is cached.
+ - returns: The value, the stale cached value, or `.timedOut`.
+ */
+    public func dataForKey(_ key:String, deadline:Date) -> RGReadResult<Data> {
+        let fullKey = self.fullKey(for: key)
+        if let cached = RGLockbox.threadCachedValue(for: fullKey) {
+            return .value(cached)
+        }
+        var stale:Data?? = nil
+        if RGLockbox.valueCacheLock.lock(before: deadline) {
+            let value = RGLockbox.cachedValues[fullKey]
+            if value != nil && !(value is RGValueReference) {
+                let liveValue = RGLockbox.liveValue(value!, forKey: fullKey)
+                if RGLockbox.isCacheCurrent(fullKey) {
+                    RGLockbox.recordAccess(fullKey)
+                    RGLockbox.valueCacheLock.unlock()
+                    return .value(liveValue)
+                }
+                stale = .some(liveValue)
+            }
+            RGLockbox.valueCacheLock.unlock()
+        }
+        let read = self.deadlineRead(forKey: key, fullKey: fullKey)
+        if read.group.wait(timeout: .now() + max(0, deadline.timeIntervalSinceNow)) == .success {
+            return .value(read.value)
+        }
+        RGLockbox.deadlineLock.lock()
+        RGLockbox.deadlineExpirations += 1
+        RGLockbox.deadlineLock.unlock()
+        RGLogs(.debug, "deadline passed reading \(key)")
+        if let stale = stale {
+            return .stale(stale)
+        }
+        return .timedOut
+    }
+    
+/**
+ - returns: A `String` decoded from UTF-8 as `stringForKey(_:)`, bounded by `deadline`.
+ */
+    public func stringForKey(_ key:String, deadline:Date) -> RGReadResult<String> {
+        return self.dataForKey(key, deadline: deadline).map({ String(data: $0, encoding: String.Encoding.utf8) })
+    }
+    
+/**
+ - returns: A `Date` parsed as `dateForKey(_:)`, bounded by `deadline`.
+ */
+    public func dateForKey(_ key:String, deadline:Date) -> RGReadResult<Date> {
+        return self.stringForKey(key, deadline: deadline).map({ rg_stored_date_formatter().date(from: $0) })
+    }
+    
+/**
+ - returns: An object created by `NSKeyedUnarchiver` as `codeableForKey(_:)`, bounded by `deadline`.
+ */
+    public func codeableForKey(_ key:String, deadline:Date) -> RGReadResult<NSCoding> {
+        return self.dataForKey(key, deadline: deadline).map({
+            NSKeyedUnarchiver.unarchiveObject(with: $0) as? NSCoding
+        })
+    }
+    
+/**
+ - returns: A JSON equivalent object as `JSONObjectForKey(_:)`, bounded by `deadline`.
+ */
+    public func JSONObjectForKey(_ key:String, deadline:Date) -> RGReadResult<Any> {
+        return self.dataForKey(key, deadline: deadline).map({ try? JSONSerialization.jsonObject(with: $0) })
+    }
+    
+/**
+ - returns: The background read of `key`, started if none is in progress.
+ */
+    func deadlineRead(forKey key:String, fullKey:RGMultiKey) -> RGFlight {
+        RGLockbox.deadlineLock.lock()
+        if let read = RGLockbox.deadlineReads[fullKey] {
+            RGLockbox.deadlineLock.unlock()
+            return read
+        }
+        let read = RGFlight()
+        RGLockbox.deadlineReads[fullKey] = read
+        RGLockbox.deadlineLock.unlock()
+        DispatchQueue.global(qos: .userInitiated).async(execute: {
+            read.value = self.readData(forKey: key, range: nil)
+            RGLockbox.deadlineLock.lock()
+            RGLockbox.deadlineReads[fullKey] = nil
+            RGLockbox.deadlineLock.unlock()
+            read.group.leave()
+        })
+        return read
+    }
+}
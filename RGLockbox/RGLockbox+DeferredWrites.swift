@@ -0,0 +1,333 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import Security
+
+extension RGItemWrite {
+    
+/**
+ The write as a property list for `RGLockbox.deferredWritesURL`.
+ */
+    var propertyList:[String:Any] {
+        var plist:[String:Any] = [
+            "accessibility" : self.accessibility as String,
+            "synchronized" : self.isSynchronized
+        ]
+        plist["service"] = self.fullKey.first
+        plist["account"] = self.fullKey.second
+        plist["group"] = self.fullKey.third
+        plist["data"] = self.data
+        plist["expiry"] = self.expiry
+        plist["updatesInPlace"] = self.updatesInPlace
+        plist["reference"] = self.isReference
+        return plist
+    }
+    
+/**
+ Restores a write saved by `propertyList`.
+ */
+    init?(propertyList plist:[String:Any]) {
+        guard let service = plist["service"] as? String,
+              let accessibility = plist["accessibility"] as? String,
+              let synchronized = plist["synchronized"] as? Bool else {
+            return nil
+        }
+        self.init(fullKey: RGMultiKey(withFirst: service,
+                                      second: plist["account"] as? String,
+                                      third: plist["group"] as? String),
+                  data: plist["data"] as? Data,
+                  accessibility: accessibility as CFString,
+                  isSynchronized: synchronized,
+                  expiry: plist["expiry"] as? Date,
+                  updatesInPlace: plist["updatesInPlace"] as? Bool ?? false,
+                  isReference: plist["reference"] as? Bool ?? false)
+    }
+}
+
+/**
+ Writes refused with `errSecInteractionNotAllowed` because the device is locked are parked instead of dropped.  At most
+   one write per item is kept, the newest.  They are retried in one batch when protected data becomes available or on a
+   backoff schedule, and reads keep serving the parked value meanwhile.
+ */
+extension RGLockbox {
+    
+/**
+ The parked write of each item.  Guarded by `deferredWritesLock`.
+ */
+    static var deferredWrites:[RGMultiKey : RGItemWrite] = [:]
+    
+/**
+ The number of retries each parked write has gone through.  Guarded by `deferredWritesLock`.
+ */
+    static var deferredAttempts:[RGMultiKey : Int] = [:]
+    
+/**
+ Whether a backoff retry is pending.  Guarded by `deferredWritesLock`.
+ */
+    static var isDeferredRetryScheduled = false
+    
+/**
+ Whether `deferredWritesURL` holds writes which could not be read yet because the device was locked; the file is not
+   replaced until they are.  Guarded by `deferredWritesLock`.
+ */
+    static var isDeferredWritesFileUnread = false
+    
+/**
+ This lock controls access to the parked writes.  It may be taken while holding `valueCacheLock` but never the reverse.
+ */
+    static let deferredWritesLock = NSLock()
+    
+/**
+ The delay before the first backoff retry; each further retry doubles it up to 64 times the interval.
+ */
+    open static var deferredWriteRetryInterval:TimeInterval = 5
+    
+/**
+ The number of retries after which a parked write is abandoned and `deferredWriteFailed` is called.
+ */
+    open static var deferredWriteMaxAttempts = 10
+    
+/**
+ Called on `keychainQueue` when a parked write is abandoned, with the item's key and the last status.
+ */
+    open static var deferredWriteFailed:((RGMultiKey, OSStatus) -> Void)?
+    
+/**
+ When set, parked writes are saved to this file and restored from it so they survive relaunching.  The file contains
+   the unwritten values, so it should only be placed where those values may be stored.  It is written with complete
+   protection unless open: writes are parked while the device is locked, when a completely protected file can't be
+   created, and once closed it can't be read again until the device is unlocked.
+ */
+    open static var deferredWritesURL:URL? {
+        didSet {
+            RGLockbox.restoreDeferredWrites()
+        }
+    }
+    
+/**
+ The number of writes currently parked.
+ */
+    public static var deferredWriteCount:Int {
+        RGLockbox.deferredWritesLock.lock()
+        let count = RGLockbox.deferredWrites.count
+        RGLockbox.deferredWritesLock.unlock()
+        return count
+    }
+    
+/**
+ Commits `write` and parks it if the keychain is unavailable.  A successful write supersedes any parked write for the
+   same item.  Must be called on `keychainQueue`.
+ */
+    static func perform(_ write:RGItemWrite) {
+        let status = RGLockbox.commit(write)
+        if status == errSecInteractionNotAllowed {
+            RGLogs(.warning, "keychain unavailable writing \(write.fullKey.first), deferring the write")
+            RGLockbox.deferredWritesLock.lock()
+            RGLockbox.deferredWrites[write.fullKey] = write
+            RGLockbox.deferredAttempts[write.fullKey] = 0
+            RGLockbox.scheduleDeferredRetry(0)
+            RGLockbox.deferredWritesLock.unlock()
+            RGLockbox.saveDeferredWrites()
+        } else if RGLockbox.resolveDeferredWrite(write.fullKey) {
+            RGLockbox.saveDeferredWrites()
+        }
+    }
+    
+/**
+ - returns: The parked write for `fullKey`, if any.
+ */
+    static func deferredWrite(for fullKey:RGMultiKey) -> RGItemWrite? {
+        RGLockbox.deferredWritesLock.lock()
+        let write = RGLockbox.deferredWrites[fullKey]
+        RGLockbox.deferredWritesLock.unlock()
+        return write
+    }
+    
+/**
+ Forgets the parked write for `fullKey`.
+ - returns: `true` if there was one.
+ */
+    @discardableResult
+    static func resolveDeferredWrite(_ fullKey:RGMultiKey) -> Bool {
+        RGLockbox.deferredWritesLock.lock()
+        let write = RGLockbox.deferredWrites.removeValue(forKey: fullKey)
+        RGLockbox.deferredAttempts[fullKey] = nil
+        RGLockbox.deferredWritesLock.unlock()
+        return write != nil
+    }
+    
+/**
+ Retries every parked write in one block on `keychainQueue`, first parking any in `deferredWritesURL` which could not
+   be read before.  Called automatically when `RGApplicationProtectedDataDidBecomeAvailable` is posted and on the
+   backoff schedule.
+ */
+    public static func retryDeferredWrites() {
+        RGLockbox.enqueue(execute: {
+            RGLockbox.loadDeferredWrites()
+            RGLockbox.deferredWritesLock.lock()
+            let writes = Array(RGLockbox.deferredWrites.values)
+            RGLockbox.deferredWritesLock.unlock()
+            if writes.count == 0 {
+                return
+            }
+            var failures:[(RGItemWrite, OSStatus)] = []
+            var longestWait = 0
+            for write in writes {
+                let status = RGLockbox.commit(write)
+                RGLockbox.deferredWritesLock.lock()
+                let attempts = (RGLockbox.deferredAttempts[write.fullKey] ?? 0) + 1
+                if status == errSecInteractionNotAllowed && attempts < RGLockbox.deferredWriteMaxAttempts {
+                    RGLockbox.deferredAttempts[write.fullKey] = attempts
+                    longestWait = Swift.max(longestWait, attempts)
+                } else {
+                    RGLockbox.deferredWrites[write.fullKey] = nil
+                    RGLockbox.deferredAttempts[write.fullKey] = nil
+                    if status != errSecSuccess {
+                        failures.append((write, status))
+                    }
+                }
+                RGLockbox.deferredWritesLock.unlock()
+            }
+            RGLockbox.deferredWritesLock.lock()
+            if RGLockbox.deferredWrites.count > 0 {
+                RGLockbox.scheduleDeferredRetry(longestWait)
+            }
+            RGLockbox.deferredWritesLock.unlock()
+            RGLockbox.saveDeferredWrites()
+            for (write, status) in failures {
+                RGLogs(.error, "abandoning deferred write of \(write.fullKey.first) with status \(status)")
+                RGLockbox.forgetAbandonedWrite(write)
+                RGLockbox.deferredWriteFailed?(write.fullKey, status)
+            }
+        })
+    }
+    
+/**
+ Arranges a backoff retry after `attempts` previous retries.  Must hold `deferredWritesLock`.
+ */
+    static func scheduleDeferredRetry(_ attempts:Int) {
+        if RGLockbox.isDeferredRetryScheduled {
+            return
+        }
+        RGLockbox.isDeferredRetryScheduled = true
+        let delay = RGLockbox.deferredWriteRetryInterval * Double(1 << Swift.min(attempts, 6))
+        DispatchQueue.global(qos: .utility).asyncAfter(deadline: DispatchTime.now() + delay, execute: {
+            RGLockbox.deferredWritesLock.lock()
+            RGLockbox.isDeferredRetryScheduled = false
+            RGLockbox.deferredWritesLock.unlock()
+            RGLockbox.retryDeferredWrites()
+        })
+    }
+    
+/**
+ Drops the cached value of an abandoned write so later reads go back to the keychain, unless it was overwritten since.
+ */
+    static func forgetAbandonedWrite(_ write:RGItemWrite) {
+        DispatchQueue.global(qos: .utility).async(execute: {
+            RGLockbox.valueCacheLock.lock()
+            let cached = RGLockbox.cachedValues[write.fullKey]
+            let cachedData = cached is RGValueReference ? (cached as! RGValueReference).data : cached as? Data
+            if cached != nil && cachedData == write.data {
+                RGLockbox.cachedValues[write.fullKey] = nil
+                RGLockbox.invalidateThreadCaches()
+                RGLockbox.valueDigests[write.fullKey] = nil
+                RGLockbox.forgetIndexedKey(write.fullKey)
+            }
+            RGLockbox.valueCacheLock.unlock()
+        })
+    }
+    
+/**
+ Writes the parked writes to `deferredWritesURL` if it is set.
+ */
+    static func saveDeferredWrites() {
+        guard let url = RGLockbox.deferredWritesURL, RGLockbox.loadDeferredWrites() else {
+            return
+        }
+        RGLockbox.deferredWritesLock.lock()
+        let plist = RGLockbox.deferredWrites.values.map({ $0.propertyList })
+        RGLockbox.deferredWritesLock.unlock()
+        #if os(iOS) || os(tvOS) || os(watchOS)
+            let options:Data.WritingOptions = [ .atomic, .completeFileProtectionUnlessOpen ]
+        #else
+            let options:Data.WritingOptions = .atomic
+        #endif
+        do {
+            let data = try PropertyListSerialization.data(fromPropertyList: plist, format: .binary, options: 0)
+            try data.write(to: url, options: options)
+        } catch {
+            RGLogs(.error, "unable to save deferred writes to \(url) error \(error)")
+        }
+    }
+    
+/**
+ Parks the writes saved in `deferredWritesURL` which are not superseded by a newer parked write, then retries them.
+ */
+    static func restoreDeferredWrites() {
+        guard RGLockbox.deferredWritesURL != nil else {
+            return
+        }
+        RGLockbox.deferredWritesLock.lock()
+        RGLockbox.isDeferredWritesFileUnread = true
+        RGLockbox.deferredWritesLock.unlock()
+        RGLockbox.loadDeferredWrites()
+        RGLockbox.retryDeferredWrites()
+    }
+    
+/**
+ Parks the writes of `deferredWritesURL` if they have not been read yet.
+ - returns: `false` if the file exists but is still unreadable.
+ */
+    @discardableResult
+    static func loadDeferredWrites() -> Bool {
+        RGLockbox.deferredWritesLock.lock()
+        let isUnread = RGLockbox.isDeferredWritesFileUnread
+        RGLockbox.deferredWritesLock.unlock()
+        guard isUnread, let url = RGLockbox.deferredWritesURL else {
+            return true
+        }
+        var data:Data? = nil
+        do {
+            data = try Data(contentsOf: url)
+        } catch {
+            if FileManager.default.fileExists(atPath: url.path) {
+                RGLogs(.debug, "deferred writes at \(url) are not readable yet")
+                return false
+            }
+        }
+        let plist = data.flatMap({
+            (try? PropertyListSerialization.propertyList(from: $0, options: [], format: nil)) as? [[String:Any]]
+        })
+        RGLockbox.deferredWritesLock.lock()
+        for entry in plist ?? [] {
+            if let write = RGItemWrite(propertyList: entry), RGLockbox.deferredWrites[write.fullKey] == nil {
+                RGLockbox.deferredWrites[write.fullKey] = write
+                RGLockbox.deferredAttempts[write.fullKey] = 0
+            }
+        }
+        RGLockbox.isDeferredWritesFileUnread = false
+        RGLockbox.deferredWritesLock.unlock()
+        return true
+    }
+}
@@ -0,0 +1,160 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import Security
+
+/**
+ Summarizes what is stored in a keychain item: two independent 64-bit hashes and the length of its data together with
+   the accessibility and synchronizability it was written with.  Used to detect rewrites of an unchanged value after the
+   value itself has left `valueCache`.
+ */
+struct RGContentDigest: Equatable {
+    
+/**
+ The length of the data, or -1 if the item is absent.
+ */
+    let length:Int
+    
+/**
+ FNV-1a and a multiply-rotate hash of the data, both 0 if the item is absent.
+ */
+    let primary:UInt64
+    let secondary:UInt64
+    
+/**
+ The attributes of the item when known; `nil` if absent or not reported.
+ */
+    let accessibility:String?
+    let isSynchronized:Bool?
+    
+/**
+ The digest of an absent item.
+ */
+    static let absent = RGContentDigest(nil, accessibility: nil, synchronized: nil)
+    
+    init(_ data:Data?, accessibility:String?, synchronized:Bool?) {
+        var primary:UInt64 = 0
+        var secondary:UInt64 = 0
+        if let data = data {
+            primary = 0xcbf29ce484222325
+            secondary = 0x9e3779b97f4a7c15
+            data.withUnsafeBytes({ (bytes:UnsafePointer<UInt8>) -> Void in
+                for index in 0..<data.count {
+                    primary = (primary ^ UInt64(bytes[index])) &* 0x100000001b3
+                    secondary = (secondary ^ UInt64(bytes[index])) &* 0xff51afd7ed558ccd
+                    secondary = (secondary << 31) | (secondary >> 33)
+                }
+            })
+        }
+        self.length = data?.count ?? -1
+        self.primary = primary
+        self.secondary = secondary
+        self.accessibility = data != nil ? accessibility : nil
+        self.isSynchronized = data != nil ? synchronized : nil
+    }
+    
+    init(length:Int, primary:UInt64, secondary:UInt64, accessibility:String?, synchronized:Bool?) {
+        self.length = length
+        self.primary = primary
+        self.secondary = secondary
+        self.accessibility = accessibility
+        self.isSynchronized = synchronized
+    }
+    
+/**
+ - parameter attributes: The attributes and data returned for an item by the keychain, `nil` if it was not found.  The
+   digest of a chunked or enveloped value is taken from its reference.
+ */
+    init(attributes:Dictionary<String, Any>?) {
+        let data = attributes?[kSecValueData as String] as? Data
+        let accessibility = attributes?[kSecAttrAccessible as String] as? String
+        let synchronized = (attributes?[kSecAttrSynchronizable as String] as? NSNumber)?.boolValue
+        if let reference = RGLockbox.valueReference(fromAttributes: attributes) {
+            self.init(length: reference.length,
+                      primary: reference.primary,
+                      secondary: reference.secondary,
+                      accessibility: accessibility,
+                      synchronized: synchronized)
+        } else {
+            self.init(data, accessibility: accessibility, synchronized: synchronized)
+        }
+    }
+    
+/**
+ - returns: `true` if the items have the same accessibility and synchronizability.
+ */
+    func hasSameAttributes(_ other:RGContentDigest) -> Bool {
+        return self.accessibility == other.accessibility && self.isSynchronized == other.isSynchronized
+    }
+    
+    static func == (lhs:RGContentDigest, rhs:RGContentDigest) -> Bool {
+        return lhs.length == rhs.length && lhs.primary == rhs.primary && lhs.secondary == rhs.secondary &&
+            lhs.hasSameAttributes(rhs)
+    }
+}
+
+/**
+ Write elision: a write which would leave the keychain item exactly as it is skips the keychain entirely.
+ */
+extension RGLockbox {
+    
+/**
+ The digest of what this process last read from or wrote to each item in `valueCache`, dropped with its entry.
+   Guarded by `valueCacheLock`.
+ */
+    static var valueDigests:[RGMultiKey : RGContentDigest] = [:]
+    
+/**
+ The number of writes skipped so far.  Guarded by `valueCacheLock`.
+ */
+    static var elidedWrites = 0
+    
+/**
+ The number of calls to `setData` and its variants which were skipped because the item already held the value.
+ */
+    public static var elidedWriteCount:Int {
+        RGLockbox.valueCacheLock.lock()
+        let count = RGLockbox.elidedWrites
+        RGLockbox.valueCacheLock.unlock()
+        return count
+    }
+    
+/**
+ Whether writing `written` over the item for `fullKey` would change nothing.  Compares bytes when the value is cached and
+   digests otherwise; items with a time to live or whose cache entry is not current are never considered unchanged.
+   Must hold `valueCacheLock`.
+ */
+    static func isUnchanged(_ data:Data?, digest written:RGContentDigest, forKey fullKey:RGMultiKey) -> Bool {
+        guard let stored = RGLockbox.valueDigests[fullKey],
+              RGLockbox.expirations[fullKey] == nil,
+              RGLockbox.isCacheCurrent(fullKey) else {
+            return false
+        }
+        if let cached = RGLockbox.cachedValues[fullKey], !(cached is RGValueReference) {
+            let cachedData = cached as? Data
+            return cachedData == data && stored.hasSameAttributes(written)
+        }
+        return stored == written
+    }
+}
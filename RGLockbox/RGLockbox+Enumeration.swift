@@ -0,0 +1,151 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import Security
+
+/**
+ One item of an enumeration decoded and ready to be cached.
+ */
+struct RGEnumeratedItem {
+    let fullKey:RGMultiKey
+    
+/**
+ The key to report for the item, `nil` if it is expired or outside the manager's namespace.
+ */
+    let name:String?
+    
+    let entry:Any
+    let digest:RGContentDigest
+    let expiry:Date?
+}
+
+/**
+ Bulk loads run as a pipeline: the keychain is enumerated without holding `valueCacheLock`, the items are bridged and
+   decoded in batches across all cores, and `valueCache` is filled in a single short lock hold.  If anything was written
+   while the enumeration was in flight only keys still absent from `valueCache` are filled, so a newer write is never
+   replaced by what the enumeration saw.
+ */
+extension RGLockbox {
+    
+/**
+ The number of items each worker decodes at a time.
+ */
+    open static var enumerationBatchSize = 256
+    
+/**
+ Advanced by every change to `valueCache` which an enumeration must not overwrite.  Guarded by `valueCacheLock`.
+ */
+    static var writeEpoch:UInt64 = 0
+    
+/**
+ Must hold `valueCacheLock`.
+ */
+    static func advanceWriteEpoch() {
+        RGLockbox.writeEpoch = RGLockbox.writeEpoch &+ 1
+        RGLockbox.invalidateThreadCaches()
+    }
+    
+/**
+ - returns: The current `writeEpoch`.
+ */
+    static func currentWriteEpoch() -> UInt64 {
+        RGLockbox.valueCacheLock.lock()
+        let epoch = RGLockbox.writeEpoch
+        RGLockbox.valueCacheLock.unlock()
+        return epoch
+    }
+    
+/**
+ Decodes the items returned by an enumeration in parallel.
+ - parameter items: The attribute dictionaries returned by the keychain.
+ - parameter scope: The account and access group of the enumeration.
+ - parameter namespace: The namespace whose keys are reported.
+ - returns: One entry per item in the order returned, `nil` for items which are not cached.
+ */
+    static func decodeEnumeration(_ items:NSArray, scope:RGMultiKey, namespace:String?) -> [RGEnumeratedItem?] {
+        let count = items.count
+        var results = [RGEnumeratedItem?](repeating: nil, count: count)
+        if count == 0 {
+            return results
+        }
+        let now = Date()
+        let prefix = namespace != nil ? "\(namespace!)." : nil
+        let batchSize = max(1, RGLockbox.enumerationBatchSize)
+        let batches = (count + batchSize - 1) / batchSize
+        results.withUnsafeMutableBufferPointer({ (buffer:inout UnsafeMutableBufferPointer<RGEnumeratedItem?>) -> Void in
+            let base = buffer.baseAddress!
+            DispatchQueue.concurrentPerform(iterations: batches, execute: { batch in
+                for index in batch * batchSize ..< min(count, (batch + 1) * batchSize) {
+                    base[index] = RGLockbox.enumeratedItem(items[index], scope: scope, prefix: prefix, now: now)
+                }
+            })
+        })
+        return results
+    }
+    
+/**
+ - returns: The decoded form of one enumerated item, `nil` if it has no service or is internal to `RGLockbox`.
+ */
+    static func enumeratedItem(_ object:Any, scope:RGMultiKey, prefix:String?, now:Date) -> RGEnumeratedItem? {
+        guard let item = RGLockbox.decodedItem(object as? Dictionary<String, Any>),
+              let service = item[kSecAttrService as String] as? String,
+              !service.hasPrefix(RGLockbox.chunkItemPrefix),
+              !service.hasPrefix(RGLockbox.envelopeKeyPrefix),
+              !service.hasSuffix(RGLockbox.packedItemName),
+              service != RGLockbox.warmStartItemName else {
+            return nil
+        }
+        let expiry = RGLockbox.expiry(fromAttributes: item)
+        var name:String? = nil
+        if expiry != nil && expiry! <= now {
+            RGLogs(.trace, "skipping expired item \(service)")
+        } else if prefix == nil {
+            name = service
+        } else if service.hasPrefix(prefix!) {
+            name = service.substring(from: service.index(service.startIndex, offsetBy: prefix!.characters.count))
+        }
+        return RGEnumeratedItem(fullKey: RGMultiKey(withFirst: service, second: scope.second, third: scope.third),
+                                name: name,
+                                entry: RGLockbox.cacheEntry(for: item[kSecValueData as String] as? Data,
+                                                            isReference: RGLockbox.isReferenceItem(item)),
+                                digest: RGContentDigest(attributes: item),
+                                expiry: expiry)
+    }
+    
+/**
+ Caches decoded items in one lock hold.
+ - parameter epoch: The `writeEpoch` from before the enumeration started.
+ */
+    static func cacheEnumeration(_ items:[RGEnumeratedItem?], since epoch:UInt64) {
+        RGLockbox.valueCacheLock.lock()
+        let isQuiescent = RGLockbox.writeEpoch == epoch
+        RGLockbox.invalidateThreadCaches()
+        for case let item? in items where isQuiescent || RGLockbox.cachedValues[item.fullKey] == nil {
+            RGLockbox.cachedValues[item.fullKey] = item.entry
+            RGLockbox.valueDigests[item.fullKey] = item.digest
+            RGLockbox.trackExpiry(item.expiry, forKey: item.fullKey)
+        }
+        RGLockbox.valueCacheLock.unlock()
+    }
+}
@@ -0,0 +1,380 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import Security
+
+/**
+ Describes a value stored encrypted in a file of `RGLockbox.envelopeDirectory`.  The envelope is what the value's own
+   keychain item holds and what `valueCache` holds for it.
+ 
+ Files are named after a random token chosen per write and never modified once written.
+ */
+final class RGEnvelope : RGValueReference {
+    
+    static let magic:UInt64 = 0x4c564e45424c4752 // "RGLBENVL"
+    static let version:UInt8 = 1
+    
+/**
+ The namespace whose data key encrypts the file.
+ */
+    let namespace:String
+    let token:[UInt8]
+    let nonce:[UInt8]
+    
+/**
+ The HMAC-SHA-256 of the nonce and the encrypted file.
+ */
+    let tag:[UInt8]
+    let length:Int
+    let primary:UInt64
+    let secondary:UInt64
+    
+    init(namespace:String, token:[UInt8], nonce:[UInt8], tag:[UInt8], length:Int, primary:UInt64, secondary:UInt64) {
+        self.namespace = namespace
+        self.token = token
+        self.nonce = nonce
+        self.tag = tag
+        self.length = length
+        self.primary = primary
+        self.secondary = secondary
+    }
+    
+/**
+ - parameter data: The contents of a keychain item.
+ - returns: The envelope held by `data`, `nil` if `data` is not an envelope.
+ */
+    convenience init?(_ data:Data?) {
+        guard let data = data, data.count < 1024 else {
+            return nil
+        }
+        var reader = RGByteReader(data)
+        guard reader.readUInt64() == RGEnvelope.magic,
+              reader.readUInt8() == RGEnvelope.version,
+              let namespace = reader.readString(),
+              let token = reader.readBytes(16),
+              let nonce = reader.readBytes(12),
+              let tag = reader.readBytes(32),
+              let length = reader.readUInt64(),
+              let primary = reader.readUInt64(),
+              let secondary = reader.readUInt64(),
+              reader.remaining == 0 else {
+            return nil
+        }
+        self.init(namespace: namespace,
+                  token: token,
+                  nonce: nonce,
+                  tag: tag,
+                  length: Int(length),
+                  primary: primary,
+                  secondary: secondary)
+    }
+    
+/**
+ The serialized envelope.
+ */
+    var data:Data {
+        var writer = RGByteWriter()
+        writer.write(RGEnvelope.magic)
+        writer.write(RGEnvelope.version)
+        writer.write(self.namespace)
+        writer.write(self.token)
+        writer.write(self.nonce)
+        writer.write(self.tag)
+        writer.write(UInt64(self.length))
+        writer.write(self.primary)
+        writer.write(self.secondary)
+        return writer.data
+    }
+    
+    var fileName:String {
+        return self.token.map({ String(format: "%02x", $0) }).joined()
+    }
+    
+/**
+ - returns: The key of the item holding the data key for the value stored at `fullKey`.
+ */
+    func keyItem(of fullKey:RGMultiKey) -> RGMultiKey {
+        return RGMultiKey(withFirst: "\(RGLockbox.envelopeKeyPrefix)\(self.namespace)",
+                          second: fullKey.second,
+                          third: fullKey.third)
+    }
+}
+
+/**
+ The identity and state of an envelope file when it was authenticated.  A file replaced, resized, or written since has
+   a different inode, size, or change time and is authenticated again.
+ */
+struct RGEnvelopeFileState : Equatable {
+    let device:Int64
+    let inode:UInt64
+    let size:Int64
+    let modified:timespec
+    let changed:timespec
+    
+    init(_ info:stat) {
+        self.device = Int64(info.st_dev)
+        self.inode = UInt64(info.st_ino)
+        self.size = Int64(info.st_size)
+        self.modified = info.st_mtimespec
+        self.changed = info.st_ctimespec
+    }
+    
+    static func ==(lhs:RGEnvelopeFileState, rhs:RGEnvelopeFileState) -> Bool {
+        return lhs.device == rhs.device && lhs.inode == rhs.inode && lhs.size == rhs.size
+            && lhs.modified.tv_sec == rhs.modified.tv_sec && lhs.modified.tv_nsec == rhs.modified.tv_nsec
+            && lhs.changed.tv_sec == rhs.changed.tv_sec && lhs.changed.tv_nsec == rhs.changed.tv_nsec
+    }
+}
+
+/**
+ Values longer than `envelopeThreshold` are encrypted with AES-256 in counter mode under a per namespace data key,
+   authenticated with HMAC-SHA-256, and written to a file in `envelopeDirectory`; the keychain item holds only the
+   envelope.  The data key is a keychain item of its own, read once and cached.  Reads map the file and decrypt only the
+   blocks of the range requested; a file is authenticated in full the first time it is read and again whenever its
+   inode, size, or modification or change time differ from when it was.  Files are local to the device, so enveloped
+   values are never synchronized, and packed managers never use envelopes.
+ */
+extension RGLockbox {
+    
+/**
+ The service prefix of data key items.  Data key items are not reported by `allItems()`.
+ */
+    static let envelopeKeyPrefix = "RGLockbox.envelope."
+    
+/**
+ Where enveloped values are kept, `nil` to keep every value in the keychain.
+ */
+    open static var envelopeDirectory:URL?
+    
+/**
+ Values longer than this many bytes are enveloped while `envelopeDirectory` is set.
+ */
+    open static var envelopeThreshold = 32 * 1024
+    
+/**
+ Data keys by their item, and the state of files already authenticated by their name.  Guarded by `valueCacheLock`.
+ */
+    static var envelopeKeys:[RGMultiKey : [UInt8]] = [:]
+    static var verifiedEnvelopes:[String : RGEnvelopeFileState] = [:]
+    
+/**
+ Encrypts `data` into a new file if it should be enveloped.  Must hold the `keyLock(for:)` of the key being written and
+   not `valueCacheLock`.
+ - returns: The envelope of the file, `nil` if `data` is stored in the keychain.
+ */
+    func sealEnvelope(_ data:Data?, digest:RGContentDigest) -> RGEnvelope? {
+        guard let data = data,
+              let directory = RGLockbox.envelopeDirectory,
+              data.count > RGLockbox.envelopeThreshold,
+              !self.isSynchronized else {
+            return nil
+        }
+        let namespace = self.namespace ?? ""
+        let keyItem = RGMultiKey(withFirst: "\(RGLockbox.envelopeKeyPrefix)\(namespace)",
+                                 second: self.accountName,
+                                 third: self.accessGroup)
+        RGLockbox.valueCacheLock.lock()
+        var key = RGLockbox.envelopeKeys[keyItem]
+        RGLockbox.valueCacheLock.unlock()
+        if key == nil {
+            RGLockbox.enqueueAndWait(keys: [ keyItem ], execute: {
+                key = RGLockbox.loadEnvelopeKey(keyItem, creatingWith: self.itemAccessibility)
+            })
+            guard key != nil else {
+                RGLogs(.warning, "unable to create the data key for \(namespace)")
+                return nil
+            }
+            RGLockbox.valueCacheLock.lock()
+            RGLockbox.envelopeKeys[keyItem] = key
+            RGLockbox.valueCacheLock.unlock()
+        }
+        var token = [UInt8](repeating: 0, count: 16)
+        var nonce = [UInt8](repeating: 0, count: 12)
+        guard SecRandomCopyBytes(kSecRandomDefault, token.count, &token) == 0,
+              SecRandomCopyBytes(kSecRandomDefault, nonce.count, &nonce) == 0 else {
+            return nil
+        }
+        let keys = RGLockbox.envelopeKeys(key!)
+        guard let cipher = RGCipher(key: keys.encryption, nonce: nonce) else {
+            return nil
+        }
+        var bytes = [UInt8](data)
+        cipher.apply(&bytes)
+        var mac = RGHMAC(key: keys.authentication)
+        mac.update(nonce)
+        mac.update(bytes)
+        let envelope = RGEnvelope(namespace: namespace,
+                                  token: token,
+                                  nonce: nonce,
+                                  tag: mac.finalize(),
+                                  length: data.count,
+                                  primary: digest.primary,
+                                  secondary: digest.secondary)
+        do {
+            try Data(bytes: bytes).write(to: directory.appendingPathComponent(envelope.fileName), options: .atomic)
+        } catch {
+            RGLogs(.error, "unable to write envelope to \(directory) error \(error)")
+            return nil
+        }
+        return envelope
+    }
+    
+/**
+ Caches `envelope` for `fullKey`.  Must hold `valueCacheLock`.
+ - returns: The keychain work writing the envelope, followed by the removal of the storage of the value being replaced.
+ */
+    func stageEnvelope(_ envelope:RGEnvelope, forKey fullKey:RGMultiKey, digest:RGContentDigest, expiry:Date?,
+                       replacing previous:RGValueReference?) -> () -> Void {
+        RGLockbox.cachedValues[fullKey] = envelope
+        RGLockbox.valueDigests[fullKey] = digest
+        RGLockbox.trackExpiry(expiry, forKey: fullKey)
+        let write = RGItemWrite(fullKey: fullKey,
+                                data: envelope.data,
+                                accessibility: self.itemAccessibility,
+                                isSynchronized: self.isSynchronized,
+                                expiry: expiry,
+                                updatesInPlace: false,
+                                isReference: true)
+        return {
+            let replaced = previous ?? RGLockbox.readReference(fullKey)
+            RGLockbox.perform(write)
+            if let replaced = replaced, RGLockbox.deferredWrite(for: fullKey) == nil {
+                RGLockbox.removeStorage(of: replaced, forKey: fullKey)
+            }
+        }
+    }
+    
+/**
+ Reads `range` of an enveloped value.  Must hold `valueCacheLock`.
+ - returns: The bytes, or `nil` if the file is missing or not authentic.
+ */
+    static func envelopeValue(_ envelope:RGEnvelope, forKey fullKey:RGMultiKey, range:Range<Int>?) -> Data? {
+        let keyItem = envelope.keyItem(of: fullKey)
+        var key = RGLockbox.envelopeKeys[keyItem]
+        if key == nil {
+            RGLockbox.enqueueAndWait(keys: [ keyItem ], execute: {
+                key = RGLockbox.loadEnvelopeKey(keyItem, creatingWith: nil)
+            })
+            RGLockbox.envelopeKeys[keyItem] = key
+        }
+        guard let directory = RGLockbox.envelopeDirectory, let dataKey = key, envelope.length > 0 else {
+            RGLogs(.warning, "envelope of \(fullKey.first) is unreadable")
+            return nil
+        }
+        let path = directory.appendingPathComponent(envelope.fileName).path
+        let fd = open(path, O_RDONLY)
+        if fd < 0 {
+            RGLogs(.warning, "envelope of \(fullKey.first) is unreadable errno \(errno)")
+            return nil
+        }
+        defer { close(fd) }
+        var info = stat()
+        let pointer = fstat(fd, &info) == 0 && info.st_size == off_t(envelope.length)
+            ? mmap(nil, envelope.length, PROT_READ, MAP_PRIVATE, fd, 0) : nil
+        if pointer == nil || pointer == UnsafeMutableRawPointer(bitPattern: -1) {
+            RGLogs(.warning, "envelope of \(fullKey.first) is unreadable errno \(errno)")
+            return nil
+        }
+        let file = Data(bytesNoCopy: pointer!, count: envelope.length, deallocator: .unmap)
+        let state = RGEnvelopeFileState(info)
+        let keys = RGLockbox.envelopeKeys(dataKey)
+        if RGLockbox.verifiedEnvelopes[envelope.fileName] != state {
+            var mac = RGHMAC(key: keys.authentication)
+            mac.update(envelope.nonce)
+            var offset = 0
+            while offset < file.count {
+                let end = min(offset + 1024 * 1024, file.count)
+                mac.update([UInt8](file.subdata(in: offset ..< end)))
+                offset = end
+            }
+            guard RGHMAC.isEqual(mac.finalize(), envelope.tag) else {
+                RGLockbox.verifiedEnvelopes[envelope.fileName] = nil
+                RGLogs(.error, "envelope of \(fullKey.first) failed authentication")
+                return nil
+            }
+            RGLockbox.verifiedEnvelopes[envelope.fileName] = state
+        }
+        let lower = min(range?.lowerBound ?? 0, envelope.length)
+        let upper = min(range?.upperBound ?? envelope.length, envelope.length)
+        if lower >= upper {
+            return Data()
+        }
+        let blockStart = lower - lower % RGCipher.blockLength
+        let counter = UInt32(blockStart / RGCipher.blockLength)
+        guard let cipher = RGCipher(key: keys.encryption, nonce: envelope.nonce, counter: counter) else {
+            return nil
+        }
+        var bytes = [UInt8](repeating: 0, count: upper - blockStart)
+        file.copyBytes(to: &bytes, from: blockStart ..< upper)
+        cipher.apply(&bytes)
+        return Data(bytes: bytes[(lower - blockStart) ..< bytes.count])
+    }
+    
+/**
+ - parameter accessibility: The accessibility of a new key, `nil` to only read an existing one.
+ - returns: The data key held by `keyItem`, created first if it is missing and `accessibility` is set.  A new key is
+   only ever added, so a key another process created first is read and used rather than replaced.  Must be called on
+   `keychainQueue`.
+ */
+    static func loadEnvelopeKey(_ keyItem:RGMultiKey, creatingWith accessibility:CFString?) -> [UInt8]? {
+        if let data = RGLockbox.readItem(keyItem), data.count == 32 {
+            return [UInt8](data)
+        }
+        guard let accessibility = accessibility else {
+            return nil
+        }
+        var key = [UInt8](repeating: 0, count: 32)
+        guard SecRandomCopyBytes(kSecRandomDefault, key.count, &key) == 0 else {
+            return nil
+        }
+        var item = RGLockbox.itemQuery(keyItem)
+        item[kSecAttrSynchronizable] = false as NSNumber
+        item[kSecAttrAccessible] = accessibility
+        item[kSecValueData] = RGLockbox.encodeValue(Data(bytes: key)) as NSData
+        let status = RGLockbox.watchedAdd(item as NSDictionary)
+        RGLogs(.trace, "SecItemAdd of data key \(keyItem.first) returned \(status)")
+        if status == errSecDuplicateItem, let data = RGLockbox.readItem(keyItem), data.count == 32 {
+            return [UInt8](data)
+        }
+        return status == errSecSuccess ? key : nil
+    }
+    
+/**
+ - returns: Independent encryption and authentication keys derived from a data key.
+ */
+    static func envelopeKeys(_ key:[UInt8]) -> (encryption:[UInt8], authentication:[UInt8]) {
+        return (RGHMAC.authenticate([UInt8]("RGLockbox.envelope.encryption".utf8), key: key),
+                RGHMAC.authenticate([UInt8]("RGLockbox.envelope.authentication".utf8), key: key))
+    }
+    
+/**
+ Deletes the file of `envelope`.
+ */
+    static func removeEnvelope(_ envelope:RGEnvelope) {
+        guard let directory = RGLockbox.envelopeDirectory else {
+            return
+        }
+        try? FileManager.default.removeItem(at: directory.appendingPathComponent(envelope.fileName))
+    }
+}
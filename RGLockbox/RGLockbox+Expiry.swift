@@ -0,0 +1,220 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import Security
+
+/**
+ Per-item time to live.  The expiry is stored with the item as its `kSecAttrGeneric` attribute, an expired item reads as
+   absent immediately, and a timing wheel reaps expired items from `valueCache` and deletes them from the keychain in a
+   single background block.  One timer is pending at a time, set for the wheel's earliest deadline.
+ */
+extension RGLockbox {
+    
+/**
+ Prefix of the `kSecAttrGeneric` attribute of items written with a time to live; followed by the expiry as seconds since
+   1970.  The prefix keeps unrelated uses of the attribute from being read as an expiry.
+ */
+    static let expiryAttributePrefix = "RGLockbox.expires:"
+    
+/**
+ The expiry of every item in `valueCache` which has one.  Guarded by `valueCacheLock`.
+ */
+    static var expirations:[RGMultiKey : Date] = [:]
+    
+/**
+ Orders the keys in `expirations` by deadline.  Guarded by `valueCacheLock`.
+ */
+    static let expiryWheel = RGTimingWheel()
+    
+/**
+ The pending call to `reapExpiredItems()` and the time it runs.  Guarded by `valueCacheLock`.
+ */
+    static var reapTimer:DispatchWorkItem? = nil
+    static var reapDeadline:Date? = nil
+    
+/**
+ Writes `data` which will read as absent once `ttl` seconds have passed.
+ - parameter data: The data to store on the given key.  If `nil` clears the value in the keychain.
+ - parameter key: The identifier of the keychain item.
+ - parameter ttl: The lifetime of the value in seconds.
+ */
+    public func setData(_ data:Data?, forKey key:String, ttl:TimeInterval) {
+        self.setData(data, forKey: key, expiry: Date(timeIntervalSinceNow: ttl))
+    }
+    
+/**
+ - parameter expiry: The expiry of an item or `nil`.
+ - returns: The `kSecAttrGeneric` value recording `expiry`.
+ */
+    static func expiryAttribute(_ expiry:Date?) -> Data? {
+        guard let expiry = expiry else {
+            return nil
+        }
+        return "\(RGLockbox.expiryAttributePrefix)\(expiry.timeIntervalSince1970)".data(using: String.Encoding.utf8)
+    }
+    
+/**
+ - parameter attributes: The attributes returned for an item by the keychain.
+ - returns: The expiry recorded in its `kSecAttrGeneric` attribute, `nil` if it does not expire.
+ */
+    static func expiry(fromAttributes attributes:Dictionary<String, Any>?) -> Date? {
+        guard let generic = attributes?[kSecAttrGeneric as String] as? Data,
+              let string = String(data: generic, encoding: String.Encoding.utf8),
+              string.hasPrefix(RGLockbox.expiryAttributePrefix) else {
+            return nil
+        }
+        let seconds = string.substring(from: string.index(string.startIndex,
+                                                          offsetBy: RGLockbox.expiryAttributePrefix.characters.count))
+        let interval = TimeInterval(seconds)
+        return interval != nil ? Date(timeIntervalSince1970: interval!) : nil
+    }
+    
+/**
+ Records the expiry of the entry for `fullKey` in `valueCache`.  Must hold `valueCacheLock`.
+ */
+    static func trackExpiry(_ expiry:Date?, forKey fullKey:RGMultiKey) {
+        RGLockbox.expirations[fullKey] = expiry
+        if let expiry = expiry {
+            RGLockbox.scheduleReap(at: RGLockbox.expiryWheel.schedule(fullKey, at: expiry))
+        } else {
+            RGLockbox.expiryWheel.cancel(fullKey)
+        }
+    }
+    
+/**
+ - parameter value: The entry for `fullKey` in `valueCache`.
+ - parameter range: The byte offsets to return, `nil` for the whole value.
+ - returns: The value as `Data`, or `nil` if it is absent or expired.  Must hold `valueCacheLock`.
+ */
+    static func liveValue(_ value:Any, forKey fullKey:RGMultiKey, range:Range<Int>? = nil) -> Data? {
+        if let expiry = RGLockbox.expirations[fullKey], expiry <= Date() {
+            return nil
+        }
+        if let reference = value as? RGValueReference {
+            return RGLockbox.referencedValue(reference, forKey: fullKey, range: range)
+        }
+        guard let data = value as? Data else {
+            return nil
+        }
+        guard let range = range else {
+            return data
+        }
+        return data.subdata(in: min(range.lowerBound, data.count) ..< min(range.upperBound, data.count))
+    }
+    
+/**
+ Arranges for `reapExpiredItems()` to run at `deadline` unless it already runs by then, replacing a later timer.  Must
+   hold `valueCacheLock`.
+ */
+    static func scheduleReap(at deadline:Date) {
+        if let pending = RGLockbox.reapDeadline, pending <= deadline {
+            return
+        }
+        RGLockbox.reapTimer?.cancel()
+        let timer = DispatchWorkItem(block: {
+            RGLockbox.reapExpiredItems()
+        })
+        RGLockbox.reapTimer = timer
+        RGLockbox.reapDeadline = deadline
+        let delay = DispatchTime.now() + max(deadline.timeIntervalSinceNow, 0)
+        DispatchQueue.global(qos: .background).asyncAfter(deadline: delay, execute: timer)
+    }
+    
+/**
+ Drops every expired item from `valueCache` and deletes them from the keychain in one background block.  The block is
+   enqueued under `valueCacheLock` so it is ordered before any later write to the same keys, and only deletes an item
+   whose stored expiry has passed so one rewritten by another process survives.
+ */
+    static func reapExpiredItems() {
+        let now = Date()
+        RGLockbox.valueCacheLock.lock()
+        RGLockbox.reapTimer = nil
+        RGLockbox.reapDeadline = nil
+        var expired:[RGMultiKey] = []
+        var references:[RGMultiKey : RGValueReference] = [:]
+        for fullKey in RGLockbox.expiryWheel.advance(to: now) {
+            if let expiry = RGLockbox.expirations[fullKey], expiry <= now {
+                RGLockbox.advanceWriteEpoch()
+                references[fullKey] = RGLockbox.cachedValues[fullKey] as? RGValueReference
+                RGLockbox.expirations[fullKey] = nil
+                RGLockbox.cachedValues[fullKey] = NSNull()
+                RGLockbox.valueDigests[fullKey] = RGContentDigest.absent
+                RGLockbox.recordIndexedKey(fullKey, isPresent: false)
+                expired.append(fullKey)
+            }
+        }
+        if expired.count > 0 {
+            RGLockbox.enqueue(qos: .background, keys: expired, execute: {
+                var rewritten:[RGMultiKey] = []
+                for fullKey in expired {
+                    var query = RGLockbox.itemQuery(fullKey)
+                    query[kSecMatchLimit] = kSecMatchLimitOne
+                    query[kSecReturnAttributes] = true as NSNumber
+                    var attributes:AnyObject? = nil
+                    if RGLockbox.watchedCopyMatching(query as NSDictionary, &attributes) == errSecItemNotFound {
+                        continue
+                    }
+                    guard let expiry = RGLockbox.expiry(fromAttributes: attributes as? Dictionary<String, Any>),
+                          expiry <= Date() else {
+                        RGLogs(.trace, "expired item \(fullKey.first) was rewritten, not deleting it")
+                        rewritten.append(fullKey)
+                        continue
+                    }
+                    query = RGLockbox.itemQuery(fullKey)
+                    let generation = RGLockbox.generationTable?.generation(for: fullKey)
+                    let status = RGLockbox.watchedDelete(query as NSDictionary)
+                    RGLogs(.trace, "SecItemDelete of expired item with \(query) returned \(status)")
+                    RGLockbox.advanceGeneration(fullKey, from: generation)
+                    if let reference = references[fullKey] {
+                        RGLockbox.removeStorage(of: reference, forKey: fullKey)
+                    }
+                }
+                if rewritten.count > 0 {
+                    DispatchQueue.global(qos: .background).async(execute: {
+                        RGLockbox.forgetReapedItems(rewritten)
+                    })
+                }
+            })
+        }
+        if let deadline = RGLockbox.expiryWheel.nextDeadline {
+            RGLockbox.scheduleReap(at: deadline)
+        }
+        RGLockbox.valueCacheLock.unlock()
+    }
+    
+/**
+ Drops the absent entries left in `valueCache` for `keys` whose items were rewritten before the reaper could delete
+   them, so the next read finds the new value.
+ */
+    static func forgetReapedItems(_ keys:[RGMultiKey]) {
+        RGLockbox.valueCacheLock.lock()
+        for fullKey in keys where RGLockbox.cachedValues[fullKey] is NSNull {
+            RGLockbox.advanceWriteEpoch()
+            RGLockbox.cachedValues[fullKey] = nil
+            RGLockbox.valueDigests[fullKey] = nil
+            RGLockbox.recordIndexedKey(fullKey, isPresent: true)
+        }
+        RGLockbox.valueCacheLock.unlock()
+    }
+}
@@ -0,0 +1,220 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import Security
+
+/**
+ The key index of one account and access group and what it was built against.
+ */
+final class RGKeyIndexScope {
+    let index:RGKeyIndex
+    
+/**
+ The generation of every bucket of `generationTable` when the index was last known to match the keychain, if there was
+   a table.
+ */
+    var generations:[Int64]?
+    
+    init(index:RGKeyIndex, generations:[Int64]?) {
+        self.index = index
+        self.generations = generations
+    }
+}
+
+/**
+ Prefix queries are answered from an ordered index of the services visible to a manager's account and access group.
+   The index is built by `allItems()` and kept up to date by this process's writes, so once warm `keys(withPrefix:)`
+   and `removeAll(withPrefix:)` never enumerate the keychain.  When `generationTable` is set a write by another process
+   sends the next query back to the keychain.
+ */
+extension RGLockbox {
+    
+/**
+ The indexes by account and access group, in `second` and `third`.  Guarded by `keyIndexLock`.
+ */
+    static var keyIndexScopes:[RGMultiKey : RGKeyIndexScope] = [:]
+    
+/**
+ Taken after `valueCacheLock` when both are held.  May be taken on `keychainQueue`.
+ */
+    static let keyIndexLock = NSLock()
+    
+/**
+ Forgets every key index so they are built again.  Call after items are added to or removed from the keychain by means
+   other than `RGLockbox` in this process.
+ */
+    public static func invalidateKeyIndexes() {
+        RGLockbox.keyIndexLock.lock()
+        RGLockbox.keyIndexScopes.removeAll()
+        RGLockbox.keyIndexLock.unlock()
+    }
+    
+/**
+ Returns the keys visible to this manager which begin with `prefix`, ordered by their UTF-8 bytes.  Enumerates the
+   keychain as `allItems()` only when the index is cold.  Expired items are omitted.
+ - parameter prefix: The start of the keys to return, not including the namespace.
+ */
+    public func keys(withPrefix prefix:String) -> [String] {
+        if self.isPacked {
+            return self.allPackedItems().filter({ $0.utf8.starts(with: prefix.utf8) }).sorted(by: RGKeyIndex.precedes)
+        }
+        let scope = RGMultiKey(second: self.accountName, third: self.accessGroup)
+        let namespacePrefix = self.namespace != nil ? "\(self.namespace!)." : ""
+        guard let services = RGLockbox.indexedServices(withPrefix: namespacePrefix + prefix, scope: scope) else {
+            return self.allItems().filter({ $0.utf8.starts(with: prefix.utf8) }).sorted(by: RGKeyIndex.precedes)
+        }
+        let offset = namespacePrefix.characters.count
+        return services.map({ $0.substring(from: $0.index($0.startIndex, offsetBy: offset)) })
+    }
+    
+/**
+ Removes every key visible to this manager which begins with `prefix` with a single hop to `keychainQueue`.
+ - parameter prefix: The start of the keys to remove, not including the namespace.
+ - returns: The number of keys removed.
+ */
+    @discardableResult
+    public func removeAll(withPrefix prefix:String) -> Int {
+        let keys = self.keys(withPrefix: prefix)
+        if keys.count > 0 {
+            self.storeBatch(keys.map({ ($0, nil, nil) }))
+        }
+        return keys.count
+    }
+    
+/**
+ - returns: Whether the account and access group of `scopeKey`, in `second` and `third`, include `fullKey`.
+ */
+    static func scope(_ scopeKey:RGMultiKey, canSee fullKey:RGMultiKey) -> Bool {
+        return (scopeKey.second == nil || scopeKey.second == fullKey.second)
+            && (scopeKey.third == nil || scopeKey.third == fullKey.third)
+    }
+    
+/**
+ - returns: The live services of `scope` beginning with `prefix`, `nil` if there is no current index for it.
+ */
+    static func indexedServices(withPrefix prefix:String, scope scopeKey:RGMultiKey) -> [String]? {
+        let generations = RGLockbox.generationTable.map({ table in
+            (0 ..< table.bucketCount).map({ table.generation(atBucket: $0) })
+        })
+        RGLockbox.valueCacheLock.lock()
+        RGLockbox.keyIndexLock.lock()
+        var services:[String]? = nil
+        if let scope = RGLockbox.keyIndexScopes[scopeKey], generations == nil ? scope.generations == nil
+            : scope.generations != nil && scope.generations! == generations! {
+            services = scope.index.keys(withPrefix: prefix)
+        }
+        RGLockbox.keyIndexLock.unlock()
+        let now = Date()
+        let live = services?.filter({ service in
+            let expiry = RGLockbox.expirations[RGMultiKey(withFirst: service,
+                                                          second: scopeKey.second,
+                                                          third: scopeKey.third)]
+            return expiry == nil || expiry! > now
+        })
+        RGLockbox.valueCacheLock.unlock()
+        return live
+    }
+    
+/**
+ Replaces the index of `scope` with the items of an enumeration unless something was written while it was in flight.
+   Parked writes have not reached the keychain yet and are applied over what it returned.
+ - parameter epoch: The `writeEpoch` from before the enumeration started.
+ - parameter generations: The generation of every bucket of `generationTable` from before the enumeration started.
+ */
+    static func indexEnumeration(_ items:[RGEnumeratedItem?], scope scopeKey:RGMultiKey,
+                                 generations:[Int64]?, since epoch:UInt64) {
+        let now = Date()
+        let services = items.flatMap({ item -> String? in
+            guard let item = item, item.expiry == nil || item.expiry! > now else {
+                return nil
+            }
+            return item.fullKey.first
+        })
+        let index = RGKeyIndex(keys: services)
+        RGLockbox.valueCacheLock.lock()
+        RGLockbox.keyIndexLock.lock()
+        if RGLockbox.writeEpoch == epoch {
+            RGLockbox.deferredWritesLock.lock()
+            for (fullKey, write) in RGLockbox.deferredWrites where RGLockbox.scope(scopeKey, canSee: fullKey) {
+                if write.data != nil {
+                    index.insert(fullKey.first ?? "")
+                } else {
+                    index.remove(fullKey.first ?? "")
+                }
+            }
+            RGLockbox.deferredWritesLock.unlock()
+            RGLockbox.keyIndexScopes[scopeKey] = RGKeyIndexScope(index: index, generations: generations)
+        }
+        RGLockbox.keyIndexLock.unlock()
+        RGLockbox.valueCacheLock.unlock()
+    }
+    
+/**
+ Adds or removes a written item in every index which can see it.  An index spanning more than one account or access
+   group cannot tell whether the same service remains elsewhere, so a removal drops it instead.  Must hold
+   `valueCacheLock`.
+ */
+    static func recordIndexedKey(_ fullKey:RGMultiKey, isPresent:Bool) {
+        RGLockbox.keyIndexLock.lock()
+        for (scopeKey, scope) in RGLockbox.keyIndexScopes where RGLockbox.scope(scopeKey, canSee: fullKey) {
+            if isPresent {
+                scope.index.insert(fullKey.first ?? "")
+            } else if scopeKey.second == fullKey.second && scopeKey.third == fullKey.third {
+                scope.index.remove(fullKey.first ?? "")
+            } else {
+                RGLockbox.keyIndexScopes[scopeKey] = nil
+            }
+        }
+        RGLockbox.keyIndexLock.unlock()
+    }
+    
+/**
+ Drops every index which can see `fullKey`, whose item is no longer known.
+ */
+    static func forgetIndexedKey(_ fullKey:RGMultiKey) {
+        RGLockbox.keyIndexLock.lock()
+        for scopeKey in RGLockbox.keyIndexScopes.keys where RGLockbox.scope(scopeKey, canSee: fullKey) {
+            RGLockbox.keyIndexScopes[scopeKey] = nil
+        }
+        RGLockbox.keyIndexLock.unlock()
+    }
+    
+/**
+ Carries the indexes which can see `fullKey` over a bucket advance made by this process's own write, so they stay
+   current.  Must be called on `keychainQueue`.
+ */
+    static func advanceIndexedGeneration(_ fullKey:RGMultiKey, from generation:Int64, to next:Int64) {
+        guard let table = RGLockbox.generationTable else {
+            return
+        }
+        let bucket = table.bucket(for: fullKey)
+        RGLockbox.keyIndexLock.lock()
+        for (scopeKey, scope) in RGLockbox.keyIndexScopes
+            where RGLockbox.scope(scopeKey, canSee: fullKey)
+            && scope.generations?.count == table.bucketCount && scope.generations![bucket] == generation {
+            scope.generations![bucket] = next
+        }
+        RGLockbox.keyIndexLock.unlock()
+    }
+}
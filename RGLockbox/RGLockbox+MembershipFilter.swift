@@ -0,0 +1,149 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import Security
+
+/**
+ The membership filter of one account and access group and what it was built against.
+ */
+final class RGMembershipScope {
+    let filter:RGBloomFilter
+    
+/**
+ The generation of every bucket of `generationTable` when the filter was built, if there was a table.
+ */
+    let generations:[Int64]?
+    
+    init(filter:RGBloomFilter, generations:[Int64]?) {
+        self.filter = filter
+        self.generations = generations
+    }
+}
+
+/**
+ Reads of keys which do not exist are answered by a Bloom filter of the services visible to a manager's account and
+   access group instead of a keychain round trip.  The filter is built from one attributes-only enumeration the first
+   time a key is missing from `valueCache` and is kept up to date by this process's writes.  When `generationTable` is
+   set a key written by another process since the filter was built is looked up as usual.  Without it such keys would
+   read as absent until `invalidateMembershipFilters()`, so the filter is off by default; enable it when only this
+   process writes the items or when `generationTable` is set.
+ */
+extension RGLockbox {
+    
+/**
+ Whether reads consult the membership filter.  Defaults to `false`.
+ */
+    open static var isMembershipFilterEnabled = false {
+        didSet {
+            RGLockbox.invalidateMembershipFilters()
+        }
+    }
+    
+/**
+ The filters by account and access group, in `second` and `third`.  Guarded by `valueCacheLock`.
+ */
+    static var membershipScopes:[RGMultiKey : RGMembershipScope] = [:]
+    
+/**
+ Forgets every membership filter so they are built again.  Call after items are added to the keychain by means other
+   than `RGLockbox` in this process.
+ */
+    public static func invalidateMembershipFilters() {
+        RGLockbox.valueCacheLock.lock()
+        RGLockbox.membershipScopes.removeAll()
+        RGLockbox.valueCacheLock.unlock()
+    }
+    
+/**
+ - returns: `false` if the item for `fullKey` certainly does not exist.  Builds the filter for its scope if there is
+   none.  Must hold `valueCacheLock`.
+ */
+    static func mayContain(_ fullKey:RGMultiKey) -> Bool {
+        if !RGLockbox.isMembershipFilterEnabled {
+            return true
+        }
+        let scopeKey = RGMultiKey(second: fullKey.second, third: fullKey.third)
+        var scope = RGLockbox.membershipScopes[scopeKey]
+        if scope == nil || scope!.filter.count > scope!.filter.capacity {
+            scope = RGLockbox.buildMembershipScope(scopeKey)
+            RGLockbox.membershipScopes[scopeKey] = scope
+        }
+        guard let builtScope = scope, !builtScope.filter.mayContain(fullKey.first ?? "") else {
+            return true
+        }
+        if let table = RGLockbox.generationTable,
+            builtScope.generations?.count != table.bucketCount
+            || builtScope.generations![table.bucket(for: fullKey)] != table.generation(for: fullKey) {
+            return true
+        }
+        return RGLockbox.deferredWrite(for: fullKey) != nil
+    }
+    
+/**
+ Adds a written item to every filter which can see it.  Must hold `valueCacheLock`.
+ */
+    static func recordMembership(_ fullKey:RGMultiKey) {
+        for (scopeKey, scope) in RGLockbox.membershipScopes
+            where (scopeKey.second == nil || scopeKey.second == fullKey.second)
+            && (scopeKey.third == nil || scopeKey.third == fullKey.third) {
+            scope.filter.insert(fullKey.first ?? "")
+        }
+    }
+    
+/**
+ - returns: A filter of the services in the account and access group of `scopeKey`, `nil` if the keychain could not be
+   enumerated.  Must hold `valueCacheLock`.
+ */
+    static func buildMembershipScope(_ scopeKey:RGMultiKey) -> RGMembershipScope? {
+        var data:AnyObject? = nil
+        var status = errSecSuccess
+        var generations:[Int64]? = nil
+        RGLockbox.enqueueAndWait(execute: {
+            var query:[NSString:AnyObject] = [
+                kSecClass : kSecClassGenericPassword,
+                kSecMatchLimit : kSecMatchLimitAll,
+                kSecReturnAttributes : true as NSNumber,
+                kSecAttrSynchronizable : kSecAttrSynchronizableAny
+            ]
+            query[kSecAttrAccount] = scopeKey.second as NSString?
+            query[kSecAttrAccessGroup] = scopeKey.third as NSString?
+            if let table = RGLockbox.generationTable {
+                generations = (0 ..< table.bucketCount).map({ table.generation(atBucket: $0) })
+            }
+            status = RGLockbox.watchedCopyMatching(query as NSDictionary, &data)
+            RGLogs(.trace, "SecItemCopyMatching with \(query) returned \(status)")
+        })
+        if status != errSecSuccess && status != errSecItemNotFound {
+            return nil
+        }
+        let items = data as? Array<Dictionary<String, Any>> ?? []
+        let filter = RGBloomFilter(capacity: max(2 * items.count, 256))
+        for item in items {
+            if let service = item[kSecAttrService as String] as? String {
+                filter.insert(service)
+            }
+        }
+        return RGMembershipScope(filter: filter, generations: generations)
+    }
+}
@@ -0,0 +1,180 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+
+/**
+ Moving or copying every item of one manager configuration to another.
+ 
+ Items are read with one enumeration, then written in batches of `migrationBatchSize`; each batch writes the destination
+   items, removes the source items, and re-keys `valueCache` in a single hop to `keychainQueue`.  When a progress URL is
+   given, the enumerated keys and the number of keys finished are saved after every batch, so a migration interrupted by
+   termination resumes where it stopped the next time it is started with the same managers and URL.
+ */
+extension RGLockbox {
+    
+/**
+ The number of keys written to the keychain in each step of a migration.
+ */
+    open static var migrationBatchSize = 100
+    
+/**
+ Background migrations run one at a time on this queue.
+ */
+    static let migrationQueue = DispatchQueue(label: "RGLockbox-Migration", qos: .utility)
+    
+/**
+ Identifies the items of this manager in saved migration progress.
+ */
+    var migrationIdentity:String {
+        return [ self.namespace ?? "",
+                 self.accountName ?? "",
+                 self.accessGroup ?? "",
+                 self.itemAccessibility as String,
+                 String(self.isSynchronized),
+                 String(self.isPacked) ].joined(separator: "|")
+    }
+    
+/**
+ Writes every unexpired item of this manager, with its expiry, to `destination`.  Items are rewritten even when the two
+   managers address the same keychain item, so this also changes the accessibility or synchronization of items in place.
+   An item whose removal would also match its new location, e.g. when moving from no account to an account, is removed
+   before it is written rather than after.
+ - parameter destination: The manager which will hold the items.
+ - parameter removingSource: Whether to remove each item from this manager once it is written to `destination`.
+ - parameter progressURL: Where to save progress so that an interrupted migration can resume, `nil` to start over.
+ - returns: The number of items written by this call.
+ */
+    @discardableResult
+    public func migrate(to destination:RGLockbox, removingSource:Bool = true, progressURL:URL? = nil) -> Int {
+        let identity = "\(self.migrationIdentity)>\(destination.migrationIdentity)>\(removingSource)"
+        var keys:[String]
+        var completed = 0
+        if let progress = RGLockbox.migrationProgress(at: progressURL, identity: identity) {
+            keys = progress.keys
+            completed = progress.completed
+            RGLogs(.debug, "resuming migration at \(completed) of \(keys.count)")
+        } else {
+            keys = self.allItems().sorted()
+            RGLockbox.saveMigrationProgress(to: progressURL, identity: identity, keys: keys, completed: 0)
+        }
+        var migrated = 0
+        while completed < keys.count {
+            let batch = keys[completed ..< min(completed + max(RGLockbox.migrationBatchSize, 1), keys.count)]
+            var writes:[(RGLockbox, String, Data?, Date?)] = []
+            var removals:[(RGLockbox, String, Data?, Date?)] = []
+            var overlappingRemovals:[(RGLockbox, String, Data?, Date?)] = []
+            for key in batch {
+                guard let data = self.dataForKey(key) else {
+                    continue
+                }
+                let fullKey = self.fullKey(for: key)
+                RGLockbox.valueCacheLock.lock()
+                let expiry = RGLockbox.expirations[fullKey]
+                RGLockbox.valueCacheLock.unlock()
+                writes.append((destination, key, data, expiry))
+                let destinationKey = destination.fullKey(for: key)
+                if !removingSource || fullKey == destinationKey {
+                    continue
+                }
+                if RGLockbox.query(for: fullKey, matches: destinationKey) {
+                    overlappingRemovals.append((self, key, nil, nil))
+                } else {
+                    removals.append((self, key, nil, nil))
+                }
+            }
+            RGLockbox.storeBatch(overlappingRemovals + writes + removals, policy: .block)
+            if self.isPacked || destination.isPacked {
+                RGLockbox.flushPackedItems()
+            }
+            RGLockbox.keychainQueue.sync(execute: {})
+            completed += batch.count
+            migrated += writes.count
+            RGLockbox.saveMigrationProgress(to: progressURL, identity: identity, keys: keys, completed: completed)
+        }
+        if let url = progressURL {
+            try? FileManager.default.removeItem(at: url)
+        }
+        return migrated
+    }
+    
+/**
+ The keychain treats a missing account or access group as matching any, so the delete of `source` also removes
+   `destination` when it leaves out a component that `destination` sets.  Such deletes must run before the write.
+ - returns: Whether a query for the item `source` also matches the item `destination`.
+ */
+    static func query(for source:RGMultiKey, matches destination:RGMultiKey) -> Bool {
+        return source.first == destination.first
+            && (source.second == nil || source.second == destination.second)
+            && (source.third == nil || source.third == destination.third)
+    }
+    
+/**
+ Runs `migrate(to:removingSource:progressURL:)` on a background queue.
+ - parameter completion: Called on the main queue with the number of items written.
+ */
+    public func migrateInBackground(to destination:RGLockbox,
+                                    removingSource:Bool = true,
+                                    progressURL:URL? = nil,
+                                    completion:((Int) -> Void)? = nil) {
+        RGLockbox.migrationQueue.async(execute: {
+            let migrated = self.migrate(to: destination, removingSource: removingSource, progressURL: progressURL)
+            DispatchQueue.main.async(execute: {
+                completion?(migrated)
+            })
+        })
+    }
+    
+/**
+ - returns: The keys and number of keys finished saved at `url` for the migration described by `identity`.
+ */
+    static func migrationProgress(at url:URL?, identity:String) -> (keys:[String], completed:Int)? {
+        guard let url = url, let data = try? Data(contentsOf: url) else {
+            return nil
+        }
+        let plist = (try? PropertyListSerialization.propertyList(from: data, options: [], format: nil)) as? [String:Any]
+        guard plist?["identity"] as? String == identity,
+              let keys = plist?["keys"] as? [String],
+              let completed = plist?["completed"] as? Int,
+              completed <= keys.count else {
+            return nil
+        }
+        return (keys, completed)
+    }
+    
+/**
+ Saves the progress of a migration to `url` if it is set.
+ */
+    static func saveMigrationProgress(to url:URL?, identity:String, keys:[String], completed:Int) {
+        guard let url = url else {
+            return
+        }
+        let plist:[String:Any] = [ "identity" : identity, "keys" : keys, "completed" : completed ]
+        do {
+            let data = try PropertyListSerialization.data(fromPropertyList: plist, format: .binary, options: 0)
+            try data.write(to: url, options: .atomic)
+        } catch {
+            RGLogs(.error, "unable to save migration progress to \(url) error \(error)")
+        }
+    }
+}
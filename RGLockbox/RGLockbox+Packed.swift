@@ -0,0 +1,406 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import Security
+
+/**
+ One value held in a packed item.
+ */
+struct RGPackedEntry: Equatable {
+    let data:Data
+    let expiry:Date?
+    
+    static func ==(lhs:RGPackedEntry, rhs:RGPackedEntry) -> Bool {
+        return lhs.data == rhs.data && lhs.expiry == rhs.expiry
+    }
+}
+
+/**
+ The in-memory state of one packed item.  Guarded by `valueCacheLock`.
+ */
+final class RGPackedStore {
+    
+/**
+ The entries of the item as last loaded plus every local change.
+ */
+    var entries:[String : RGPackedEntry] = [:]
+    
+/**
+ Entries written and removed since the last flush was enqueued.
+ */
+    var changes:[String : RGPackedEntry] = [:]
+    var removals = Set<String>()
+    
+/**
+ The attributes the packed item is written with.
+ */
+    var accessibility:CFString = kSecAttrAccessibleAfterFirstUnlock
+    var isSynchronized = false
+    
+    var isLoaded = false
+    var isFlushScheduled = false
+    
+    var isDirty:Bool {
+        return !self.changes.isEmpty || !self.removals.isEmpty
+    }
+}
+
+/**
+ Packed managers keep every key of their namespace in a single keychain item so that a cold start costs one keychain
+   read rather than one per key, and a burst of writes costs one keychain update per `packedFlushInterval`.
+ 
+ The item holds a 4 byte magic and a format version followed by an index of entry names, offsets, lengths, and expiries
+   and then the concatenated values.  Flushes re-read the item on `keychainQueue` and apply only the local changes, so
+   writes from managers in other processes between flushes are not lost.
+ 
+ A loaded item is only read again when `generationTable` reports that it changed.  Processes sharing a packed item, such
+   as an app and its extensions using an access group, must share a `generationTable` or they will keep serving what
+   they first loaded; a warning is logged when a packed manager with an access group loads without one.
+ */
+extension RGLockbox {
+    
+/**
+ The service suffix of the packed item of a namespace.
+ */
+    static let packedItemName = "RGLockbox.packed"
+    
+    static let packedMagic:UInt32 = 0x4b504752 // "RGPK"
+    static let packedVersion:UInt8 = 1
+    
+/**
+ How long writes to a packed manager accumulate before they are written to the keychain together.
+ */
+    open static var packedFlushInterval:TimeInterval = 0.05
+    
+/**
+ The loaded packed items by the key of the packed item.  Guarded by `valueCacheLock`.
+ */
+    static var packedStores:[RGMultiKey : RGPackedStore] = [:]
+    
+/**
+ Whether the missing `generationTable` of a shared packed item was reported.  Guarded by `valueCacheLock`.
+ */
+    static var isPackedSharingWarned = false
+    
+/**
+ The key of the keychain item holding this manager's values.
+ */
+    var packedKey:RGMultiKey {
+        let service = self.namespace != nil ? "\(self.namespace!).\(RGLockbox.packedItemName)" : RGLockbox.packedItemName
+        return RGMultiKey(withFirst: service, second: self.accountName, third: self.accessGroup)
+    }
+    
+/**
+ Writes every pending packed change to the keychain and waits for them to complete.
+ */
+    public static func flushPackedItems() {
+        RGLockbox.valueCacheLock.lock()
+        for (packedKey, store) in RGLockbox.packedStores {
+            RGLockbox.enqueuePackedFlush(store, forKey: packedKey)
+        }
+        RGLockbox.valueCacheLock.unlock()
+        RGLockbox.keychainQueue.sync(execute: {})
+    }
+    
+/**
+ Flushes and then forgets every loaded packed item so that the next read of a packed manager loads it again.
+ */
+    public static func discardPackedItems() {
+        RGLockbox.flushPackedItems()
+        RGLockbox.valueCacheLock.lock()
+        RGLockbox.packedStores.removeAll()
+        RGLockbox.valueCacheLock.unlock()
+    }
+    
+/**
+ - returns: The packed item of this manager, loading it with a single keychain read and filling `valueCache` for all of
+   its keys if it is not loaded or was changed by another process.  The local changes not yet flushed, including those
+   made by other threads during the read, are applied over what was read.  If the item cannot be read the store stays
+   unloaded and the next call tries again.  Must hold `valueCacheLock`, which is released while the keychain is read.
+ */
+    func packedStore() -> RGPackedStore {
+        let packedKey = self.packedKey
+        let store = RGLockbox.packedStores[packedKey] ?? RGPackedStore()
+        RGLockbox.packedStores[packedKey] = store
+        if store.isLoaded && (store.isDirty || RGLockbox.isCacheCurrent(packedKey)) {
+            return store
+        }
+        if self.accessGroup != nil && RGLockbox.generationTable == nil && !RGLockbox.isPackedSharingWarned {
+            RGLockbox.isPackedSharingWarned = true
+            RGLogs(.warning, "packed item \(packedKey.first) has an access group but no generationTable")
+        }
+        var status = errSecSuccess
+        var data:Data? = nil
+        RGLockbox.valueCacheLock.unlock()
+        RGLockbox.enqueueAndWait(keys: [ packedKey ], execute: {
+            let generation = RGLockbox.generationTable?.generation(for: packedKey)
+            (status, data) = RGLockbox.readPackedItem(packedKey)
+            RGLockbox.recordGeneration(generation, forKey: packedKey)
+        })
+        RGLockbox.valueCacheLock.lock()
+        if RGLockbox.packedStores[packedKey] !== store {
+            return self.packedStore()
+        }
+        guard let entries = RGLockbox.packedEntries(status: status, data: data) else {
+            RGLogs(.warning, "unable to load \(packedKey.first) with status \(status)")
+            return store
+        }
+        store.entries = entries
+        for name in store.removals {
+            store.entries[name] = nil
+        }
+        for (name, entry) in store.changes {
+            store.entries[name] = entry
+        }
+        store.isLoaded = true
+        for (name, entry) in store.entries {
+            let fullKey = self.fullKey(for: name)
+            RGLockbox.cachedValues[fullKey] = entry.data
+            RGLockbox.trackExpiry(entry.expiry, forKey: fullKey)
+        }
+        return store
+    }
+    
+/**
+ - returns: The live value of `key` from the packed item.  Must hold `valueCacheLock`.
+ */
+    func packedValue(forKey key:String, fullKey:RGMultiKey, range:Range<Int>?) -> Data? {
+        let store = self.packedStore()
+        guard store.isLoaded else {
+            return nil
+        }
+        let entry = store.entries[key]
+        RGLockbox.cachedValues[fullKey] = entry?.data ?? NSNull()
+        RGLockbox.trackExpiry(entry?.expiry, forKey: fullKey)
+        return RGLockbox.liveValue(RGLockbox.cachedValues[fullKey]!, forKey: fullKey, range: range)
+    }
+    
+/**
+ - returns: The unexpired keys of the packed item.
+ */
+    func allPackedItems() -> Array<String> {
+        RGLockbox.valueCacheLock.lock()
+        let now = Date()
+        let store = self.packedStore()
+        let keys = store.entries.filter({ $0.value.expiry == nil || $0.value.expiry! > now }).map({ $0.key })
+        RGLockbox.valueCacheLock.unlock()
+        return keys.sorted()
+    }
+    
+/**
+ Records a write to the packed item and arranges for it to be flushed.  Must hold `valueCacheLock`.
+ */
+    func storePacked(_ data:Data?, forKey key:String, fullKey:RGMultiKey, expiry:Date?) {
+        let store = self.packedStore()
+        RGLockbox.advanceWriteEpoch()
+        RGLockbox.recordAccess(fullKey)
+        let entry = data != nil ? RGPackedEntry(data: data!, expiry: expiry) : nil
+        RGLockbox.cachedValues[fullKey] = data ?? NSNull()
+        RGLockbox.trackExpiry(expiry, forKey: fullKey)
+        if store.isLoaded && store.entries[key] == entry
+            && (store.accessibility as String) == (self.itemAccessibility as String)
+            && store.isSynchronized == self.isSynchronized {
+            RGLockbox.elidedWrites += 1
+            return
+        }
+        store.entries[key] = entry
+        if entry != nil {
+            store.changes[key] = entry
+            store.removals.remove(key)
+        } else {
+            store.changes[key] = nil
+            store.removals.insert(key)
+        }
+        store.accessibility = self.itemAccessibility
+        store.isSynchronized = self.isSynchronized
+        RGLockbox.schedulePackedFlush(store, forKey: self.packedKey, after: RGLockbox.packedFlushInterval)
+    }
+    
+/**
+ Arranges for the pending changes of `store` to be flushed after `delay` unless a flush is already arranged.  Must hold
+   `valueCacheLock`.
+ */
+    static func schedulePackedFlush(_ store:RGPackedStore, forKey packedKey:RGMultiKey, after delay:TimeInterval) {
+        if store.isFlushScheduled {
+            return
+        }
+        store.isFlushScheduled = true
+        DispatchQueue.global(qos: .utility).asyncAfter(deadline: DispatchTime.now() + delay, execute: {
+            RGLockbox.valueCacheLock.lock()
+            RGLockbox.enqueuePackedFlush(store, forKey: packedKey)
+            RGLockbox.valueCacheLock.unlock()
+        })
+    }
+    
+/**
+ Hands the pending changes of `store` to `keychainQueue`.  The flush applies them to the item as it reads it then; if
+   the item cannot be read the changes are handed back to `store` and retried after `deferredWriteRetryInterval`, so
+   they never replace entries the flush could not see.  Must hold `valueCacheLock` so the flush is ordered before any
+   later one.
+ */
+    static func enqueuePackedFlush(_ store:RGPackedStore, forKey packedKey:RGMultiKey) {
+        store.isFlushScheduled = false
+        if !store.isDirty {
+            return
+        }
+        let changes = store.changes
+        let removals = store.removals
+        let accessibility = store.accessibility
+        let isSynchronized = store.isSynchronized
+        store.changes.removeAll()
+        store.removals.removeAll()
+        RGLockbox.enqueue(keys: [ packedKey ], execute: {
+            let (status, data) = RGLockbox.readPackedItem(packedKey)
+            guard var entries = RGLockbox.packedEntries(status: status, data: data) else {
+                RGLogs(.warning, "unable to read \(packedKey.first) with status \(status), retrying the flush later")
+                DispatchQueue.global(qos: .utility).async(execute: {
+                    RGLockbox.valueCacheLock.lock()
+                    RGLockbox.restorePackedChanges(changes, removals: removals, to: store)
+                    RGLockbox.schedulePackedFlush(store, forKey: packedKey, after: RGLockbox.deferredWriteRetryInterval)
+                    RGLockbox.valueCacheLock.unlock()
+                })
+                return
+            }
+            for name in removals {
+                entries[name] = nil
+            }
+            for (name, entry) in changes {
+                entries[name] = entry
+            }
+            let write = RGItemWrite(fullKey: packedKey,
+                                    data: RGLockbox.encodePackedEntries(entries),
+                                    accessibility: accessibility,
+                                    isSynchronized: isSynchronized,
+                                    expiry: nil,
+                                    updatesInPlace: true,
+                                    isReference: false)
+            RGLockbox.perform(write)
+        })
+    }
+    
+/**
+ Hands the changes of a flush which could not run back to `store`, except where a later change superseded them.  Must
+   hold `valueCacheLock`.
+ */
+    static func restorePackedChanges(_ changes:[String : RGPackedEntry], removals:Set<String>, to store:RGPackedStore) {
+        for (name, entry) in changes where store.changes[name] == nil && !store.removals.contains(name) {
+            store.changes[name] = entry
+            store.entries[name] = entry
+        }
+        for name in removals where store.changes[name] == nil && !store.removals.contains(name) {
+            store.removals.insert(name)
+            store.entries[name] = nil
+        }
+    }
+    
+/**
+ - returns: The entries of a packed item read with `status`; empty if it does not exist and `nil` if it could not be
+   read or is malformed.
+ */
+    static func packedEntries(status:OSStatus, data:Data?) -> [String : RGPackedEntry]? {
+        if status == errSecItemNotFound {
+            return [:]
+        } else if status != errSecSuccess || data == nil {
+            return nil
+        }
+        return RGLockbox.decodePackedEntries(data)
+    }
+    
+/**
+ Reads the packed item, preferring a parked write of it.  Must be called on `keychainQueue`.
+ */
+    static func readPackedItem(_ packedKey:RGMultiKey) -> (OSStatus, Data?) {
+        if let pending = RGLockbox.deferredWrite(for: packedKey) {
+            return (errSecSuccess, pending.data)
+        }
+        var query = RGLockbox.itemQuery(packedKey)
+        query[kSecMatchLimit] = kSecMatchLimitOne
+        query[kSecReturnData] = kCFBooleanTrue
+        var data:AnyObject? = nil
+        let status = RGLockbox.watchedCopyMatching(query as NSDictionary, &data)
+        RGLogs(.trace, "SecItemCopyMatching with \(query) returned \(status)")
+        return (status, RGLockbox.decodeValue(data as? Data))
+    }
+    
+/**
+ - returns: The serialized form of `entries`.
+ */
+    static func encodePackedEntries(_ entries:[String : RGPackedEntry]) -> Data {
+        var writer = RGByteWriter()
+        writer.write(RGLockbox.packedMagic)
+        writer.write(RGLockbox.packedVersion)
+        writer.write(UInt32(entries.count))
+        var offset:UInt32 = 0
+        for (name, entry) in entries {
+            writer.write(name)
+            writer.write(offset)
+            writer.write(UInt32(entry.data.count))
+            writer.write(entry.expiry?.timeIntervalSince1970.bitPattern ?? 0)
+            offset += UInt32(entry.data.count)
+        }
+        for entry in entries.values {
+            writer.write(entry.data)
+        }
+        return writer.data
+    }
+    
+/**
+ - returns: The entries serialized in `data`; empty if `data` is `nil` and `nil` if it is malformed.
+ */
+    static func decodePackedEntries(_ data:Data?) -> [String : RGPackedEntry]? {
+        guard let data = data else {
+            return [:]
+        }
+        var reader = RGByteReader(data)
+        guard reader.readUInt32() == RGLockbox.packedMagic,
+              reader.readUInt8() == RGLockbox.packedVersion,
+              let count = reader.readUInt32() else {
+            RGLogs(.error, "packed item is malformed")
+            return nil
+        }
+        var index:[(String, Int, Int, Date?)] = []
+        for _ in 0 ..< Int(count) {
+            guard let name = reader.readString(),
+                  let offset = reader.readUInt32(),
+                  let length = reader.readUInt32(),
+                  let expiry = reader.readUInt64() else {
+                RGLogs(.error, "packed item index is truncated")
+                return nil
+            }
+            let date = expiry != 0 ? Date(timeIntervalSince1970: TimeInterval(bitPattern: expiry)) : nil
+            index.append((name, Int(offset), Int(length), date))
+        }
+        let heap = reader.offset
+        var entries:[String : RGPackedEntry] = [:]
+        for (name, offset, length, expiry) in index {
+            guard heap + offset + length <= data.count else {
+                RGLogs(.error, "packed item value for \(name) is truncated")
+                return nil
+            }
+            let value = data.subdata(in: (heap + offset) ..< (heap + offset + length))
+            entries[name] = RGPackedEntry(data: value, expiry: expiry)
+        }
+        return entries
+    }
+}
@@ -0,0 +1,285 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import Security
+
+/**
+ Rules for dropping entries from `valueCache`.  Pinned keys are never dropped.
+ */
+public enum RGPurgePolicy {
+    
+/**
+ Drop cached misses.
+ */
+    case negatives
+    
+/**
+ Drop values longer than the given number of bytes.
+ */
+    case largerThan(Int)
+    
+/**
+ Drop entries not read or written within the given interval.  Accesses are recorded to the second, and only while
+   `memoryWarningPolicies` or `criticalMemoryPolicies` hold this policy or `warmStartURL` is set; otherwise it drops
+   every entry.
+ */
+    case unusedFor(TimeInterval)
+    
+/**
+ Drop every entry, chunk, and packed item not holding unflushed writes.
+ */
+    case allExceptPinned
+    
+/**
+ - returns: Whether the policy drops `entry`, last used at `lastAccess`.
+ */
+    func matches(_ entry:Any, lastAccess:CFAbsoluteTime?, now:CFAbsoluteTime) -> Bool {
+        switch self {
+        case .negatives:
+            return entry is NSNull
+        case .largerThan(let length):
+            return RGLockbox.payloadSize(entry) > length
+        case .unusedFor(let interval):
+            return lastAccess == nil || now - lastAccess! >= interval
+        case .allExceptPinned:
+            return true
+        }
+    }
+}
+
+/**
+ Shrinking the caches on demand, on memory warnings, and when the process grows past `residentMemoryLimit`.
+ */
+extension RGLockbox {
+    
+/**
+ The policies applied on a memory warning.
+ */
+    open static var memoryWarningPolicies:[RGPurgePolicy] = [ .negatives, .largerThan(4096), .unusedFor(60) ] {
+        didSet {
+            RGLockbox.updateAccessTracking()
+        }
+    }
+    
+/**
+ The policies applied when memory pressure becomes critical.
+ */
+    open static var criticalMemoryPolicies:[RGPurgePolicy] = [ .allExceptPinned ] {
+        didSet {
+            RGLockbox.updateAccessTracking()
+        }
+    }
+    
+/**
+ When set the resident size of the process is checked every `residentMemoryCheckInterval` seconds and
+   `memoryWarningPolicies` are applied whenever it exceeds this many bytes.
+ */
+    open static var residentMemoryLimit:Int? = nil {
+        didSet {
+            RGLockbox.updateResidentMemoryMonitor()
+        }
+    }
+    
+    open static var residentMemoryCheckInterval:TimeInterval = 5
+    
+/**
+ Called after every purge with the number of bytes freed.
+ */
+    open static var purgeObserver:((Int) -> Void)?
+    
+/**
+ When each entry of `valueCache` was last read or written, to the second.  Guarded by `valueCacheLock`.
+ */
+    static var lastAccess:[RGMultiKey : CFAbsoluteTime] = [:]
+    
+/**
+ Whether `recordAccess(_:)` records anything, i.e. whether a configured policy or the warm start file orders entries by
+   recency.  Guarded by `valueCacheLock`.
+ */
+    static var isAccessTracked = true
+    
+/**
+ Keys exempt from purges.  Guarded by `valueCacheLock`.
+ */
+    static var pinnedKeys = Set<RGMultiKey>()
+    
+    static var residentMemoryTimer:DispatchSourceTimer?
+    
+/**
+ Applies `criticalMemoryPolicies` or `memoryWarningPolicies` as the system reports memory pressure.  Resumed once by
+   the first manager.
+ */
+    static let memoryPressureSource:DispatchSourceMemoryPressure = {
+        let source = DispatchSource.makeMemoryPressureSource(eventMask: [ .warning, .critical ],
+                                                             queue: DispatchQueue.global(qos: .utility))
+        source.setEventHandler(handler: {
+            let isCritical = source.data.contains(.critical)
+            RGLockbox.purge(isCritical ? RGLockbox.criticalMemoryPolicies : RGLockbox.memoryWarningPolicies)
+        })
+        return source
+    }()
+    
+/**
+ Exempts `key` from purges.
+ */
+    public func pin(_ key:String) {
+        RGLockbox.valueCacheLock.lock()
+        RGLockbox.pinnedKeys.insert(self.fullKey(for: key))
+        RGLockbox.valueCacheLock.unlock()
+    }
+    
+    public func unpin(_ key:String) {
+        RGLockbox.valueCacheLock.lock()
+        RGLockbox.pinnedKeys.remove(self.fullKey(for: key))
+        RGLockbox.valueCacheLock.unlock()
+    }
+    
+/**
+ Records a read or write of `fullKey` in `lastAccess` if `isAccessTracked`.  Hits within the same second as the last
+   one leave the table untouched.  Must hold `valueCacheLock`.
+ */
+    static func recordAccess(_ fullKey:RGMultiKey) {
+        guard RGLockbox.isAccessTracked else {
+            return
+        }
+        let now = floor(CFAbsoluteTimeGetCurrent())
+        if RGLockbox.lastAccess[fullKey] != now {
+            RGLockbox.lastAccess[fullKey] = now
+        }
+    }
+    
+/**
+ Turns access tracking on while an automatic purge policy or the warm start file uses it, and drops `lastAccess`
+   otherwise.
+ */
+    static func updateAccessTracking() {
+        let usesRecency = (RGLockbox.memoryWarningPolicies + RGLockbox.criticalMemoryPolicies).contains(where: {
+            if case .unusedFor = $0 { return true } else { return false }
+        })
+        RGLockbox.valueCacheLock.lock()
+        RGLockbox.isAccessTracked = usesRecency || RGLockbox.warmStartURL != nil
+        if !RGLockbox.isAccessTracked {
+            RGLockbox.lastAccess.removeAll()
+        }
+        RGLockbox.valueCacheLock.unlock()
+    }
+    
+/**
+ Drops every cache entry matched by `policy`.
+ - returns: The number of bytes freed.
+ */
+    @discardableResult
+    public static func purge(_ policy:RGPurgePolicy) -> Int {
+        return RGLockbox.purge([ policy ])
+    }
+    
+/**
+ Drops every cache entry matched by any of `policies`.
+ - returns: The number of bytes freed.
+ */
+    @discardableResult
+    public static func purge(_ policies:[RGPurgePolicy]) -> Int {
+        let now = CFAbsoluteTimeGetCurrent()
+        var freed = 0
+        RGLockbox.valueCacheLock.lock()
+        var purged:[RGMultiKey] = []
+        for (fullKey, entry) in RGLockbox.cachedValues where !RGLockbox.pinnedKeys.contains(fullKey) {
+            let lastAccess = RGLockbox.lastAccess[fullKey]
+            if policies.contains(where: { $0.matches(entry, lastAccess: lastAccess, now: now) }) {
+                purged.append(fullKey)
+                freed += RGLockbox.payloadSize(entry) + RGLockbox.keySize(fullKey)
+            }
+        }
+        for fullKey in purged {
+            RGLockbox.forgetCachedValue(fullKey)
+        }
+        RGLockbox.invalidateThreadCaches()
+        if policies.contains(where: { if case .allExceptPinned = $0 { return true } else { return false } }) {
+            freed += RGLockbox.chunkCacheBytes
+            RGLockbox.chunkCache.removeAll()
+            RGLockbox.chunkCacheUses.removeAll()
+            RGLockbox.chunkCacheBytes = 0
+            for (packedKey, store) in RGLockbox.packedStores where !store.isDirty && !store.isFlushScheduled {
+                freed += store.entries.reduce(0, { $0 + $1.value.data.count + $1.key.utf8.count })
+                RGLockbox.packedStores[packedKey] = nil
+            }
+        }
+        RGLockbox.valueCacheLock.unlock()
+        RGLogs(.debug, "purged \(purged.count) entries freeing \(freed) bytes")
+        RGLockbox.purgeObserver?(freed)
+        return freed
+    }
+    
+/**
+ - returns: The number of bytes held by a `valueCache` entry.
+ */
+    static func payloadSize(_ entry:Any) -> Int {
+        if let data = entry as? Data {
+            return data.count
+        } else if let reference = entry as? RGValueReference {
+            return reference.data.count
+        }
+        return 0
+    }
+    
+    static func keySize(_ fullKey:RGMultiKey) -> Int {
+        return (fullKey.first?.utf8.count ?? 0) + (fullKey.second?.utf8.count ?? 0) + (fullKey.third?.utf8.count ?? 0)
+    }
+    
+/**
+ The resident size of the process in bytes, `nil` if it cannot be determined.
+ */
+    public static var residentMemorySize:Int? {
+        var info = mach_task_basic_info()
+        var count = mach_msg_type_number_t(MemoryLayout<mach_task_basic_info>.size / MemoryLayout<natural_t>.size)
+        let status = withUnsafeMutablePointer(to: &info, { (pointer) -> kern_return_t in
+            return pointer.withMemoryRebound(to: integer_t.self, capacity: Int(count), {
+                return task_info(mach_task_self_, task_flavor_t(MACH_TASK_BASIC_INFO), $0, &count)
+            })
+        })
+        return status == KERN_SUCCESS ? Int(info.resident_size) : nil
+    }
+    
+/**
+ Starts or stops polling the resident size to match `residentMemoryLimit`.
+ */
+    static func updateResidentMemoryMonitor() {
+        RGLockbox.residentMemoryTimer?.cancel()
+        RGLockbox.residentMemoryTimer = nil
+        guard RGLockbox.residentMemoryLimit != nil else {
+            return
+        }
+        let timer = DispatchSource.makeTimerSource(queue: DispatchQueue.global(qos: .utility))
+        timer.scheduleRepeating(deadline: .now() + RGLockbox.residentMemoryCheckInterval,
+                                interval: RGLockbox.residentMemoryCheckInterval)
+        timer.setEventHandler(handler: {
+            if let limit = RGLockbox.residentMemoryLimit, let size = RGLockbox.residentMemorySize, size > limit {
+                RGLogs(.debug, "resident size \(size) exceeds \(limit), purging")
+                RGLockbox.purge(RGLockbox.memoryWarningPolicies)
+            }
+        })
+        timer.resume()
+        RGLockbox.residentMemoryTimer = timer
+    }
+}
@@ -0,0 +1,178 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+
+/**
+ One block of keychain work waiting to run.
+ */
+final class RGScheduledWork {
+    let sequence:Int
+    
+/**
+ The `qos_class_t` of the caller; larger runs sooner.
+ */
+    let priority:UInt32
+    
+/**
+ The services of the items the work touches, `nil` if it may touch any item.
+ */
+    let services:Set<String>?
+    
+    let enqueued:CFAbsoluteTime
+    let work:() -> Void
+    
+    init(sequence:Int, priority:UInt32, services:Set<String>?, work:@escaping () -> Void) {
+        self.sequence = sequence
+        self.priority = priority
+        self.services = services
+        self.enqueued = CFAbsoluteTimeGetCurrent()
+        self.work = work
+    }
+    
+/**
+ Whether this and `other` must run in the order they were scheduled.
+ */
+    func conflicts(with other:RGScheduledWork) -> Bool {
+        guard let services = self.services, let otherServices = other.services else {
+            return true
+        }
+        return !services.isDisjoint(with: otherServices)
+    }
+}
+
+/**
+ Keychain work is ordered by priority rather than arrival.  Every block scheduled through `enqueue(qos:keys:execute:)`
+   or `enqueueAndWait(keys:execute:)` carries the QoS of its caller and the items it touches, and `keychainQueue` runs
+   the most urgent block first, so an interactive read is not stuck behind background writes of other items.  Work on
+   the same item keeps its order: when the most urgent block must wait for an earlier one, that earlier one runs in its
+   place at the waiter's priority.  Each block dispatched to `keychainQueue` carries its caller's QoS as well, which
+   raises the queue and the thread draining it while urgent work is waiting.
+ 
+ A block dispatched to `keychainQueue` returns only once everything scheduled before it has run, so
+   `keychainQueue.sync(execute: {})` still waits for all earlier work.
+ */
+extension RGLockbox {
+    
+/**
+ Whether urgent work runs first.  When `false` work runs in the order it was scheduled.
+ */
+    open static var isPriorityScheduling = true
+    
+/**
+ The work not yet started in the order it was scheduled.  Guarded by `schedulerLock`.
+ */
+    static var scheduledWork:[RGScheduledWork] = []
+    static var nextScheduledWork = 0
+    
+/**
+ The number of entries of `scheduledWork` at each priority.  Guarded by `schedulerLock`.
+ */
+    static var scheduledPriorities:[UInt32 : Int] = [:]
+    
+/**
+ This lock controls access to the scheduler state above.  It is never held while work runs.
+ */
+    static let schedulerLock = NSLock()
+    
+/**
+ Schedules `work` on `keychainQueue`, recording how long it waits to start.
+ - parameter qos: The priority of the work, by default that of the calling thread.
+ - parameter keys: The items the work reads or writes, `nil` if it may touch any item.
+ */
+    static func enqueue(qos:DispatchQoS = .unspecified, keys:[RGMultiKey]? = nil, execute work:@escaping () -> Void) {
+        let priority = qos.qosClass == .unspecified ? qos_class_self() : qos.qosClass.rawValue
+        let services = keys.map({ Set($0.map({ $0.first ?? "" })) })
+        RGLockbox.schedulePendingWrites(keys)
+        RGLockbox.schedulerLock.lock()
+        let scheduled = RGScheduledWork(sequence: RGLockbox.nextScheduledWork,
+                                        priority: priority.rawValue,
+                                        services: services,
+                                        work: work)
+        RGLockbox.nextScheduledWork += 1
+        RGLockbox.scheduledWork.append(scheduled)
+        RGLockbox.scheduledPriorities[scheduled.priority] = (RGLockbox.scheduledPriorities[scheduled.priority] ?? 0) + 1
+        RGLockbox.watchQueued(scheduled)
+        let blockQoS = DispatchQoS(qosClass: DispatchQoS.QoSClass(rawValue: priority) ?? .default, relativePriority: 0)
+        RGLockbox.keychainQueue.async(qos: blockQoS, execute: {
+            RGLockbox.runScheduledWork(through: scheduled.sequence)
+        })
+        RGLockbox.schedulerLock.unlock()
+    }
+    
+/**
+ Runs `work` on `keychainQueue` at the priority of the calling thread and waits for it.  Unlike
+   `keychainQueue.sync(execute:)` it does not wait for unrelated work scheduled earlier.  Must not be called on
+   `keychainQueue`.
+ - parameter keys: The items the work reads or writes, `nil` if it may touch any item.
+ */
+    static func enqueueAndWait(keys:[RGMultiKey]? = nil, execute work:@escaping () -> Void) {
+        let done = DispatchSemaphore(value: 0)
+        RGLockbox.enqueue(keys: keys, execute: {
+            work()
+            done.signal()
+        })
+        done.wait()
+    }
+    
+/**
+ Runs scheduled work, most urgent first, until everything scheduled up to `sequence` has run.  Called on
+   `keychainQueue` once per scheduled block.
+ */
+    static func runScheduledWork(through sequence:Int) {
+        while true {
+            RGLockbox.schedulerLock.lock()
+            guard let first = RGLockbox.scheduledWork.first, first.sequence <= sequence else {
+                RGLockbox.schedulerLock.unlock()
+                return
+            }
+            let next = RGLockbox.takeNextScheduledWork()
+            RGLockbox.schedulerLock.unlock()
+            RGLockbox.watchStarted(next)
+            next.work()
+        }
+    }
+    
+/**
+ Removes and returns the work to run next: the oldest of the most urgent, or the oldest earlier work it must follow.
+   Must hold `schedulerLock` with `scheduledWork` not empty.
+ */
+    static func takeNextScheduledWork() -> RGScheduledWork {
+        var index = 0
+        if RGLockbox.isPriorityScheduling,
+            let highest = RGLockbox.scheduledPriorities.keys.max(),
+            RGLockbox.scheduledWork[0].priority != highest {
+            index = RGLockbox.scheduledWork.index(where: { $0.priority == highest })!
+            var blocker = index
+            repeat {
+                index = blocker
+                let candidate = RGLockbox.scheduledWork[index]
+                blocker = RGLockbox.scheduledWork[0 ..< index].index(where: { $0.conflicts(with: candidate) }) ?? index
+            } while blocker != index
+        }
+        let next = RGLockbox.scheduledWork.remove(at: index)
+        let remaining = RGLockbox.scheduledPriorities[next.priority]! - 1
+        RGLockbox.scheduledPriorities[next.priority] = remaining > 0 ? remaining : nil
+        return next
+    }
+}
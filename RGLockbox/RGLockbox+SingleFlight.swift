@@ -0,0 +1,118 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+
+/**
+ One in-progress computation of a missing value.  Callers arriving while it runs wait on `group` and share its outcome.
+ */
+final class RGFlight {
+    
+/**
+ Entered on creation and left once `value` or `error` is set.
+ */
+    let group = DispatchGroup()
+    
+/**
+ The computed value when the producer succeeded.
+ */
+    var value:Data?
+    
+/**
+ The error thrown by the producer when it failed.
+ */
+    var error:Error?
+    
+    init() {
+        self.group.enter()
+    }
+    
+/**
+ Waits for the computation to end.
+ - returns: The shared value, or throws the shared error.
+ */
+    func wait() throws -> Data {
+        self.group.wait()
+        if let error = self.error {
+            throw error
+        }
+        return self.value!
+    }
+}
+
+/**
+ Compute-if-absent with single-flight semantics: concurrent callers missing the same key share one computation.
+ */
+extension RGLockbox {
+    
+/**
+ The computation currently running for each key.  Guarded by `flightLock`.
+ */
+    static var flights:[RGMultiKey : RGFlight] = [:]
+    
+/**
+ This lock controls access to `flights`.
+ */
+    static let flightLock = NSLock()
+    
+/**
+ Returns the value of `key`, computing and storing it if absent.  Concurrent callers for the same key wait for a single
+   call of `producer` and all receive its value or its error.  A successful value is written through `setData`.
+ - parameter key: The identifier of the keychain item.
+ - parameter producer: Computes the missing value, for example by refreshing a token from a server.  It must not read
+   or write `key` itself.
+ - returns: The existing or newly computed value.
+ */
+    public func value(forKey key:String, orCompute producer:() throws -> Data) throws -> Data {
+        if let data = self.dataForKey(key) {
+            return data
+        }
+        let fullKey = self.fullKey(for: key)
+        RGLockbox.flightLock.lock()
+        if let flight = RGLockbox.flights[fullKey] {
+            RGLockbox.flightLock.unlock()
+            RGLogs(.trace, "joining computation of \(key)")
+            return try flight.wait()
+        }
+        let flight = RGFlight()
+        RGLockbox.flights[fullKey] = flight
+        RGLockbox.flightLock.unlock()
+        if let data = self.dataForKey(key) {
+            flight.value = data
+        } else {
+            do {
+                let data = try producer()
+                self.setData(data, forKey: key)
+                flight.value = data
+            } catch {
+                RGLogs(.debug, "computation of \(key) failed with \(error)")
+                flight.error = error
+            }
+        }
+        RGLockbox.flightLock.lock()
+        RGLockbox.flights[fullKey] = nil
+        RGLockbox.flightLock.unlock()
+        flight.group.leave()
+        return try flight.wait()
+    }
+}
@@ -0,0 +1,148 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+
+/**
+ One thread's direct mapped cache of values read from `RGLockbox.valueCache`.  Only touched by its own thread.
+ */
+final class RGThreadCache {
+    
+    var keys:[RGMultiKey?]
+    var values:[Data?]
+    
+/**
+ The `threadCacheEpoch` each slot was filled at.
+ */
+    var epochs:[Int64]
+    
+    init(size:Int) {
+        self.keys = [RGMultiKey?](repeating: nil, count: size)
+        self.values = [Data?](repeating: nil, count: size)
+        self.epochs = [Int64](repeating: -1, count: size)
+    }
+}
+
+/**
+ An optional per thread cache in front of `valueCache`.
+ 
+ Hits take no lock: each slot remembers the `threadCacheEpoch` it was filled at, and every write, purge, abandoned
+   write, change to the cache through its methods, or assignment of `generationTable` advances the epoch under
+   `valueCacheLock`, so stale slots on every thread stop matching without any message between threads.  The epoch is
+   read with an atomic load and no lock; a read which races a write may return the value from before the write, as it
+   could with the lock.  Values with an expiry, chunked values, ranged reads, and all reads while `generationTable` is
+   set go to `valueCache`, and hits do not refresh `lastAccess`.
+ */
+extension RGLockbox {
+    
+/**
+ Whether reads are served from a per thread cache first.  Off by default.
+ */
+    open static var isThreadCacheEnabled = false {
+        didSet {
+            RGLockbox.valueCacheLock.lock()
+            RGLockbox.invalidateThreadCaches()
+            RGLockbox.valueCacheLock.unlock()
+        }
+    }
+    
+/**
+ The number of slots in each thread's cache; a power of 2.
+ */
+    static let threadCacheSize = 32
+    
+/**
+ Advanced under `valueCacheLock` whenever a cached value may change; read atomically without it.
+ */
+    static let threadCacheEpoch:UnsafeMutablePointer<Int64> = {
+        let epoch = UnsafeMutablePointer<Int64>.allocate(capacity: 1)
+        epoch.initialize(to: 0)
+        return epoch
+    }()
+    
+    static let threadCacheKey:pthread_key_t = {
+        var key = pthread_key_t()
+        pthread_key_create(&key, { pointer in
+            Unmanaged<RGThreadCache>.fromOpaque(pointer).release()
+        })
+        return key
+    }()
+    
+/**
+ - returns: The calling thread's cache, created on first use and released when the thread exits.
+ */
+    static func threadCache() -> RGThreadCache {
+        if let pointer = pthread_getspecific(RGLockbox.threadCacheKey) {
+            return Unmanaged<RGThreadCache>.fromOpaque(pointer).takeUnretainedValue()
+        }
+        let cache = RGThreadCache(size: RGLockbox.threadCacheSize)
+        pthread_setspecific(RGLockbox.threadCacheKey, Unmanaged.passRetained(cache).toOpaque())
+        return cache
+    }
+    
+    static func threadCacheSlot(_ fullKey:RGMultiKey) -> Int {
+        return Int(truncatingBitPattern: fullKey.stableHash) & (RGLockbox.threadCacheSize - 1)
+    }
+    
+/**
+ - returns: The value of `fullKey` in the calling thread's cache, which may be `nil` for a cached absence; `nil` on a
+   miss.
+ */
+    static func threadCachedValue(for fullKey:RGMultiKey) -> Data?? {
+        guard RGLockbox.isThreadCacheEnabled else {
+            return nil
+        }
+        let cache = RGLockbox.threadCache()
+        let slot = RGLockbox.threadCacheSlot(fullKey)
+        guard cache.epochs[slot] == OSAtomicAdd64Barrier(0, RGLockbox.threadCacheEpoch),
+              let key = cache.keys[slot],
+              key == fullKey else {
+            return nil
+        }
+        return .some(cache.values[slot])
+    }
+    
+/**
+ Copies a `valueCache` entry to the calling thread's cache if it can be served from there.  Must hold `valueCacheLock`.
+ */
+    static func fillThreadCache(_ entry:Any, forKey fullKey:RGMultiKey) {
+        guard RGLockbox.isThreadCacheEnabled,
+              RGLockbox.generationTable == nil,
+              RGLockbox.expirations[fullKey] == nil,
+              entry is Data || entry is NSNull else {
+            return
+        }
+        let cache = RGLockbox.threadCache()
+        let slot = RGLockbox.threadCacheSlot(fullKey)
+        cache.keys[slot] = fullKey
+        cache.values[slot] = entry as? Data
+        cache.epochs[slot] = OSAtomicAdd64Barrier(0, RGLockbox.threadCacheEpoch)
+    }
+    
+/**
+ Makes every thread's cache miss.  Must hold `valueCacheLock`.
+ */
+    static func invalidateThreadCaches() {
+        OSAtomicIncrement64Barrier(RGLockbox.threadCacheEpoch)
+    }
+}
@@ -0,0 +1,323 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import Security
+
+/**
+ A persistent copy of `valueCache` which fills it at launch without reading each item from the keychain.
+ 
+ The file at `warmStartURL` holds cached values with the modification date of their item, encrypted with AES-256 in
+   counter mode and authenticated with HMAC-SHA-256 under a random key kept in its own keychain item.  Loading maps the
+   file, reads the key, and enumerates the attributes of the items without their data, which needs no decryption by the
+   keychain; a value is only used while its item still has the saved modification date, so anything written elsewhere
+   since falls through to the keychain.  Values with an expiry, chunked values, packed values, and pending writes are
+   not saved.
+ 
+ The file is written with complete file protection and its key is only readable while the device is unlocked, so the
+   values are never available in a state their items might not be.
+ */
+extension RGLockbox {
+    
+/**
+ Where the warm start cache is kept, `nil` to disable it.  Setting it loads the cache; it is saved when the application
+   leaves the foreground and by `saveWarmStartCache()`.
+ */
+    open static var warmStartURL:URL? {
+        didSet {
+            RGLockbox.updateAccessTracking()
+            if RGLockbox.warmStartURL != nil {
+                RGLockbox.loadWarmStartCache()
+            }
+        }
+    }
+    
+/**
+ The most value bytes saved, most recently used first.
+ */
+    open static var warmStartByteLimit = 512 * 1024
+    
+/**
+ The service of the keychain item holding the warm start key.
+ */
+    static let warmStartItemName = "RGLockbox.warmstart"
+    static let warmStartMagic:UInt32 = 0x574c4752 // "RGLW"
+    static let warmStartVersion:UInt8 = 1
+    static let warmStartHeaderLength = 17
+    static let warmStartTagLength = 32
+    
+/**
+ Fills `valueCache` from the warm start cache with every value whose item is unchanged since it was saved.  Values
+   already cached are kept.
+ - returns: The number of values loaded.
+ */
+    @discardableResult
+    public static func loadWarmStartCache() -> Int {
+        guard let url = RGLockbox.warmStartURL,
+              let file = try? Data(contentsOf: url, options: .alwaysMapped),
+              file.count >= RGLockbox.warmStartHeaderLength + RGLockbox.warmStartTagLength else {
+            return 0
+        }
+        var key:[UInt8]? = nil
+        RGLockbox.enqueueAndWait(execute: {
+            key = RGLockbox.warmStartKey(creating: false)
+        })
+        guard let records = RGLockbox.decodeWarmStart([UInt8](file), key: key) else {
+            RGLogs(.warning, "discarding unreadable warm start cache at \(url)")
+            try? FileManager.default.removeItem(at: url)
+            return 0
+        }
+        var dates:[RGMultiKey : [String : Date]] = [:]
+        RGLockbox.enqueueAndWait(execute: {
+            for scope in Set(records.map({ RGMultiKey(second: $0.fullKey.second, third: $0.fullKey.third) })) {
+                dates[scope] = RGLockbox.modificationDates(scope)
+            }
+        })
+        var loaded = 0
+        RGLockbox.valueCacheLock.lock()
+        for record in records where RGLockbox.cachedValues[record.fullKey] == nil {
+            let scope = RGMultiKey(second: record.fullKey.second, third: record.fullKey.third)
+            if dates[scope]?[record.fullKey.first!] == record.modified {
+                RGLockbox.cachedValues[record.fullKey] = record.data
+                loaded += 1
+            }
+        }
+        RGLockbox.valueCacheLock.unlock()
+        RGLogs(.debug, "loaded \(loaded) of \(records.count) warm start values")
+        return loaded
+    }
+    
+/**
+ Writes the most recently used values of `valueCache` to `warmStartURL` once every pending write has reached the
+   keychain.  Modification dates are read before the values are copied so a value written in between is saved with
+   the date of the item it replaced and is not loaded.
+ */
+    public static func saveWarmStartCache() {
+        guard let url = RGLockbox.warmStartURL else {
+            return
+        }
+        RGLockbox.valueCacheLock.lock()
+        let scopes = Set(RGLockbox.cachedValues.keys.map({ RGMultiKey(second: $0.second, third: $0.third) }))
+        RGLockbox.valueCacheLock.unlock()
+        var key:[UInt8]? = nil
+        var dates:[RGMultiKey : [String : Date]] = [:]
+        RGLockbox.enqueueAndWait(execute: {
+            key = RGLockbox.warmStartKey(creating: true)
+            for scope in scopes {
+                dates[scope] = RGLockbox.modificationDates(scope)
+            }
+        })
+        guard let encryptionKey = key else {
+            RGLogs(.warning, "unable to create the warm start key")
+            return
+        }
+        RGLockbox.valueCacheLock.lock()
+        var candidates:[(fullKey:RGMultiKey, data:Data, modified:Date, used:CFAbsoluteTime)] = []
+        for (fullKey, entry) in RGLockbox.cachedValues {
+            let scope = RGMultiKey(second: fullKey.second, third: fullKey.third)
+            guard let data = entry as? Data,
+                  let service = fullKey.first,
+                  let modified = dates[scope]?[service],
+                  RGLockbox.expirations[fullKey] == nil else {
+                continue
+            }
+            candidates.append((fullKey, data, modified, RGLockbox.lastAccess[fullKey] ?? 0))
+        }
+        RGLockbox.valueCacheLock.unlock()
+        candidates.sort(by: { $0.used > $1.used })
+        var records:[(fullKey:RGMultiKey, data:Data, modified:Date)] = []
+        var bytes = 0
+        for candidate in candidates where RGLockbox.deferredWrite(for: candidate.fullKey) == nil {
+            if bytes + candidate.data.count > RGLockbox.warmStartByteLimit {
+                break
+            }
+            bytes += candidate.data.count
+            records.append((candidate.fullKey, candidate.data, candidate.modified))
+        }
+        guard let file = RGLockbox.encodeWarmStart(records, key: encryptionKey) else {
+            RGLogs(.warning, "unable to generate a warm start nonce")
+            return
+        }
+        do {
+            try file.write(to: url, options: RGLockbox.protectedWritingOptions)
+        } catch {
+            RGLogs(.error, "unable to save warm start cache to \(url) error \(error)")
+        }
+    }
+    
+/**
+ Atomic writes readable only while the device is unlocked where the system supports file protection.
+ */
+    static var protectedWritingOptions:Data.WritingOptions {
+        #if os(iOS) || os(tvOS) || os(watchOS)
+            return [ .atomic, .completeFileProtection ]
+        #else
+            return .atomic
+        #endif
+    }
+    
+/**
+ - returns: The warm start key, generated and stored first if `creating` and there is none.  Must be called on
+   `keychainQueue`.
+ */
+    static func warmStartKey(creating:Bool) -> [UInt8]? {
+        var query = RGLockbox.itemQuery(RGMultiKey(withFirst: RGLockbox.warmStartItemName))
+        query[kSecMatchLimit] = kSecMatchLimitOne
+        query[kSecReturnData] = true as NSNumber
+        var data:AnyObject? = nil
+        let status = RGLockbox.watchedCopyMatching(query as NSDictionary, &data)
+        if let data = data as? Data, data.count == 32 {
+            return [UInt8](data)
+        }
+        guard creating && status == errSecItemNotFound else {
+            return nil
+        }
+        var key = [UInt8](repeating: 0, count: 32)
+        guard SecRandomCopyBytes(kSecRandomDefault, key.count, &key) == 0 else {
+            return nil
+        }
+        var item = RGLockbox.itemQuery(RGMultiKey(withFirst: RGLockbox.warmStartItemName))
+        item[kSecAttrSynchronizable] = nil
+        item[kSecAttrAccessible] = kSecAttrAccessibleWhenUnlockedThisDeviceOnly
+        item[kSecValueData] = Data(bytes: key) as NSData
+        return RGLockbox.watchedAdd(item as NSDictionary) == errSecSuccess ? key : nil
+    }
+    
+/**
+ - returns: The modification date of every item in `scope` by service, read without item data.  Must be called on
+   `keychainQueue`.
+ */
+    static func modificationDates(_ scope:RGMultiKey) -> [String : Date] {
+        var query:[NSString:AnyObject] = [
+            kSecClass : kSecClassGenericPassword,
+            kSecMatchLimit : kSecMatchLimitAll,
+            kSecReturnAttributes : true as NSNumber,
+            kSecAttrSynchronizable : kSecAttrSynchronizableAny
+        ]
+        query[kSecAttrAccount] = scope.second as NSString?
+        query[kSecAttrAccessGroup] = scope.third as NSString?
+        var data:AnyObject? = nil
+        let status = RGLockbox.watchedCopyMatching(query as NSDictionary, &data)
+        RGLogs(.trace, "SecItemCopyMatching of attributes with \(query) returned \(status)")
+        var dates:[String : Date] = [:]
+        for case let item as [String : Any] in (data as? NSArray) ?? [] {
+            if let service = item[kSecAttrService as String] as? String,
+               let modified = item[kSecAttrModificationDate as String] as? Date {
+                dates[service] = modified
+            }
+        }
+        return dates
+    }
+    
+/**
+ - returns: Independent encryption and authentication keys derived from the warm start key.
+ */
+    static func warmStartKeys(_ key:[UInt8]) -> (encryption:[UInt8], authentication:[UInt8]) {
+        return (RGHMAC.authenticate([UInt8]("RGLockbox.warmstart.encryption".utf8), key: key),
+                RGHMAC.authenticate([UInt8]("RGLockbox.warmstart.authentication".utf8), key: key))
+    }
+    
+/**
+ Lays out the file as a magic, a version, and a nonce, then the encrypted records, then an HMAC of all before it.  Each
+   record is the three components of its key, the modification date, and the 32-bit length prefixed value.
+ */
+    static func encodeWarmStart(_ records:[(fullKey:RGMultiKey, data:Data, modified:Date)], key:[UInt8]) -> Data? {
+        var nonce = [UInt8](repeating: 0, count: 12)
+        let keys = RGLockbox.warmStartKeys(key)
+        guard SecRandomCopyBytes(kSecRandomDefault, nonce.count, &nonce) == 0,
+              let cipher = RGCipher(key: keys.encryption, nonce: nonce) else {
+            return nil
+        }
+        var body = RGByteWriter()
+        body.write(UInt32(records.count))
+        for record in records {
+            for component in [ record.fullKey.first, record.fullKey.second, record.fullKey.third ] {
+                body.write(UInt8(component != nil ? 1 : 0))
+                body.write(component ?? "")
+            }
+            body.write(record.modified.timeIntervalSinceReferenceDate.bitPattern)
+            body.write(UInt32(record.data.count))
+            body.write(record.data)
+        }
+        var ciphertext = body.bytes
+        cipher.apply(&ciphertext)
+        var file = RGByteWriter()
+        file.write(RGLockbox.warmStartMagic)
+        file.write(RGLockbox.warmStartVersion)
+        file.write(nonce)
+        file.write(ciphertext)
+        let tag = RGHMAC.authenticate(file.bytes, key: keys.authentication)
+        file.write(tag)
+        return file.data
+    }
+    
+/**
+ - returns: The records of an authentic warm start file, `nil` if it is damaged, foreign, or `key` is missing.
+ */
+    static func decodeWarmStart(_ bytes:[UInt8], key:[UInt8]?) -> [(fullKey:RGMultiKey, data:Data, modified:Date)]? {
+        guard let key = key else {
+            return nil
+        }
+        var reader = RGByteReader(bytes)
+        guard reader.readUInt32() == RGLockbox.warmStartMagic,
+              reader.readUInt8() == RGLockbox.warmStartVersion,
+              let nonce = reader.readBytes(12) else {
+            return nil
+        }
+        let bodyEnd = bytes.count - RGLockbox.warmStartTagLength
+        let keys = RGLockbox.warmStartKeys(key)
+        let tag = RGHMAC.authenticate([UInt8](bytes[0 ..< bodyEnd]), key: keys.authentication)
+        guard RGHMAC.isEqual(tag, [UInt8](bytes[bodyEnd ..< bytes.count])) else {
+            return nil
+        }
+        guard let cipher = RGCipher(key: keys.encryption, nonce: nonce) else {
+            return nil
+        }
+        var body = [UInt8](bytes[RGLockbox.warmStartHeaderLength ..< bodyEnd])
+        cipher.apply(&body)
+        reader = RGByteReader(body)
+        guard let count = reader.readUInt32() else {
+            return nil
+        }
+        var records:[(fullKey:RGMultiKey, data:Data, modified:Date)] = []
+        for _ in 0 ..< count {
+            var components:[String?] = []
+            for _ in 0 ..< 3 {
+                guard let isPresent = reader.readUInt8(), let component = reader.readString() else {
+                    return nil
+                }
+                components.append(isPresent != 0 ? component : nil)
+            }
+            guard components[0] != nil,
+                  let modified = reader.readUInt64(),
+                  let length = reader.readUInt32(),
+                  let data = reader.readData(Int(length)) else {
+                return nil
+            }
+            records.append((RGMultiKey(withFirst: components[0], second: components[1], third: components[2]),
+                            data,
+                            Date(timeIntervalSinceReferenceDate: TimeInterval(bitPattern: modified))))
+        }
+        return records
+    }
+}
@@ -0,0 +1,281 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+import Security
+
+/**
+ The kind of work reported by the watchdog.
+ */
+public enum RGKeychainOperation {
+    
+/**
+ A call to `rg_SecItemCopyMatch`.
+ */
+    case copyMatching
+    
+/**
+ A call to `rg_SecItemAdd`.
+ */
+    case add
+    
+/**
+ A call to `rg_SecItemUpdate`.
+ */
+    case update
+    
+/**
+ A call to `rg_SecItemDelete`.
+ */
+    case delete
+    
+/**
+ A block which waited on `keychainQueue` before it started.
+ */
+    case queueWait
+    
+/**
+ Work is outstanding on `keychainQueue` but nothing has started or finished.  Reported while the stall lasts.
+ */
+    case queueStall
+}
+
+/**
+ An operation which took at least `RGLockbox.slowOperationThreshold`.
+ */
+public struct RGSlowOperation {
+    
+    public let operation:RGKeychainOperation
+    
+/**
+ The `RGMultiKey.stableHash` of the item, `nil` for enumerations and queue reports.
+ */
+    public let keyHash:UInt64?
+    
+    public let elapsed:TimeInterval
+    
+/**
+ The number of blocks waiting on `keychainQueue` when the report was made.
+ */
+    public let queueDepth:Int
+}
+
+/**
+ Timing of keychain calls and of `keychainQueue`.
+ 
+ Every backend call goes through one of the `watched` functions, which timestamp it, and every block of work goes
+   through `enqueue(qos:keys:execute:)`, which timestamps it and counts it towards the queue depth.  Slow calls and long
+   waits are reported when they finish; while `slowOperationObserver` is set a timer also reports a queue whose head has
+   not moved for `slowOperationThreshold`, so a call which never returns is still seen.
+ */
+extension RGLockbox {
+    
+/**
+ Calls, waits, and stalls at least this long are reported to `slowOperationObserver`.
+ */
+    open static var slowOperationThreshold:TimeInterval = 1 {
+        didSet {
+            RGLockbox.updateWatchdog()
+        }
+    }
+    
+/**
+ Called on a private queue with every slow operation.
+ */
+    open static var slowOperationObserver:((RGSlowOperation) -> Void)? {
+        didSet {
+            RGLockbox.updateWatchdog()
+        }
+    }
+    
+/**
+ The number of blocks waiting to start on `keychainQueue`.
+ */
+    public static var queueDepth:Int {
+        RGLockbox.watchdogLock.lock()
+        defer {
+            RGLockbox.watchdogLock.unlock()
+        }
+        return RGLockbox.queuedBlocks.count
+    }
+    
+/**
+ This lock controls access to the watchdog state below.  It is a leaf and is never held while calling out.
+ */
+    static let watchdogLock = NSLock()
+    static let watchdogQueue = DispatchQueue(label: "RGLockbox-Watchdog")
+    static var watchdogTimer:DispatchSourceTimer?
+    
+/**
+ When each waiting block was enqueued, by sequence number.
+ */
+    static var queuedBlocks:[Int : CFAbsoluteTime] = [:]
+    
+/**
+ The backend call running now, if any.
+ */
+    static var callInFlight:(operation:RGKeychainOperation, keyHash:UInt64?, start:CFAbsoluteTime)?
+    
+/**
+ When a block last started or a call last finished, and how many times that has happened.
+ */
+    static var lastQueueProgress:CFAbsoluteTime = 0
+    static var queueProgressCount = 0
+    static var reportedStallProgress = -1
+    
+/**
+ Counts `scheduled` towards the queue depth until it starts.
+ */
+    static func watchQueued(_ scheduled:RGScheduledWork) {
+        RGLockbox.watchdogLock.lock()
+        RGLockbox.queuedBlocks[scheduled.sequence] = scheduled.enqueued
+        RGLockbox.watchdogLock.unlock()
+    }
+    
+/**
+ Records that `scheduled` is starting on `keychainQueue`, reporting it if it waited too long.
+ */
+    static func watchStarted(_ scheduled:RGScheduledWork) {
+        let started = CFAbsoluteTimeGetCurrent()
+        RGLockbox.watchdogLock.lock()
+        RGLockbox.queuedBlocks[scheduled.sequence] = nil
+        RGLockbox.recordQueueProgress(started)
+        let depth = RGLockbox.queuedBlocks.count
+        RGLockbox.watchdogLock.unlock()
+        if started - scheduled.enqueued >= RGLockbox.slowOperationThreshold {
+            RGLockbox.reportSlowOperation(RGSlowOperation(operation: .queueWait,
+                                                          keyHash: nil,
+                                                          elapsed: started - scheduled.enqueued,
+                                                          queueDepth: depth))
+        }
+    }
+    
+    static func watchedCopyMatching(_ query:NSDictionary, _ result:UnsafeMutablePointer<CFTypeRef?>?) -> OSStatus {
+        return RGLockbox.watched(.copyMatching, query, { rg_SecItemCopyMatch(query, result) })
+    }
+    
+    static func watchedAdd(_ query:NSDictionary) -> OSStatus {
+        return RGLockbox.watched(.add, query, { rg_SecItemAdd(query) })
+    }
+    
+    static func watchedUpdate(_ query:NSDictionary, _ attributes:NSDictionary) -> OSStatus {
+        return RGLockbox.watched(.update, query, { rg_SecItemUpdate(query, attributes) })
+    }
+    
+    static func watchedDelete(_ query:NSDictionary) -> OSStatus {
+        return RGLockbox.watched(.delete, query, { rg_SecItemDelete(query) })
+    }
+    
+/**
+ Runs a backend call, reporting it if it is slow.
+ - parameter query: The query of the call, used to hash the key of the item.
+ */
+    static func watched(_ operation:RGKeychainOperation, _ query:NSDictionary, _ call:() -> OSStatus) -> OSStatus {
+        var keyHash:UInt64? = nil
+        if let service = query[kSecAttrService] as? String {
+            keyHash = RGMultiKey(withFirst: service,
+                                 second: query[kSecAttrAccount] as? String,
+                                 third: query[kSecAttrAccessGroup] as? String).stableHash
+        }
+        let start = CFAbsoluteTimeGetCurrent()
+        RGLockbox.watchdogLock.lock()
+        RGLockbox.callInFlight = (operation, keyHash, start)
+        RGLockbox.watchdogLock.unlock()
+        let status = call()
+        let end = CFAbsoluteTimeGetCurrent()
+        RGLockbox.watchdogLock.lock()
+        RGLockbox.callInFlight = nil
+        RGLockbox.recordQueueProgress(end)
+        let depth = RGLockbox.queuedBlocks.count
+        RGLockbox.watchdogLock.unlock()
+        if end - start >= RGLockbox.slowOperationThreshold {
+            RGLockbox.reportSlowOperation(RGSlowOperation(operation: operation,
+                                                          keyHash: keyHash,
+                                                          elapsed: end - start,
+                                                          queueDepth: depth))
+        }
+        return status
+    }
+    
+/**
+ Must hold `watchdogLock`.
+ */
+    static func recordQueueProgress(_ time:CFAbsoluteTime) {
+        RGLockbox.lastQueueProgress = time
+        RGLockbox.queueProgressCount += 1
+    }
+    
+    static func reportSlowOperation(_ report:RGSlowOperation) {
+        RGLogs(.warning, "slow keychain operation \(report.operation) took \(report.elapsed)s")
+        RGLockbox.watchdogQueue.async(execute: {
+            RGLockbox.slowOperationObserver?(report)
+        })
+    }
+    
+/**
+ Reports a stall if work is outstanding and the queue head has not moved since the later of the last progress and the
+   oldest outstanding work.  Each stall is reported once.
+ */
+    static func checkForStall() {
+        let now = CFAbsoluteTimeGetCurrent()
+        RGLockbox.watchdogLock.lock()
+        var oldest = RGLockbox.queuedBlocks.values.min()
+        if let call = RGLockbox.callInFlight {
+            oldest = min(oldest ?? call.start, call.start)
+        }
+        var report:RGSlowOperation? = nil
+        if let oldest = oldest, RGLockbox.reportedStallProgress != RGLockbox.queueProgressCount {
+            let elapsed = now - max(oldest, RGLockbox.lastQueueProgress)
+            if elapsed >= RGLockbox.slowOperationThreshold {
+                RGLockbox.reportedStallProgress = RGLockbox.queueProgressCount
+                report = RGSlowOperation(operation: .queueStall,
+                                         keyHash: RGLockbox.callInFlight?.keyHash,
+                                         elapsed: elapsed,
+                                         queueDepth: RGLockbox.queuedBlocks.count)
+            }
+        }
+        RGLockbox.watchdogLock.unlock()
+        if let report = report {
+            RGLockbox.reportSlowOperation(report)
+        }
+    }
+    
+/**
+ Starts or stops the stall timer to match `slowOperationObserver`.
+ */
+    static func updateWatchdog() {
+        RGLockbox.watchdogTimer?.cancel()
+        RGLockbox.watchdogTimer = nil
+        guard RGLockbox.slowOperationObserver != nil else {
+            return
+        }
+        let interval = max(RGLockbox.slowOperationThreshold / 4, 0.01)
+        let timer = DispatchSource.makeTimerSource(queue: RGLockbox.watchdogQueue)
+        timer.scheduleRepeating(deadline: .now() + interval, interval: interval)
+        timer.setEventHandler(handler: {
+            RGLockbox.checkForStall()
+        })
+        timer.resume()
+        RGLockbox.watchdogTimer = timer
+    }
+}
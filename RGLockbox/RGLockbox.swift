@@ -39,6 +39,11 @@ public var rg_SecItemAdd = { SecItemAdd($0, nil) }
  */
 public var rg_SecItemDelete = { SecItemDelete($0) }
 
+/**
+ block used to update an existing item in the keychain.  Defaults to `SecItemUpdate`.
+ */
+public var rg_SecItemUpdate = { SecItemUpdate($0, $1) }
+
 #if os(iOS) || os(tvOS)
     import UIKit
 
@@ -56,6 +61,18 @@ public var rg_SecItemDelete = { SecItemDelete($0) }
  Notification that should be posted when the app will be terminated.
  */
     public let RGApplicationWillTerminate:NSNotification.Name = NSNotification.Name.UIApplicationWillTerminate
+
+/**
+ Notification that should be posted when protected data becomes available after the device unlocks.
+ */
+    public let RGApplicationProtectedDataDidBecomeAvailable:NSNotification.Name =
+        NSNotification.Name.UIApplicationProtectedDataDidBecomeAvailable
+
+/**
+ Notification that should be posted when the system asks the app to free memory.
+ */
+    public let RGApplicationDidReceiveMemoryWarning:NSNotification.Name =
+        NSNotification.Name.UIApplicationDidReceiveMemoryWarning
 #elseif os(watchOS)
     
 /**
@@ -75,6 +92,18 @@ public var rg_SecItemDelete = { SecItemDelete($0) }
  */
     public let RGApplicationWillTerminate:NSNotification.Name =
         Notification.Name(rawValue: "UIApplicationWillTerminateNotification")
+    
+/**
+ Notification that should be posted when protected data becomes available after the device unlocks.
+ */
+    public let RGApplicationProtectedDataDidBecomeAvailable:NSNotification.Name =
+        Notification.Name(rawValue: "UIApplicationProtectedDataDidBecomeAvailable")
+    
+/**
+ Notification that should be posted when the system asks the app to free memory.
+ */
+    public let RGApplicationDidReceiveMemoryWarning:NSNotification.Name =
+        Notification.Name(rawValue: "UIApplicationDidReceiveMemoryWarningNotification")
 #elseif os(OSX)
     
 /**
@@ -94,6 +123,18 @@ public var rg_SecItemDelete = { SecItemDelete($0) }
  */
     public let RGApplicationWillTerminate:Notification.Name =
         Notification.Name(rawValue: "NSApplicationWillTerminateNotification")
+    
+/**
+ Notification that should be posted when protected data becomes available after the device unlocks.
+ */
+    public let RGApplicationProtectedDataDidBecomeAvailable:Notification.Name =
+        Notification.Name(rawValue: "RGApplicationProtectedDataDidBecomeAvailable")
+    
+/**
+ Notification that should be posted when the system asks the app to free memory.
+ */
+    public let RGApplicationDidReceiveMemoryWarning:Notification.Name =
+        Notification.Name(rawValue: "RGApplicationDidReceiveMemoryWarning")
 #else
     
 /**
@@ -113,8 +154,37 @@ public var rg_SecItemDelete = { SecItemDelete($0) }
  */
     public let RGApplicationWillTerminate:NSNotification.Name =
         Notification.Name(rawValue: "RGApplicationWillTerminate")
+    
+/**
+ Notification that should be posted when protected data becomes available after the device unlocks.
+ */
+    public let RGApplicationProtectedDataDidBecomeAvailable:NSNotification.Name =
+        Notification.Name(rawValue: "RGApplicationProtectedDataDidBecomeAvailable")
+    
+/**
+ Notification that should be posted when the system asks the app to free memory.
+ */
+    public let RGApplicationDidReceiveMemoryWarning:NSNotification.Name =
+        Notification.Name(rawValue: "RGApplicationDidReceiveMemoryWarning")
 #endif
 
+/**
+ A fully described replacement of one keychain item; `data` of `nil` removes the item.
+ */
+struct RGItemWrite {
+    let fullKey:RGMultiKey
+    let data:Data?
+    let accessibility:CFString
+    let isSynchronized:Bool
+    let expiry:Date?
+    let updatesInPlace:Bool
+    
+/**
+ Whether `data` is a chunk manifest or envelope, marked on the item by `RGLockbox.referenceItemType`.
+ */
+    let isReference:Bool
+}
+
 /**
  Instances of RGLockbox manage access to a given keychain service name, account, and/or access group.
    The default service name is your app's bundle identifier with the rest `nil`.  A given manager is threadsafe.
@@ -122,7 +192,8 @@ public var rg_SecItemDelete = { SecItemDelete($0) }
 open class RGLockbox {
 
 /**
- Globally, all keychain accesses are performed on this queue to keep the cache in sync with the backing store.
+ Globally, all keychain accesses are performed on this queue to keep the cache in sync with the backing store.  Work is
+   scheduled onto it by priority; see `RGLockbox+Scheduler.swift`.
  */
     open static let keychainQueue = DispatchQueue(label: "RGLockbox-Sync")
     
@@ -131,15 +202,123 @@ open class RGLockbox {
  */
     static let valueCacheLock = NSLock()
     
+/**
+ Striped locks ordering the writers of each key; a key always maps to the same lock.  Always acquired before
+   `valueCacheLock`.
+ */
+    static let keyLocks:[NSLock] = (0..<64).map({ _ in NSLock() })
+    
 /**
  Your app's bundle identifier pre-calculated; it is `nil` if not available.
  */
     open static var bundleIdentifier:String? = Bundle.main.infoDictionary?[kCFBundleIdentifierKey as String] as? String
     
 /**
- `valueCache` stores in memory the values known to all managers.  A previous key will used the cached value.
+ `valueCache` stores in memory the values known to all managers.  A previous key will used the cached value.  Reading
+   it copies every entry and assigning it replaces them all at once, racing with writers in between; use the methods
+   below instead.
+ */
+    @available(*, deprecated, message: "use cachedValue(for:), removeCachedValue(for:), or removeAllCachedValues()")
+    open static var valueCache:[RGMultiKey : Any] {
+        get {
+            RGLockbox.valueCacheLock.lock()
+            let values = RGLockbox.cachedValues
+            RGLockbox.valueCacheLock.unlock()
+            return values
+        }
+        set {
+            RGLockbox.valueCacheLock.lock()
+            for fullKey in Array(RGLockbox.cachedValues.keys) where newValue[fullKey] == nil {
+                RGLockbox.forgetCachedValue(fullKey)
+            }
+            RGLockbox.cachedValues = newValue
+            RGLockbox.advanceWriteEpoch()
+            RGLockbox.valueCacheLock.unlock()
+        }
+    }
+    
+/**
+ - returns: The cached value of `fullKey`: `Data`, `NSNull` for a cached miss, or `nil` if nothing is cached.
+ */
+    open static func cachedValue(for fullKey:RGMultiKey) -> Any? {
+        RGLockbox.valueCacheLock.lock()
+        let value = RGLockbox.cachedValues[fullKey]
+        RGLockbox.valueCacheLock.unlock()
+        return value
+    }
+    
+/**
+ Replaces the cached value of `fullKey` without writing the keychain, e.g. with a value another process wrote.
+ */
+    open static func setCachedValue(_ value:Data?, for fullKey:RGMultiKey) {
+        RGLockbox.valueCacheLock.lock()
+        RGLockbox.forgetCachedValue(fullKey)
+        RGLockbox.cachedValues[fullKey] = value ?? NSNull()
+        RGLockbox.advanceWriteEpoch()
+        RGLockbox.valueCacheLock.unlock()
+    }
+    
+/**
+ Drops the cached value of `fullKey` so that the next read goes to the keychain.
  */
-    open static var valueCache:[RGMultiKey : Any] = [:]
+    open static func removeCachedValue(for fullKey:RGMultiKey) {
+        RGLockbox.valueCacheLock.lock()
+        RGLockbox.forgetCachedValue(fullKey)
+        RGLockbox.advanceWriteEpoch()
+        RGLockbox.valueCacheLock.unlock()
+    }
+    
+/**
+ Drops every cached value so that every read goes to the keychain.
+ */
+    open static func removeAllCachedValues() {
+        RGLockbox.valueCacheLock.lock()
+        for fullKey in Array(RGLockbox.cachedValues.keys) {
+            RGLockbox.forgetCachedValue(fullKey)
+        }
+        RGLockbox.advanceWriteEpoch()
+        RGLockbox.valueCacheLock.unlock()
+    }
+    
+/**
+ Drops the entry of `fullKey` from `cachedValues` with its digest, access time, and expiry.  Must hold
+   `valueCacheLock`.
+ */
+    static func forgetCachedValue(_ fullKey:RGMultiKey) {
+        RGLockbox.cachedValues[fullKey] = nil
+        RGLockbox.valueDigests[fullKey] = nil
+        RGLockbox.lastAccess[fullKey] = nil
+        RGLockbox.trackExpiry(nil, forKey: fullKey)
+    }
+    
+/**
+ The storage behind `valueCache`.  Guarded by `valueCacheLock`.
+ */
+    static var cachedValues:[RGMultiKey : Any] = [:]
+    
+/**
+ Opt-in cross-process coherence.  When set, an entry in `valueCache` is only served while the generation of its bucket
+   is unchanged, and every write advances the generation of its bucket.  Share one table between an app and its
+   extensions to make writes in one process visible to the caches of the others.  Assigning it empties every thread
+   cache, since those are only filled while it is `nil`.
+ */
+    open static var generationTable:RGGenerationTable? {
+        didSet {
+            RGLockbox.valueCacheLock.lock()
+            RGLockbox.invalidateThreadCaches()
+            RGLockbox.valueCacheLock.unlock()
+        }
+    }
+    
+/**
+ The bucket generation observed when each entry of `valueCache` was loaded.  Guarded by `generationLock`.
+ */
+    static var valueGenerations:[RGMultiKey : Int64] = [:]
+    
+/**
+ This lock controls access to `valueGenerations`.  It is never held while waiting on `keychainQueue`.
+ */
+    static let generationLock = NSLock()
     
 /**
  Determines the service name used by the manager.
@@ -166,6 +345,11 @@ open class RGLockbox {
  */
     open let isSynchronized:Bool
     
+/**
+ Stores all of the manager's keys in a single keychain item.  See `RGLockbox+Packed.swift`.
+ */
+    open let isPacked:Bool
+    
 /**
  Creates a new `RGLockbox` instance with default namespace and item accessibility.  Should use `RGLockbox()` now.
  */
@@ -173,13 +357,37 @@ open class RGLockbox {
         return RGLockbox()
     }
     
+/**
+ Whether the cached entry for `fullKey` may be served.  Always `true` when `generationTable` is `nil`.
+ */
+    static func isCacheCurrent(_ fullKey:RGMultiKey) -> Bool {
+        guard let table = RGLockbox.generationTable else {
+            return true
+        }
+        let current = table.generation(for: fullKey)
+        RGLockbox.generationLock.lock()
+        let cached = RGLockbox.valueGenerations[fullKey]
+        RGLockbox.generationLock.unlock()
+        return cached == current
+    }
+    
+/**
+ Records the bucket generation a cached value corresponds to; `nil` forces the next read to revalidate.
+ */
+    static func recordGeneration(_ generation:Int64?, forKey fullKey:RGMultiKey) {
+        RGLockbox.generationLock.lock()
+        RGLockbox.valueGenerations[fullKey] = generation
+        RGLockbox.generationLock.unlock()
+    }
+    
 /**
  Registers for application state changes at the class level.
  */
     private static var onceToken:Any? = {
         let block = { (notification: Any) -> Void in
             RGLogs(.trace, "keychainQueue will flush")
-            RGLockbox.keychainQueue.sync(execute: {})
+            RGLockbox.flushPackedItems()
+            RGLockbox.saveWarmStartCache()
         }
         NotificationCenter.default.addObserver(forName: RGApplicationWillResignActive,
                                                object: nil,
@@ -193,6 +401,15 @@ open class RGLockbox {
                                                object: nil,
                                                queue: nil,
                                                using: block)
+        NotificationCenter.default.addObserver(forName: RGApplicationProtectedDataDidBecomeAvailable,
+                                               object: nil,
+                                               queue: nil,
+                                               using: { _ in RGLockbox.retryDeferredWrites() })
+        NotificationCenter.default.addObserver(forName: RGApplicationDidReceiveMemoryWarning,
+                                               object: nil,
+                                               queue: nil,
+                                               using: { _ in RGLockbox.purge(RGLockbox.memoryWarningPolicies) })
+        RGLockbox.memoryPressureSource.resume()
         return nil
     }()
     
@@ -203,19 +420,69 @@ open class RGLockbox {
  - parameter accountName: The manager's associated account if account qualified.
  - parameter accessGroup: The manager's associated accessGroup if restricted.
  - parameter synchronized: Whether this manager's writes will be marked synchronizable.
+ - parameter packed: Whether this manager keeps all of its keys in one keychain item.  Every manager of the same
+   namespace, account, and access group must agree.
  - returns: An instance of `RGLockbox` with the provided namespace and accessibility.
  */
     public required init(withNamespace namespace:String? = RGLockbox.bundleIdentifier,
                                        accessibility:CFString = kSecAttrAccessibleAfterFirstUnlock,
                                        accountName:String? = nil,
                                        accessGroup:String? = nil,
-                                       synchronized:Bool = false) {
+                                       synchronized:Bool = false,
+                                       packed:Bool = false) {
         RGLogs(.trace, "onceToken: \(RGLockbox.onceToken)")
         self.namespace = namespace
         self.itemAccessibility = accessibility
         self.accountName = accountName
         self.accessGroup = accessGroup
         self.isSynchronized = synchronized
+        self.isPacked = packed
+    }
+    
+/**
+ - parameter key: The key used to identify the item.
+ - returns: The key identifying the item in `valueCache` and the keychain for this manager.
+ */
+    func fullKey(for key:String) -> RGMultiKey {
+        let name = namespace != nil ? "\(namespace!).\(key)" : key
+        return RGMultiKey(withFirst: name, second: self.accountName, third: self.accessGroup)
+    }
+    
+/**
+ - parameter fullKey: The key of an item; `.first` must not be `nil`.
+ - returns: The attributes identifying the item in the keychain, matching both synchronizable and local items.
+ */
+    static func itemQuery(_ fullKey:RGMultiKey) -> [NSString:AnyObject] {
+        var query:[NSString:AnyObject] = [
+            kSecClass : kSecClassGenericPassword,
+            kSecAttrService : fullKey.first! as NSString,
+            kSecAttrSynchronizable : kSecAttrSynchronizableAny
+        ]
+        query[kSecAttrAccount] = fullKey.second as NSString?
+        query[kSecAttrAccessGroup] = fullKey.third as NSString?
+        return query
+    }
+    
+/**
+ - parameter fullKey: The key of an item.
+ - returns: The lock from `keyLocks` which orders writers of `fullKey`.
+ */
+    static func keyLock(for fullKey:RGMultiKey) -> NSLock {
+        return RGLockbox.keyLocks[Int(fullKey.stableHash % UInt64(RGLockbox.keyLocks.count))]
+    }
+    
+/**
+ Advances the bucket of `fullKey` in `generationTable` after a write.  The written value is only marked current if no
+   other writer advanced the bucket since `generation` was read.  Must be called on `keychainQueue`.
+ */
+    static func advanceGeneration(_ fullKey:RGMultiKey, from generation:Int64?) {
+        if let table = RGLockbox.generationTable, let generation = generation {
+            let next = table.advance(fullKey)
+            RGLockbox.recordGeneration(next == generation + 1 ? next : nil, forKey: fullKey)
+            if next == generation + 1 {
+                RGLockbox.advanceIndexedGeneration(fullKey, from: generation, to: next)
+            }
+        }
     }
     
 /**
@@ -225,46 +492,102 @@ open class RGLockbox {
  */
     @discardableResult
     public func dataForKey(_ key:String) -> Data? {
-        let name = namespace != nil ? "\(namespace!).\(key)" : key
-        let fullKey = RGMultiKey(withFirst: name, second: self.accountName, third: self.accessGroup)
+        return self.readData(forKey: key, range: nil)
+    }
+    
+/**
+ Ranged read access to the keychain.  Only the chunks covering `range` of a chunked value are read.
+ - parameter key: The key used to identify the item.
+ - parameter range: The byte offsets to return; clamped to the length of the value.
+ - returns: `Data` which is `nil` if not found.
+ */
+    public func dataForKey(_ key:String, range:Range<Int>) -> Data? {
+        return self.readData(forKey: key, range: range)
+    }
+    
+/**
+ Reads `range` of the value of `key`, or all of it if `range` is `nil`.
+ */
+    func readData(forKey key:String, range:Range<Int>?) -> Data? {
+        let fullKey = self.fullKey(for: key)
+        if range == nil, let cached = RGLockbox.threadCachedValue(for: fullKey) {
+            return cached
+        }
         RGLockbox.valueCacheLock.lock()
-        let value = RGLockbox.valueCache[fullKey]
-        if value != nil {
+        RGLockbox.recordAccess(fullKey)
+        let value = RGLockbox.cachedValues[fullKey]
+        if value != nil && RGLockbox.isCacheCurrent(fullKey) {
+            let liveValue = RGLockbox.liveValue(value!, forKey: fullKey, range: range)
+            if range == nil {
+                RGLockbox.fillThreadCache(value!, forKey: fullKey)
+            }
+            RGLockbox.valueCacheLock.unlock()
+            RGLogs(.trace, "returning prematurely for key \(key) and value \(liveValue)")
+            return liveValue
+        }
+        if self.isPacked {
+            let liveValue = self.packedValue(forKey: key, fullKey: fullKey, range: range)
             RGLockbox.valueCacheLock.unlock()
-            RGLogs(.trace, "returning prematurely for key \(key) and value \(value)")
-            return value is Data ? (value as! Data) : nil
+            return liveValue
+        }
+        if !RGLockbox.mayContain(fullKey) {
+            RGLockbox.valueCacheLock.unlock()
+            RGLogs(.trace, "membership filter rules out key \(key)")
+            return nil
         }
         var data:AnyObject? = nil
-        RGLockbox.keychainQueue.sync(execute: {
+        var status = errSecSuccess
+        RGLockbox.enqueueAndWait(keys: [ fullKey ], execute: {
             RGLogs(.trace, "hit sync with key \(key)")
-            var query:[NSString:AnyObject] = [
-                kSecClass : kSecClassGenericPassword,
-                kSecAttrService : fullKey.first! as NSString,
-                kSecMatchLimit : kSecMatchLimitOne,
-                kSecReturnData : true as NSNumber,
-                kSecAttrSynchronizable : kSecAttrSynchronizableAny
-            ]
-            query[kSecAttrAccount] = fullKey.second as NSString?
-            query[kSecAttrAccessGroup] = fullKey.third as NSString?
-            let status = rg_SecItemCopyMatch(query as NSDictionary, &data)
+            var query = RGLockbox.itemQuery(fullKey)
+            query[kSecMatchLimit] = kSecMatchLimitOne
+            query[kSecReturnData] = true as NSNumber
+            query[kSecReturnAttributes] = true as NSNumber
+            let generation = RGLockbox.generationTable?.generation(for: fullKey)
+            status = RGLockbox.watchedCopyMatching(query as NSDictionary, &data)
             RGLogs(.trace, "SecItemCopyMatching with \(query) returned \(status)")
+            RGLockbox.recordGeneration(generation, forKey: fullKey)
         })
-        let bridgedData = data as! Data?
-        RGLockbox.valueCache[fullKey] = bridgedData != nil ? bridgedData : NSNull()
+        if let pending = RGLockbox.deferredWrite(for: fullKey) {
+            RGLockbox.cachedValues[fullKey] = RGLockbox.cacheEntry(for: pending.data, isReference: pending.isReference)
+            RGLockbox.trackExpiry(pending.data != nil ? pending.expiry : nil, forKey: fullKey)
+            let liveValue = RGLockbox.liveValue(RGLockbox.cachedValues[fullKey]!, forKey: fullKey, range: range)
+            RGLockbox.valueCacheLock.unlock()
+            return liveValue
+        } else if status == errSecInteractionNotAllowed {
+            RGLockbox.valueCacheLock.unlock()
+            RGLogs(.warning, "keychain unavailable reading \(key), change itemAccessibility")
+            return nil
+        }
+        let item = RGLockbox.decodedItem(data as? Dictionary<String, Any>)
+        let bridgedData = item?[kSecValueData as String] as? Data
+        RGLockbox.cachedValues[fullKey] = RGLockbox.cacheEntry(for: bridgedData,
+                                                               isReference: RGLockbox.isReferenceItem(item))
+        RGLockbox.valueDigests[fullKey] = RGContentDigest(attributes: item)
+        RGLockbox.trackExpiry(RGLockbox.expiry(fromAttributes: item), forKey: fullKey)
+        let liveValue = RGLockbox.liveValue(RGLockbox.cachedValues[fullKey]!, forKey: fullKey, range: range)
         RGLockbox.valueCacheLock.unlock()
-        return bridgedData
+        return liveValue
     }
     
 /**
  Returns a list of keys which describe what items are visible to this manager qualified by its `.namespace`,
-   `.accountName`, and `.accessGroup`.  Caches anything it finds to `valueCache`.
+   `.accountName`, and `.accessGroup`.  Caches anything it finds to `valueCache` and indexes it for
+   `keys(withPrefix:)`.  Expired items are omitted.  See `RGLockbox+Enumeration.swift`.
  */
     public func allItems() -> Array<String> {
-        var fullKey = RGMultiKey(second: self.accountName, third: self.accessGroup)
+        if self.isPacked {
+            return self.allPackedItems()
+        }
+        let scope = RGMultiKey(second: self.accountName, third: self.accessGroup)
         var data:AnyObject? = nil
-        RGLockbox.valueCacheLock.lock()
-        RGLockbox.keychainQueue.sync(execute: {
+        var generations:[Int64]? = nil
+        let epoch = RGLockbox.currentWriteEpoch()
+        RGLockbox.enqueueAndWait(execute: {
             RGLogs(.trace, "hit sync with fetch all")
+            if let table = RGLockbox.generationTable {
+                generations = (0 ..< table.bucketCount).map({ table.generation(atBucket: $0) })
+            }
             var query:[NSString:AnyObject] = [
                 kSecClass : kSecClassGenericPassword,
                 kSecMatchLimit : kSecMatchLimitAll,
@@ -272,63 +595,295 @@ open class RGLockbox {
                 kSecReturnData : true as NSNumber,
                 kSecAttrSynchronizable : kSecAttrSynchronizableAny
             ]
-            query[kSecAttrAccount] = fullKey.second as NSString?
-            query[kSecAttrAccessGroup] = fullKey.third as NSString?
-            let status = rg_SecItemCopyMatch(query as NSDictionary, &data)
+            query[kSecAttrAccount] = scope.second as NSString?
+            query[kSecAttrAccessGroup] = scope.third as NSString?
+            let status = RGLockbox.watchedCopyMatching(query as NSDictionary, &data)
             RGLogs(.trace, "SecItemCopyMatching with \(query) returned \(status)")
         })
-        let items = data as? Array<Dictionary<String, Any>>
-        var output:Array<String> = []
-        for item in items ?? [] {
-            let service = item[kSecAttrService as String]
-            if let service = service {
-                let serviceName = (service as! String)
-                fullKey.first = serviceName
-                if self.namespace == nil {
-                    output.append(serviceName)
-                } else if serviceName.hasPrefix("\(self.namespace!).") {
-                    let range = serviceName.range(of: "\(self.namespace!).")
-                    output.append(serviceName.substring(from: range!.upperBound))
+        let items = RGLockbox.decodeEnumeration((data as? NSArray) ?? [], scope: scope, namespace: self.namespace)
+        RGLockbox.cacheEnumeration(items, since: epoch)
+        RGLockbox.indexEnumeration(items, scope: scope, generations: generations, since: epoch)
+        return items.flatMap({ $0?.name })
+    }
+    
+/**
+ Raw write access to keychain.  Caches writes to `valueCache`.
+ - parameter data: The data to store on the given key.  If `nil` clears the value in the keychain.
+ - parameter key: The identifier of the keychain item.
+ */
+    public func setData(_ data:Data?, forKey key:String) {
+        self.setData(data, forKey: key, expiry: nil)
+    }
+    
+/**
+ Writes `data` in order with the other writers of `key`.
+ - parameter data: The data to store on the given key.  If `nil` clears the value in the keychain.
+ - parameter key: The identifier of the keychain item.
+ - parameter expiry: When the item should start reading as absent, `nil` if it never expires.
+ */
+    func setData(_ data:Data?, forKey key:String, expiry:Date?) {
+        let fullKey = self.fullKey(for: key)
+        let keyLock = RGLockbox.keyLock(for: fullKey)
+        keyLock.lock()
+        self.store(data, forKey: key, fullKey: fullKey, expiry: expiry)
+        keyLock.unlock()
+    }
+    
+/**
+ Atomically replaces the value of `key` with the result of `transform`.  Other writers of the same key are ordered
+   before or after the whole read-modify-write; writers of other keys are not blocked.  `transform` runs without any
+   lock held and the result is only stored if `key` still holds the value it was given, otherwise it runs again with the
+   newer value.  At most one keychain write is issued and none if the value is unchanged.  Any time to live on the item
+   is cleared when it is rewritten.
+ - parameter key: The identifier of the keychain item.
+ - parameter transform: Receives the current value, `nil` if absent, and returns the new value or `nil` to remove it.
+   It may run more than once.  It may write other keys but must not write to `key` itself.
+ - returns: The value returned by `transform`.
+ */
+    @discardableResult
+    public func update(forKey key:String, _ transform:(Data?) -> Data?) -> Data? {
+        let fullKey = self.fullKey(for: key)
+        let keyLock = RGLockbox.keyLock(for: fullKey)
+        var current = self.dataForKey(key)
+        while true {
+            let updated = transform(current)
+            keyLock.lock()
+            let latest = self.dataForKey(key)
+            if latest == current {
+                if updated != current {
+                    self.store(updated, forKey: key, fullKey: fullKey, expiry: nil)
                 }
+                keyLock.unlock()
+                return updated
+            }
+            keyLock.unlock()
+            current = latest
+        }
+    }
+    
+/**
+ Writes every value of `items` with a single hop to `keychainQueue`.  Each key is ordered with its other writers as by
+   `setData(_:forKey:)`.
+ - parameter items: The data to store by key.
+ */
+    public func setItems(_ items:[String : Data]) {
+        self.storeBatch(items.map({ ($0.key, $0.value, nil) }))
+    }
+    
+/**
+ Writes a batch of values, each with an optional expiry, with a single hop to `keychainQueue`.
+ */
+    @discardableResult
+    func storeBatch(_ entries:[(String, Data?, Date?)], policy:RGBacklogPolicy = RGLockbox.writeBacklogPolicy) -> Bool {
+        return RGLockbox.storeBatch(entries.map({ (self, $0.0, $0.1, $0.2) }), policy: policy)
+    }
+    
+/**
+ Writes a batch of values for any number of managers with a single hop to `keychainQueue`.  The writes reach the
+   keychain in the order of `entries`.
+ - returns: `false` if the batch was refused under `RGBacklogPolicy.failFast`.
+ */
+    @discardableResult
+    static func storeBatch(_ entries:[(RGLockbox, String, Data?, Date?)],
+                           policy:RGBacklogPolicy = RGLockbox.writeBacklogPolicy) -> Bool {
+        let fullKeys = entries.map({ $0.0.fullKey(for: $0.1) })
+        let queued = entries.indices.filter({ !entries[$0].0.isPacked })
+        let admission = RGLockbox.admitWrites(queued.map({ fullKeys[$0] }),
+                                              bytes: queued.reduce(0, { $0 + (entries[$1].2?.count ?? 0) }),
+                                              policy: policy)
+        if admission == .reject {
+            RGLogs(.warning, "write backlog is full, refusing a batch of \(entries.count) writes")
+            return false
+        }
+        let stripes = Set(fullKeys.map({ Int($0.stableHash % UInt64(RGLockbox.keyLocks.count)) })).sorted()
+        for stripe in stripes {
+            RGLockbox.keyLocks[stripe].lock()
+        }
+        let digests = entries.map({ RGContentDigest($0.2,
+                                                    accessibility: $0.0.itemAccessibility as String,
+                                                    synchronized: $0.0.isSynchronized) })
+        let envelopes = entries.enumerated().map({ (index, entry) -> RGEnvelope? in
+            return entry.0.isPacked ? nil : entry.0.sealEnvelope(entry.2, digest: digests[index])
+        })
+        RGLockbox.valueCacheLock.lock()
+        var work:[() -> Void] = []
+        var stagedKeys:[RGMultiKey] = []
+        for (index, entry) in entries.enumerated() {
+            if entry.0.isPacked {
+                entry.0.storePacked(entry.2, forKey: entry.1, fullKey: fullKeys[index], expiry: entry.3)
+            } else if let staged = entry.0.stage(entry.2,
+                                                 digest: digests[index],
+                                                 forKey: fullKeys[index],
+                                                 expiry: entry.3,
+                                                 envelope: envelopes[index],
+                                                 spill: admission == .spill) {
+                work.append(staged)
+                stagedKeys.append(fullKeys[index])
+            } else if let envelope = envelopes[index] {
+                RGLockbox.removeEnvelope(envelope)
             }
-            let contents = item[kSecValueData as String] as? NSData
-            RGLockbox.valueCache[fullKey] = contents != nil ? contents : NSNull()
+        }
+        if work.count > 0 {
+            RGLockbox.enqueue(keys: stagedKeys, execute: {
+                for staged in work {
+                    staged()
+                }
+            })
         }
         RGLockbox.valueCacheLock.unlock()
-        return output
+        for stripe in stripes.reversed() {
+            RGLockbox.keyLocks[stripe].unlock()
+        }
+        return true
     }
     
 /**
- Raw write access to keychain.  Caches writes to `valueCache`.
- - parameter data: The data to store on the given key.  If `nil` clears the value in the keychain.
+ Caches the write to `valueCache` and schedules it on `keychainQueue` unless the item already holds `data`.  Must hold
+   the `keyLock(for:)` of `fullKey`.  See `stage(_:digest:forKey:expiry:)`.
  - parameter key: The identifier of the keychain item.
+ - parameter fullKey: The result of `fullKey(for: key)`.
+ - parameter policy: What to do when the write backlog is full.
+ - returns: `false` if the write was refused under `RGBacklogPolicy.failFast`.
  */
-    public func setData(_ data:Data?, forKey key:String) {
-        let name = namespace != nil ? "\(namespace!).\(key)" : key
-        let fullKey = RGMultiKey(withFirst: name, second: self.accountName, third: self.accessGroup)
+    @discardableResult
+    func store(_ data:Data?, forKey key:String, fullKey:RGMultiKey, expiry:Date?,
+               policy:RGBacklogPolicy = RGLockbox.writeBacklogPolicy) -> Bool {
+        if self.isPacked {
+            RGLockbox.valueCacheLock.lock()
+            self.storePacked(data, forKey: key, fullKey: fullKey, expiry: expiry)
+            RGLockbox.valueCacheLock.unlock()
+            return true
+        }
+        let admission = RGLockbox.admitWrites([ fullKey ], bytes: data?.count ?? 0, policy: policy)
+        if admission == .reject {
+            RGLogs(.warning, "write backlog is full, refusing write of \(key)")
+            return false
+        }
+        let digest = RGContentDigest(data,
+                                     accessibility: self.itemAccessibility as String,
+                                     synchronized: self.isSynchronized)
+        let envelope = self.sealEnvelope(data, digest: digest)
         RGLockbox.valueCacheLock.lock()
-        RGLockbox.valueCache[fullKey] = ((data != nil) ? data : NSNull())
-        RGLockbox.keychainQueue.async(execute: {
-            RGLogs(.trace, "key is \(fullKey.first) with data \(data)")
-            var query:[NSString:AnyObject] = [
-                kSecClass : kSecClassGenericPassword,
-                kSecAttrService : fullKey.first! as NSString,
-                kSecAttrSynchronizable : kSecAttrSynchronizableAny
+        if let work = self.stage(data,
+                                 digest: digest,
+                                 forKey: fullKey,
+                                 expiry: expiry,
+                                 envelope: envelope,
+                                 spill: admission == .spill) {
+            RGLockbox.enqueue(keys: [ fullKey ], execute: work)
+        } else if let envelope = envelope {
+            RGLockbox.removeEnvelope(envelope)
+        }
+        RGLockbox.valueCacheLock.unlock()
+        return true
+    }
+    
+/**
+ Caches a write to `valueCache`.  Must hold `valueCacheLock` and the `keyLock(for:)` of `fullKey`.
+ - parameter digest: The `RGContentDigest` of `data` as written by this manager.
+ - parameter envelope: The result of `sealEnvelope(_:digest:)` for `data`.
+ - parameter spill: Whether to park the write instead of queueing it, see `RGBacklogPolicy.spill`.
+ - returns: The keychain work to run on `keychainQueue`, `nil` if the item already holds `data` or the write was folded
+   into a queued one or parked.
+ */
+    func stage(_ data:Data?, digest:RGContentDigest, forKey fullKey:RGMultiKey, expiry:Date?,
+               envelope:RGEnvelope? = nil, spill:Bool = false) -> (() -> Void)? {
+        RGLockbox.advanceWriteEpoch()
+        RGLockbox.recordAccess(fullKey)
+        if expiry == nil && RGLockbox.isUnchanged(data, digest: digest, forKey: fullKey) {
+            RGLockbox.elidedWrites += 1
+            if !(RGLockbox.cachedValues[fullKey] is RGValueReference) {
+                RGLockbox.cachedValues[fullKey] = ((data != nil) ? data : NSNull())
+            }
+            RGLogs(.trace, "eliding unchanged write for key \(fullKey.first)")
+            return nil
+        }
+        if data != nil {
+            RGLockbox.recordMembership(fullKey)
+        }
+        RGLockbox.recordIndexedKey(fullKey, isPresent: data != nil)
+        let previous = RGLockbox.cachedValues[fullKey] as? RGValueReference
+        var staged:(() -> Void)? = nil
+        if let envelope = envelope {
+            staged = self.stageEnvelope(envelope, forKey: fullKey, digest: digest, expiry: expiry, replacing: previous)
+        } else if let data = data, data.count > RGLockbox.chunkSize {
+            staged = self.stageChunks(data, forKey: fullKey, digest: digest, expiry: expiry, replacing: previous)
+        }
+        if let staged = staged {
+            let pending = RGLockbox.trackPendingWrite(fullKey, write: nil, bytes: envelope != nil ? 0 : data!.count)
+            return {
+                _ = RGLockbox.startPendingWrite(pending)
+                staged()
+                RGLockbox.finishPendingWrite(pending)
+            }
+        }
+        RGLockbox.cachedValues[fullKey] = ((data != nil) ? data : NSNull())
+        RGLockbox.valueDigests[fullKey] = digest
+        RGLockbox.trackExpiry(data != nil ? expiry : nil, forKey: fullKey)
+        let write = RGItemWrite(fullKey: fullKey,
+                                data: data,
+                                accessibility: self.itemAccessibility,
+                                isSynchronized: self.isSynchronized,
+                                expiry: expiry,
+                                updatesInPlace: false,
+                                isReference: false)
+        if RGLockbox.supersedePendingWrite(write) || (spill && RGLockbox.spillWrite(write)) {
+            return nil
+        }
+        let pending = RGLockbox.trackPendingWrite(fullKey, write: write, bytes: data?.count ?? 0)
+        return {
+            RGLockbox.perform(RGLockbox.startPendingWrite(pending)!)
+            if let previous = previous, RGLockbox.deferredWrite(for: fullKey) == nil {
+                RGLockbox.removeStorage(of: previous, forKey: fullKey)
+            }
+            RGLockbox.finishPendingWrite(pending)
+        }
+    }
+    
+/**
+ Replaces the keychain item described by `write`.  Must be called on `keychainQueue`.
+ - returns: `errSecSuccess`, or the status of the first keychain call which could not proceed.
+ */
+    @discardableResult
+    static func commit(_ write:RGItemWrite) -> OSStatus {
+        let fullKey = write.fullKey
+        RGLogs(.trace, "key is \(fullKey.first) with data \(write.data)")
+        var query = RGLockbox.itemQuery(fullKey)
+        let generation = RGLockbox.generationTable?.generation(for: fullKey)
+        if write.updatesInPlace, let data = write.data {
+            let attributes:[NSString:AnyObject] = [
+                kSecValueData : RGLockbox.encodeValue(data) as NSData,
+                kSecAttrAccessible : write.accessibility,
+                kSecAttrType : NSNumber(value: write.isReference ? RGLockbox.referenceItemType : 0)
             ]
-            query[kSecAttrAccount] = fullKey.second as NSString?
-            query[kSecAttrAccessGroup] = fullKey.third as NSString?
-            var status = rg_SecItemDelete(query as NSDictionary)
-            RGLogs(.trace, "SecItemDelete with \(query) returned \(status)")
-            assert(status != errSecInteractionNotAllowed, "Keychain item unavailable, change itemAccessibility")
-            if let data = data {
-                query[kSecValueData] = data as NSData
-                query[kSecAttrAccessible] = self.itemAccessibility
-                query[kSecAttrSynchronizable] = self.isSynchronized as NSNumber
-                status = rg_SecItemAdd(query as NSDictionary)
-                RGLogs(.trace, "SecItemAdd with \(query) returned \(status)")
-                assert(status != errSecInteractionNotAllowed, "Keychain item unavailable, change itemAccessibility")
+            let status = RGLockbox.watchedUpdate(query as NSDictionary, attributes as NSDictionary)
+            RGLogs(.trace, "SecItemUpdate with \(query) returned \(status)")
+            if status == errSecSuccess {
+                RGLockbox.advanceGeneration(fullKey, from: generation)
             }
-        })
-        RGLockbox.valueCacheLock.unlock()
+            if status == errSecSuccess || status == errSecInteractionNotAllowed {
+                return status
+            }
+        }
+        var status = RGLockbox.watchedDelete(query as NSDictionary)
+        RGLogs(.trace, "SecItemDelete with \(query) returned \(status)")
+        if status == errSecInteractionNotAllowed {
+            return status
+        }
+        status = errSecSuccess
+        if let data = write.data {
+            query[kSecValueData] = RGLockbox.encodeValue(data) as NSData
+            query[kSecAttrAccessible] = write.accessibility
+            query[kSecAttrSynchronizable] = write.isSynchronized as NSNumber
+            query[kSecAttrGeneric] = RGLockbox.expiryAttribute(write.expiry) as NSData?
+            query[kSecAttrType] = write.isReference ? NSNumber(value: RGLockbox.referenceItemType) : nil
+            status = RGLockbox.watchedAdd(query as NSDictionary)
+            RGLogs(.trace, "SecItemAdd with \(query) returned \(status)")
+            if status == errSecInteractionNotAllowed {
+                return status
+            }
+        }
+        RGLockbox.advanceGeneration(fullKey, from: generation)
+        return status
     }
 }
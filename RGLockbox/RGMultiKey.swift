@@ -70,4 +70,19 @@ public struct RGMultiKey: Hashable {
     public static func == (lhs: RGMultiKey, rhs: RGMultiKey) -> Bool {
         return lhs.first == rhs.first && lhs.second == rhs.second && lhs.third == rhs.third
     }
+    
+/**
+ A 64-bit FNV-1a hash of the UTF-8 bytes of `first`, `second`, and `third`.  Unlike `hashValue` this is stable across
+   processes and launches so it may be persisted or shared through memory-mapped files.
+ */
+    public var stableHash: UInt64 {
+        var hash:UInt64 = 0xcbf29ce484222325
+        for component in [ self.first, self.second, self.third ] {
+            for byte in (component ?? "").utf8 {
+                hash = (hash ^ UInt64(byte)) &* 0x100000001b3
+            }
+            hash = (hash ^ (component == nil ? 0xfe : 0xff)) &* 0x100000001b3
+        }
+        return hash
+    }
 }
@@ -0,0 +1,284 @@
+/* Copyright (c) 10/17/2026, Ryan Dignard
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright notice, this
+list of conditions and the following disclaimer.
+2. Redistributions in binary form must reproduce the above copyright notice,
+this list of conditions and the following disclaimer in the documentation
+and/or other materials provided with the distribution.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR
+ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+(INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+(INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE. */
+
+import Foundation
+
+/**
+ `RGTimingWheel` is a hierarchical timing wheel of keys.  Each level holds `slotsPerLevel` slots and every slot of a
+   level spans `slotsPerLevel` times as many ticks as a slot of the level below it.  Keys due far in the future wait in
+   coarse slots and cascade towards level 0 as time advances, so expiring is O(1) regardless of how many keys are
+   outstanding.  A min-heap of deadlines beside the wheel answers `nextDeadline`, which makes scheduling O(log n).  Not
+   threadsafe; callers provide their own locking.
+ */
+open class RGTimingWheel {
+    
+/**
+ The duration of one tick.  Deadlines are rounded up to a whole tick so a key never expires early.
+ */
+    open let tickInterval:TimeInterval
+    
+/**
+ The number of slots on each level.
+ */
+    open let slotsPerLevel:Int
+    
+/**
+ The number of levels; deadlines beyond the top level's span are parked on the top level and cascade again.
+ */
+    open let levels:Int
+    
+/**
+ Tick 0 of the wheel.
+ */
+    open let origin:Date
+    
+/**
+ The last tick processed by `advance(to:)`.
+ */
+    private var currentTick:Int64 = 0
+    
+/**
+ `slots[level][slot]` holds the keys waiting in that slot.  Cancelled or rescheduled keys are dropped lazily.
+ */
+    private var slots:[[Set<RGMultiKey>]]
+    
+/**
+ The deadline tick of every scheduled key.
+ */
+    private var deadlines:[RGMultiKey : Int64] = [:]
+    
+/**
+ A binary min-heap of deadline ticks.  An entry whose key is no longer scheduled at its tick is dropped lazily when it
+   reaches the top, and the heap is rebuilt from `deadlines` once most of it is such entries.
+ */
+    private var heap:[(tick:Int64, key:RGMultiKey)] = []
+    
+/**
+ A new, empty wheel.
+ - parameter tickInterval: The resolution of the wheel in seconds.
+ - parameter slotsPerLevel: The fan out of every level.
+ - parameter levels: The number of levels.
+ - parameter origin: The time of tick 0, usually now.
+ */
+    public init(tickInterval:TimeInterval = 1, slotsPerLevel:Int = 64, levels:Int = 4, origin:Date = Date()) {
+        precondition(tickInterval > 0 && slotsPerLevel > 1 && levels > 0, "invalid timing wheel geometry")
+        self.tickInterval = tickInterval
+        self.slotsPerLevel = slotsPerLevel
+        self.levels = levels
+        self.origin = origin
+        self.slots = RGTimingWheel.emptySlots(slotsPerLevel, levels)
+    }
+    
+/**
+ The number of keys currently scheduled.
+ */
+    open var count:Int {
+        return self.deadlines.count
+    }
+    
+/**
+ The earliest deadline of a scheduled key rounded up to its tick, `nil` if nothing is scheduled.
+ */
+    open var nextDeadline:Date? {
+        while let top = self.heap.first, self.deadlines[top.key] != top.tick {
+            self.popHeap()
+        }
+        guard let tick = self.heap.first?.tick else {
+            return nil
+        }
+        return self.origin.addingTimeInterval(TimeInterval(tick) * self.tickInterval)
+    }
+    
+/**
+ Schedules `key` to expire at `deadline`, replacing any previous deadline for it.
+ - returns: The time `advance(to:)` first returns `key`.
+ */
+    @discardableResult
+    open func schedule(_ key:RGMultiKey, at deadline:Date) -> Date {
+        let tick = Swift.max(Int64(ceil(deadline.timeIntervalSince(self.origin) / self.tickInterval)),
+                             self.currentTick + 1)
+        self.deadlines[key] = tick
+        self.insert(key, at: tick)
+        self.pushHeap(tick, key)
+        return self.origin.addingTimeInterval(TimeInterval(tick) * self.tickInterval)
+    }
+    
+/**
+ Removes `key` from the wheel if it is scheduled.
+ */
+    open func cancel(_ key:RGMultiKey) {
+        self.deadlines[key] = nil
+    }
+    
+/**
+ Moves the wheel forward to `date`.
+ - returns: Every key whose deadline is at or before `date`; they are no longer scheduled.
+ */
+    open func advance(to date:Date) -> [RGMultiKey] {
+        let target = Int64(floor(date.timeIntervalSince(self.origin) / self.tickInterval))
+        var expired:[RGMultiKey] = []
+        if target - self.currentTick > self.span {
+            for (key, tick) in self.deadlines where tick <= target {
+                expired.append(key)
+            }
+            for key in expired {
+                self.deadlines[key] = nil
+            }
+            self.currentTick = target
+            self.slots = RGTimingWheel.emptySlots(self.slotsPerLevel, self.levels)
+            for (key, tick) in self.deadlines {
+                self.insert(key, at: tick)
+            }
+            return expired
+        }
+        while self.currentTick < target {
+            self.currentTick += 1
+            self.cascade()
+            let slot = Int(self.currentTick % Int64(self.slotsPerLevel))
+            let keys = self.slots[0][slot]
+            self.slots[0][slot].removeAll()
+            for key in keys {
+                if let tick = self.deadlines[key], tick <= self.currentTick {
+                    self.deadlines[key] = nil
+                    expired.append(key)
+                }
+            }
+        }
+        return expired
+    }
+    
+/**
+ The number of ticks covered by the whole wheel.
+ */
+    private var span:Int64 {
+        var span:Int64 = 1
+        for _ in 0..<self.levels {
+            span *= Int64(self.slotsPerLevel)
+        }
+        return span
+    }
+    
+/**
+ Places `key` on the lowest level whose range covers the distance to `tick`.
+ */
+    private func insert(_ key:RGMultiKey, at tick:Int64) {
+        let delta = tick - self.currentTick
+        let fanOut = Int64(self.slotsPerLevel)
+        var level = 0
+        var slotSpan:Int64 = 1
+        while level < self.levels - 1 && delta >= slotSpan * fanOut {
+            slotSpan *= fanOut
+            level += 1
+        }
+        self.slots[level][Int((tick / slotSpan) % fanOut)].insert(key)
+    }
+    
+/**
+ Redistributes the slots of the higher levels which begin at `currentTick`, highest level first.
+ */
+    private func cascade() {
+        let fanOut = Int64(self.slotsPerLevel)
+        var level = self.levels - 1
+        while level > 0 {
+            var slotSpan:Int64 = 1
+            for _ in 0..<level {
+                slotSpan *= fanOut
+            }
+            if self.currentTick % slotSpan == 0 {
+                let slot = Int((self.currentTick / slotSpan) % fanOut)
+                let keys = self.slots[level][slot]
+                self.slots[level][slot].removeAll()
+                for key in keys {
+                    if let tick = self.deadlines[key] {
+                        self.insert(key, at: tick)
+                    }
+                }
+            }
+            level -= 1
+        }
+    }
+    
+/**
+ Adds the deadline `tick` of `key` to `heap`, first rebuilding it when stale entries outnumber scheduled keys.
+ */
+    private func pushHeap(_ tick:Int64, _ key:RGMultiKey) {
+        if self.heap.count > 64 && self.heap.count > 2 * self.deadlines.count {
+            self.heap = self.deadlines.map({ (tick: $0.value, key: $0.key) })
+            var index = self.heap.count / 2
+            while index > 0 {
+                index -= 1
+                self.siftDown(index)
+            }
+            return
+        }
+        self.heap.append((tick, key))
+        var index = self.heap.count - 1
+        while index > 0 {
+            let parent = (index - 1) / 2
+            if self.heap[parent].tick <= self.heap[index].tick {
+                break
+            }
+            let entry = self.heap[parent]
+            self.heap[parent] = self.heap[index]
+            self.heap[index] = entry
+            index = parent
+        }
+    }
+    
+/**
+ Removes the top of `heap`.
+ */
+    private func popHeap() {
+        let last = self.heap.removeLast()
+        if self.heap.count > 0 {
+            self.heap[0] = last
+            self.siftDown(0)
+        }
+    }
+    
+    private func siftDown(_ start:Int) {
+        var index = start
+        while true {
+            var smallest = index
+            for child in [ 2 * index + 1, 2 * index + 2 ] where child < self.heap.count {
+                if self.heap[child].tick < self.heap[smallest].tick {
+                    smallest = child
+                }
+            }
+            if smallest == index {
+                return
+            }
+            let entry = self.heap[smallest]
+            self.heap[smallest] = self.heap[index]
+            self.heap[index] = entry
+            index = smallest
+        }
+    }
+    
+/**
+ - returns: `levels` levels of `slotsPerLevel` empty slots.
+ */
+    private static func emptySlots(_ slotsPerLevel:Int, _ levels:Int) -> [[Set<RGMultiKey>]] {
+        return Array(repeating: Array(repeating: Set<RGMultiKey>(), count: slotsPerLevel), count: levels)
+    }
+}